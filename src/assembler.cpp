@@ -0,0 +1,796 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "assembler.hpp"
+#include <cctype>
+#include <cstdlib>
+#include <map>
+
+namespace {
+    typedef enum {
+        D_LOAD_STORE, // rt, d(ra)
+        D_SIGNED, // rt, ra, si
+        D_UNSIGNED, // ra, rs, ui
+        COMPARE_IMMEDIATE, // bf, [l,] ra, si or ui
+        COMPARE, // bf, [l,] ra, rb
+        X_RT_RA_RB, // rt, ra, rb, also lswi and stswi with NB and tw with TO
+        XO_RT_RA_RB, // rt, ra, rb
+        XO_RT_RA, // rt, ra
+        X_RA_RS_RB, // ra, rs, rb
+        X_RA_RS, // ra, rs
+        X_RA_RS_SH, // ra, rs, sh
+        M_ROTATE, // ra, rs, sh or rb, mb, me
+        MOVE_FROM_CR, // rt
+        MOVE_TO_CR, // fxm, rs
+        MOVE_FROM_SPR, // rt, spr
+        MOVE_TO_SPR, // spr, rs
+        I_BRANCH, // target
+        B_BRANCH, // bo, bi, target
+        XL_BRANCH, // bo, bi [, bh]
+        XL_CONDITION, // bt, ba, bb
+        MOVE_CR_FIELD, // bf, bfa
+        SYSTEM_CALL // [lev]
+    } form_t;
+
+    const uint8_t RC = 1 << 0; // Has a record form with '.'
+    const uint8_t OE = 1 << 1; // Has an overflow enabling form with 'o'
+    const uint8_t SIGNED_IMMEDIATE = 1 << 2;
+
+    typedef struct {
+        const char *mnemonic;
+        form_t form;
+        uint32_t code; // Instruction with all operand fields zero
+        uint8_t flags;
+    } instruction_t;
+
+    constexpr uint32_t primary(uint32_t opcode) {
+        return opcode << 26;
+    }
+
+    constexpr uint32_t extended(uint32_t opcode, uint32_t xo) {
+        return opcode << 26 | xo << 1;
+    }
+
+    const instruction_t INSTRUCTIONS[] = {
+        {"lwz", D_LOAD_STORE, primary(32), 0}, {"lwzu", D_LOAD_STORE, primary(33), 0},
+        {"lbz", D_LOAD_STORE, primary(34), 0}, {"lbzu", D_LOAD_STORE, primary(35), 0},
+        {"stw", D_LOAD_STORE, primary(36), 0}, {"stwu", D_LOAD_STORE, primary(37), 0},
+        {"stb", D_LOAD_STORE, primary(38), 0}, {"stbu", D_LOAD_STORE, primary(39), 0},
+        {"lhz", D_LOAD_STORE, primary(40), 0}, {"lhzu", D_LOAD_STORE, primary(41), 0},
+        {"lha", D_LOAD_STORE, primary(42), 0}, {"lhau", D_LOAD_STORE, primary(43), 0},
+        {"sth", D_LOAD_STORE, primary(44), 0}, {"sthu", D_LOAD_STORE, primary(45), 0},
+        {"lmw", D_LOAD_STORE, primary(46), 0}, {"stmw", D_LOAD_STORE, primary(47), 0},
+
+        {"twi", D_SIGNED, primary(3), 0}, {"mulli", D_SIGNED, primary(7), 0},
+        {"subfic", D_SIGNED, primary(8), 0}, {"addic", D_SIGNED, primary(12), 0},
+        {"addic.", D_SIGNED, primary(13), 0}, {"addi", D_SIGNED, primary(14), 0},
+        {"addis", D_SIGNED, primary(15), 0},
+
+        {"ori", D_UNSIGNED, primary(24), 0}, {"oris", D_UNSIGNED, primary(25), 0},
+        {"xori", D_UNSIGNED, primary(26), 0}, {"xoris", D_UNSIGNED, primary(27), 0},
+        {"andi.", D_UNSIGNED, primary(28), 0}, {"andis.", D_UNSIGNED, primary(29), 0},
+
+        {"cmpli", COMPARE_IMMEDIATE, primary(10), 0}, {"cmpi", COMPARE_IMMEDIATE, primary(11), SIGNED_IMMEDIATE},
+        {"cmp", COMPARE, extended(31, 0), 0}, {"cmpl", COMPARE, extended(31, 32), 0},
+
+        {"lwzx", X_RT_RA_RB, extended(31, 23), 0}, {"lwzux", X_RT_RA_RB, extended(31, 55), 0},
+        {"lbzx", X_RT_RA_RB, extended(31, 87), 0}, {"lbzux", X_RT_RA_RB, extended(31, 119), 0},
+        {"lhzx", X_RT_RA_RB, extended(31, 279), 0}, {"lhzux", X_RT_RA_RB, extended(31, 311), 0},
+        {"lhax", X_RT_RA_RB, extended(31, 343), 0}, {"lhaux", X_RT_RA_RB, extended(31, 375), 0},
+        {"stwx", X_RT_RA_RB, extended(31, 151), 0}, {"stwux", X_RT_RA_RB, extended(31, 183), 0},
+        {"stbx", X_RT_RA_RB, extended(31, 215), 0}, {"stbux", X_RT_RA_RB, extended(31, 247), 0},
+        {"sthx", X_RT_RA_RB, extended(31, 407), 0}, {"sthux", X_RT_RA_RB, extended(31, 439), 0},
+        {"lwbrx", X_RT_RA_RB, extended(31, 534), 0}, {"stwbrx", X_RT_RA_RB, extended(31, 662), 0},
+        {"lhbrx", X_RT_RA_RB, extended(31, 790), 0}, {"sthbrx", X_RT_RA_RB, extended(31, 918), 0},
+        {"lswx", X_RT_RA_RB, extended(31, 533), 0}, {"lswi", X_RT_RA_RB, extended(31, 597), 0},
+        {"stswx", X_RT_RA_RB, extended(31, 661), 0}, {"stswi", X_RT_RA_RB, extended(31, 725), 0},
+        {"tw", X_RT_RA_RB, extended(31, 4), 0},
+
+        {"subfc", XO_RT_RA_RB, extended(31, 8), RC | OE}, {"addc", XO_RT_RA_RB, extended(31, 10), RC | OE},
+        {"subf", XO_RT_RA_RB, extended(31, 40), RC | OE}, {"subfe", XO_RT_RA_RB, extended(31, 136), RC | OE},
+        {"adde", XO_RT_RA_RB, extended(31, 138), RC | OE}, {"add", XO_RT_RA_RB, extended(31, 266), RC | OE},
+        {"mulhwu", XO_RT_RA_RB, extended(31, 11), RC}, {"mulhw", XO_RT_RA_RB, extended(31, 75), RC},
+        {"mullw", XO_RT_RA_RB, extended(31, 235), RC | OE}, {"divwu", XO_RT_RA_RB, extended(31, 459), RC | OE},
+        {"divw", XO_RT_RA_RB, extended(31, 491), RC | OE},
+
+        {"neg", XO_RT_RA, extended(31, 104), RC | OE}, {"subfze", XO_RT_RA, extended(31, 200), RC | OE},
+        {"addze", XO_RT_RA, extended(31, 202), RC | OE}, {"subfme", XO_RT_RA, extended(31, 232), RC | OE},
+        {"addme", XO_RT_RA, extended(31, 234), RC | OE},
+
+        {"slw", X_RA_RS_RB, extended(31, 24), RC}, {"and", X_RA_RS_RB, extended(31, 28), RC},
+        {"andc", X_RA_RS_RB, extended(31, 60), RC}, {"nor", X_RA_RS_RB, extended(31, 124), RC},
+        {"eqv", X_RA_RS_RB, extended(31, 284), RC}, {"xor", X_RA_RS_RB, extended(31, 316), RC},
+        {"orc", X_RA_RS_RB, extended(31, 412), RC}, {"or", X_RA_RS_RB, extended(31, 444), RC},
+        {"nand", X_RA_RS_RB, extended(31, 476), RC}, {"srw", X_RA_RS_RB, extended(31, 536), RC},
+        {"sraw", X_RA_RS_RB, extended(31, 792), RC},
+
+        {"cntlzw", X_RA_RS, extended(31, 26), RC}, {"popcntb", X_RA_RS, extended(31, 122), 0},
+        {"extsh", X_RA_RS, extended(31, 922), RC}, {"extsb", X_RA_RS, extended(31, 954), RC},
+        {"srawi", X_RA_RS_SH, extended(31, 824), RC},
+
+        {"rlwimi", M_ROTATE, primary(20), RC}, {"rlwinm", M_ROTATE, primary(21), RC},
+        {"rlwnm", M_ROTATE, primary(23), RC},
+
+        {"mfcr", MOVE_FROM_CR, extended(31, 19), 0}, {"mtcrf", MOVE_TO_CR, extended(31, 144), 0},
+        {"mfspr", MOVE_FROM_SPR, extended(31, 339), 0}, {"mtspr", MOVE_TO_SPR, extended(31, 467), 0},
+
+        {"b", I_BRANCH, primary(18), 0}, {"bl", I_BRANCH, primary(18) | 1, 0},
+        {"ba", I_BRANCH, primary(18) | 2, 0}, {"bla", I_BRANCH, primary(18) | 3, 0},
+        {"bc", B_BRANCH, primary(16), 0}, {"bcl", B_BRANCH, primary(16) | 1, 0},
+        {"bca", B_BRANCH, primary(16) | 2, 0}, {"bcla", B_BRANCH, primary(16) | 3, 0},
+        {"bclr", XL_BRANCH, extended(19, 16), 0}, {"bclrl", XL_BRANCH, extended(19, 16) | 1, 0},
+        {"bcctr", XL_BRANCH, extended(19, 528), 0}, {"bcctrl", XL_BRANCH, extended(19, 528) | 1, 0},
+
+        {"crnor", XL_CONDITION, extended(19, 33), 0}, {"crandc", XL_CONDITION, extended(19, 129), 0},
+        {"crxor", XL_CONDITION, extended(19, 193), 0}, {"crnand", XL_CONDITION, extended(19, 225), 0},
+        {"crand", XL_CONDITION, extended(19, 257), 0}, {"creqv", XL_CONDITION, extended(19, 289), 0},
+        {"crorc", XL_CONDITION, extended(19, 417), 0}, {"cror", XL_CONDITION, extended(19, 449), 0},
+        {"mcrf", MOVE_CR_FIELD, extended(19, 0), 0},
+
+        {"sc", SYSTEM_CALL, primary(17) | 2, 0},
+    };
+
+    // BO and the bit inside of a CR field of the conditional branch mnemonics
+    typedef struct {
+        const char *name;
+        uint32_t BO;
+        uint32_t bit;
+    } condition_t;
+
+    const condition_t CONDITIONS[] = {
+        {"lt", 12, 0}, {"le", 4, 1}, {"eq", 12, 2}, {"ge", 4, 0}, {"gt", 12, 1}, {"nl", 4, 0},
+        {"ne", 4, 2}, {"ng", 4, 1}, {"so", 12, 3}, {"ns", 4, 3}, {"un", 12, 3}, {"nu", 4, 3},
+    };
+
+    // TO of the trap mnemonics
+    const std::map<std::string, uint32_t> TRAP_CONDITIONS = {
+        {"lt", 16}, {"le", 20}, {"eq", 4}, {"ge", 12}, {"gt", 8}, {"nl", 12}, {"ne", 24}, {"ng", 20},
+        {"llt", 2}, {"lle", 6}, {"lge", 5}, {"lgt", 1}, {"lnl", 5}, {"lng", 6},
+    };
+
+    typedef struct {
+        std::string mnemonic;
+        std::vector<std::string> operands;
+        uint32_t address;
+        uint32_t line;
+    } statement_t;
+
+    std::string trim(const std::string &text) {
+        size_t first = text.find_first_not_of(" \t\r");
+        if(first == std::string::npos) {
+            return "";
+        }
+        return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+    }
+
+    class encoder {
+    public:
+        std::map<std::string, uint32_t> labels;
+        std::string error;
+
+        bool encode(statement_t statement, uint32_t &word) {
+            this->statement = &statement;
+            if(statement.mnemonic == ".long" || statement.mnemonic == ".int") {
+                int64_t value;
+                if(!count(1) || !evaluate(statement.operands[0], value)) {
+                    return false;
+                }
+                word = (uint32_t) value;
+                return true;
+            }
+
+            uint32_t suffix = 0;
+            const instruction_t *instruction = find(statement.mnemonic, suffix);
+            if(instruction == nullptr) {
+                expand(statement.mnemonic, statement.operands);
+                instruction = find(statement.mnemonic, suffix);
+                if(instruction == nullptr) {
+                    return fail("unknown instruction " + statement.mnemonic);
+                }
+            }
+            word = instruction->code | suffix;
+            return encode_operands(*instruction, statement.address, word);
+        }
+
+    private:
+        const statement_t *statement = nullptr;
+
+        bool fail(const std::string &message) {
+            if(error.empty()) {
+                error = "line " + std::to_string(statement->line) + ": " + message;
+            }
+            return false;
+        }
+
+        // Looks up a mnemonic, '.' selects the record form and 'o' the form which sets OV
+        static const instruction_t *find(const std::string &mnemonic, uint32_t &suffix) {
+            std::string base = mnemonic;
+            uint8_t required = 0;
+            suffix = 0;
+            for(uint32_t attempt = 0; attempt < 3; attempt++) {
+                for(const instruction_t &instruction : INSTRUCTIONS) {
+                    if(base == instruction.mnemonic && (instruction.flags & required) == required) {
+                        return &instruction;
+                    }
+                }
+                if(attempt == 0 && base.size() > 1 && base.back() == '.') {
+                    base.pop_back();
+                    required |= RC;
+                    suffix |= 1;
+                } else if(base.size() > 1 && base.back() == 'o' && !(required & OE)) {
+                    base.pop_back();
+                    required |= OE;
+                    suffix |= 1 << 10;
+                } else {
+                    break;
+                }
+            }
+            return nullptr;
+        }
+
+        // Rewrites an extended mnemonic into its base instruction, unknown mnemonics are kept
+        static void expand(std::string &mnemonic, std::vector<std::string> &operands) {
+            std::string record = !mnemonic.empty() && mnemonic.back() == '.' ? "." : "";
+            std::string name = mnemonic.substr(0, mnemonic.size() - record.size());
+            std::vector<std::string> &o = operands;
+            auto negated = [](const std::string &value) {
+                return "-(" + value + ")";
+            };
+
+            if(name == "li" && o.size() == 2) {
+                mnemonic = "addi";
+                o = {o[0], "0", o[1]};
+            } else if(name == "lis" && o.size() == 2) {
+                mnemonic = "addis";
+                o = {o[0], "0", o[1]};
+            } else if(name == "la" && o.size() == 2) {
+                size_t open = o[1].rfind('(');
+                std::string displacement = open == std::string::npos ? o[1] : o[1].substr(0, open);
+                std::string base = open == std::string::npos ? "0" : o[1].substr(open + 1, o[1].rfind(')') - open - 1);
+                mnemonic = "addi";
+                o = {o[0], base, displacement.empty() ? "0" : displacement};
+            } else if((name == "subi" || name == "subis" || name == "subic") && o.size() == 3) {
+                mnemonic = (name == "subi" ? "addi" : name == "subis" ? "addis" : "addic") + record;
+                o[2] = negated(o[2]);
+            } else if((name == "sub" || name == "subo" || name == "subc" || name == "subco") && o.size() == 3) {
+                mnemonic = "subf" + name.substr(3) + record;
+                o = {o[0], o[2], o[1]};
+            } else if((name == "mr" || name == "not") && o.size() == 2) {
+                mnemonic = (name == "mr" ? "or" : "nor") + record;
+                o = {o[0], o[1], o[1]};
+            } else if(name == "nop" && o.empty()) {
+                mnemonic = "ori";
+                o = {"0", "0", "0"};
+            } else if(name == "slwi" && o.size() == 3) {
+                mnemonic = "rlwinm" + record;
+                o = {o[0], o[1], o[2], "0", "31-(" + o[2] + ")"};
+            } else if(name == "srwi" && o.size() == 3) {
+                mnemonic = "rlwinm" + record;
+                o = {o[0], o[1], "(32-(" + o[2] + "))&31", o[2], "31"};
+            } else if((name == "rotlwi" || name == "rotrwi") && o.size() == 3) {
+                mnemonic = "rlwinm" + record;
+                o = {o[0], o[1], name == "rotlwi" ? o[2] : "(32-(" + o[2] + "))&31", "0", "31"};
+            } else if(name == "rotlw" && o.size() == 3) {
+                mnemonic = "rlwnm" + record;
+                o = {o[0], o[1], o[2], "0", "31"};
+            } else if(name == "clrlwi" && o.size() == 3) {
+                mnemonic = "rlwinm" + record;
+                o = {o[0], o[1], "0", o[2], "31"};
+            } else if(name == "clrrwi" && o.size() == 3) {
+                mnemonic = "rlwinm" + record;
+                o = {o[0], o[1], "0", "0", "31-(" + o[2] + ")"};
+            } else if(name == "extlwi" && o.size() == 4) {
+                mnemonic = "rlwinm" + record;
+                o = {o[0], o[1], o[3], "0", "(" + o[2] + ")-1"};
+            } else if(name == "extrwi" && o.size() == 4) {
+                mnemonic = "rlwinm" + record;
+                o = {o[0], o[1], "((" + o[3] + ")+(" + o[2] + "))&31", "32-(" + o[2] + ")", "31"};
+            } else if((name == "cmpw" || name == "cmplw" || name == "cmpwi" || name == "cmplwi") &&
+                      (o.size() == 2 || o.size() == 3)) {
+                mnemonic = name == "cmpw" ? "cmp" : name == "cmplw" ? "cmpl" : name == "cmpwi" ? "cmpi" : "cmpli";
+                if(o.size() == 2) {
+                    o.insert(o.begin(), "0");
+                }
+                o.insert(o.begin() + 1, "0");
+            } else if(name == "trap" && o.empty()) {
+                mnemonic = "tw";
+                o = {"31", "0", "0"};
+            } else if(name.compare(0, 2, "tw") == 0 && o.size() == 2) {
+                bool immediate = name.back() == 'i';
+                std::string condition = name.substr(2, name.size() - 2 - immediate);
+                if(TRAP_CONDITIONS.count(condition)) {
+                    mnemonic = immediate ? "twi" : "tw";
+                    o.insert(o.begin(), std::to_string(TRAP_CONDITIONS.at(condition)));
+                }
+            } else if((name == "mtlr" || name == "mtctr" || name == "mtxer") && o.size() == 1) {
+                mnemonic = "mtspr";
+                o = {name == "mtlr" ? "8" : name == "mtctr" ? "9" : "1", o[0]};
+            } else if((name == "mflr" || name == "mfctr" || name == "mfxer") && o.size() == 1) {
+                mnemonic = "mfspr";
+                o = {o[0], name == "mflr" ? "8" : name == "mfctr" ? "9" : "1"};
+            } else if(name == "mtcr" && o.size() == 1) {
+                mnemonic = "mtcrf";
+                o = {"255", o[0]};
+            } else if((name == "crset" || name == "crclr") && o.size() == 1) {
+                mnemonic = name == "crset" ? "creqv" : "crxor";
+                o = {o[0], o[0], o[0]};
+            } else if((name == "crmove" || name == "crnot") && o.size() == 2) {
+                mnemonic = name == "crmove" ? "cror" : "crnor";
+                o = {o[0], o[1], o[1]};
+            } else if(name == "blr" || name == "blrl" || name == "bctr" || name == "bctrl") {
+                mnemonic = "bc" + name.substr(1);
+                o = {"20", "0"};
+            } else if(name.compare(0, 4, "bdnz") == 0 || name.compare(0, 3, "bdz") == 0) {
+                bool zero = name[2] == 'z';
+                std::string rest = name.substr(zero ? 3 : 4);
+                std::string BO = zero ? "18" : "16";
+                if((rest == "" || rest == "l" || rest == "a" || rest == "la") && o.size() == 1) {
+                    mnemonic = "bc" + rest;
+                    o = {BO, "0", o[0]};
+                } else if((rest == "lr" || rest == "lrl") && o.empty()) {
+                    mnemonic = "bc" + rest;
+                    o = {BO, "0"};
+                }
+            } else if(name.size() >= 3 && name[0] == 'b') {
+                // b<condition>[l][a] [crN,] target and b<condition>lr[l] or b<condition>ctr[l] [crN]
+                for(const condition_t &condition : CONDITIONS) {
+                    if(name.compare(1, 2, condition.name) != 0) {
+                        continue;
+                    }
+                    std::string rest = name.substr(3);
+                    bool to_register = rest == "lr" || rest == "lrl" || rest == "ctr" || rest == "ctrl";
+                    bool relative = rest == "" || rest == "l" || rest == "a" || rest == "la";
+                    size_t targets = to_register ? 0 : 1;
+                    if((!to_register && !relative) || o.size() < targets || o.size() > targets + 1) {
+                        break;
+                    }
+                    std::string field = o.size() > targets ? o[0] : "0";
+                    std::string BI = "4*(" + field + ")+" + std::to_string(condition.bit);
+                    mnemonic = "bc" + rest;
+                    std::vector<std::string> expanded = {std::to_string(condition.BO), BI};
+                    if(relative) {
+                        expanded.push_back(o.back());
+                    }
+                    o = expanded;
+                    break;
+                }
+            }
+        }
+
+        bool count(size_t n) {
+            if(statement->operands.size() != n) {
+                return fail(statement->mnemonic + " expects " + std::to_string(n) + " operands");
+            }
+            return true;
+        }
+
+        // Evaluates the operand and checks that it fits into the given range
+        bool operand(size_t index, int64_t min, int64_t max, uint32_t &field) {
+            int64_t value;
+            if(!evaluate(statement->operands[index], value)) {
+                return false;
+            }
+            if(value < min || value > max) {
+                return fail("operand " + statement->operands[index] + " is out of range");
+            }
+            field = (uint32_t) value;
+            return true;
+        }
+
+        bool reg(size_t index, uint32_t &field) {
+            return operand(index, 0, 31, field);
+        }
+
+        bool signed_immediate(size_t index, uint32_t &field) {
+            bool ok = operand(index, -32768, 65535, field);
+            field &= 0xFFFF;
+            return ok;
+        }
+
+        bool unsigned_immediate(size_t index, uint32_t &field) {
+            return operand(index, 0, 65535, field);
+        }
+
+        bool branch_target(size_t index, uint32_t address, bool absolute, uint32_t bits, uint32_t &field) {
+            int64_t target;
+            if(!evaluate(statement->operands[index], target)) {
+                return false;
+            }
+            int64_t offset = absolute ? target : target - address;
+            int64_t limit = (int64_t) 1 << (bits - 1);
+            if(offset % 4 != 0 || offset < -limit || offset >= limit) {
+                return fail("branch target " + statement->operands[index] + " is out of range");
+            }
+            field = (uint32_t) offset & (((uint32_t) 1 << bits) - 4);
+            return true;
+        }
+
+        bool encode_operands(const instruction_t &instruction, uint32_t address, uint32_t &word) {
+            const std::vector<std::string> &o = statement->operands;
+            uint32_t a = 0, b = 0, c = 0, d = 0, e = 0;
+            switch(instruction.form) {
+                case D_LOAD_STORE: {
+                    if(!count(2)) {
+                        return false;
+                    }
+                    size_t open = o[1].rfind('(');
+                    size_t close = o[1].rfind(')');
+                    if(open == std::string::npos || close == std::string::npos || close < open) {
+                        return fail("expected displacement(register) instead of " + o[1]);
+                    }
+                    std::string displacement = trim(o[1].substr(0, open));
+                    std::vector<std::string> parts = {o[0], displacement.empty() ? "0" : displacement,
+                                                      o[1].substr(open + 1, close - open - 1)};
+                    statement_t split = {statement->mnemonic, parts, statement->address, statement->line};
+                    const statement_t *original = statement;
+                    statement = &split;
+                    bool ok = reg(0, a) && signed_immediate(1, b) && reg(2, c);
+                    statement = original;
+                    word |= a << 21 | c << 16 | b;
+                    return ok;
+                }
+                case D_SIGNED:
+                    if(!count(3) || !reg(0, a) || !reg(1, b) || !signed_immediate(2, c)) {
+                        return false;
+                    }
+                    word |= a << 21 | b << 16 | c;
+                    return true;
+                case D_UNSIGNED:
+                    if(!count(3) || !reg(0, a) || !reg(1, b) || !unsigned_immediate(2, c)) {
+                        return false;
+                    }
+                    word |= b << 21 | a << 16 | c;
+                    return true;
+                case COMPARE_IMMEDIATE:
+                case COMPARE: {
+                    // L may be left out
+                    size_t L = o.size() == 4 ? 1 : 0;
+                    if(o.size() != 3 && !count(4)) {
+                        return false;
+                    }
+                    if(!operand(0, 0, 7, a) || (L && !operand(1, 0, 1, b)) || !reg(1 + L, c)) {
+                        return false;
+                    }
+                    bool ok;
+                    if(instruction.form == COMPARE) {
+                        ok = reg(2 + L, d);
+                        d <<= 11;
+                    } else if(instruction.flags & SIGNED_IMMEDIATE) {
+                        ok = signed_immediate(2 + L, d);
+                    } else {
+                        ok = unsigned_immediate(2 + L, d);
+                    }
+                    word |= a << 23 | b << 21 | c << 16 | d;
+                    return ok;
+                }
+                case X_RT_RA_RB:
+                case XO_RT_RA_RB:
+                    if(!count(3) || !reg(0, a) || !reg(1, b) || !reg(2, c)) {
+                        return false;
+                    }
+                    word |= a << 21 | b << 16 | c << 11;
+                    return true;
+                case XO_RT_RA:
+                    if(!count(2) || !reg(0, a) || !reg(1, b)) {
+                        return false;
+                    }
+                    word |= a << 21 | b << 16;
+                    return true;
+                case X_RA_RS_RB:
+                case X_RA_RS_SH:
+                    if(!count(3) || !reg(0, a) || !reg(1, b) || !reg(2, c)) {
+                        return false;
+                    }
+                    word |= b << 21 | a << 16 | c << 11;
+                    return true;
+                case X_RA_RS:
+                    if(!count(2) || !reg(0, a) || !reg(1, b)) {
+                        return false;
+                    }
+                    word |= b << 21 | a << 16;
+                    return true;
+                case M_ROTATE:
+                    if(!count(5) || !reg(0, a) || !reg(1, b) || !reg(2, c) || !reg(3, d) || !reg(4, e)) {
+                        return false;
+                    }
+                    word |= b << 21 | a << 16 | c << 11 | d << 6 | e << 1;
+                    return true;
+                case MOVE_FROM_CR:
+                    if(!count(1) || !reg(0, a)) {
+                        return false;
+                    }
+                    word |= a << 21;
+                    return true;
+                case MOVE_TO_CR:
+                    if(!count(2) || !operand(0, 0, 255, a) || !reg(1, b)) {
+                        return false;
+                    }
+                    word |= b << 21 | a << 12;
+                    return true;
+                case MOVE_FROM_SPR:
+                case MOVE_TO_SPR: {
+                    // The two halves of the SPR number are swapped in the instruction
+                    size_t spr = instruction.form == MOVE_FROM_SPR ? 1 : 0;
+                    if(!count(2) || !reg(1 - spr, a) || !operand(spr, 0, 1023, b)) {
+                        return false;
+                    }
+                    word |= a << 21 | ((b & 0x1F) << 5 | b >> 5) << 11;
+                    return true;
+                }
+                case I_BRANCH:
+                    if(!count(1) || !branch_target(0, address, word & 2, 26, a)) {
+                        return false;
+                    }
+                    word |= a;
+                    return true;
+                case B_BRANCH:
+                    if(!count(3) || !reg(0, a) || !reg(1, b) || !branch_target(2, address, word & 2, 16, c)) {
+                        return false;
+                    }
+                    word |= a << 21 | b << 16 | c;
+                    return true;
+                case XL_BRANCH:
+                    if(o.size() != 2 && !count(3)) {
+                        return false;
+                    }
+                    if(!reg(0, a) || !reg(1, b) || (o.size() == 3 && !operand(2, 0, 3, c))) {
+                        return false;
+                    }
+                    word |= a << 21 | b << 16 | c << 11;
+                    return true;
+                case XL_CONDITION:
+                    if(!count(3) || !reg(0, a) || !reg(1, b) || !reg(2, c)) {
+                        return false;
+                    }
+                    word |= a << 21 | b << 16 | c << 11;
+                    return true;
+                case MOVE_CR_FIELD:
+                    if(!count(2) || !operand(0, 0, 7, a) || !operand(1, 0, 7, b)) {
+                        return false;
+                    }
+                    word |= a << 23 | b << 18;
+                    return true;
+                case SYSTEM_CALL:
+                    if((o.size() > 0 && !count(1)) || (o.size() == 1 && !operand(0, 0, 127, a))) {
+                        return false;
+                    }
+                    word |= a << 5;
+                    return true;
+            }
+            return fail("unsupported form");
+        }
+
+        // Recursive descent over expressions with +, -, *, & and parentheses
+        bool evaluate(const std::string &text, int64_t &value) {
+            size_t position = 0;
+            if(!expression(text, position, value)) {
+                return false;
+            }
+            skip_spaces(text, position);
+            if(position != text.size()) {
+                return fail("invalid operand " + text);
+            }
+            return true;
+        }
+
+        static void skip_spaces(const std::string &text, size_t &position) {
+            while(position < text.size() && isspace((unsigned char) text[position])) {
+                position++;
+            }
+        }
+
+        bool expression(const std::string &text, size_t &position, int64_t &value) {
+            if(!sum(text, position, value)) {
+                return false;
+            }
+            skip_spaces(text, position);
+            while(position < text.size() && text[position] == '&') {
+                position++;
+                int64_t right;
+                if(!sum(text, position, right)) {
+                    return false;
+                }
+                value &= right;
+                skip_spaces(text, position);
+            }
+            return true;
+        }
+
+        bool sum(const std::string &text, size_t &position, int64_t &value) {
+            if(!product(text, position, value)) {
+                return false;
+            }
+            skip_spaces(text, position);
+            while(position < text.size() && (text[position] == '+' || text[position] == '-')) {
+                char operation = text[position++];
+                int64_t right;
+                if(!product(text, position, right)) {
+                    return false;
+                }
+                value = operation == '+' ? value + right : value - right;
+                skip_spaces(text, position);
+            }
+            return true;
+        }
+
+        bool product(const std::string &text, size_t &position, int64_t &value) {
+            if(!factor(text, position, value)) {
+                return false;
+            }
+            skip_spaces(text, position);
+            while(position < text.size() && text[position] == '*') {
+                position++;
+                int64_t right;
+                if(!factor(text, position, right)) {
+                    return false;
+                }
+                value *= right;
+                skip_spaces(text, position);
+            }
+            return true;
+        }
+
+        bool factor(const std::string &text, size_t &position, int64_t &value) {
+            skip_spaces(text, position);
+            if(position >= text.size()) {
+                return fail("missing operand in " + text);
+            }
+            char first = text[position];
+            if(first == '-' || first == '+') {
+                position++;
+                if(!factor(text, position, value)) {
+                    return false;
+                }
+                value = first == '-' ? -value : value;
+                return true;
+            }
+            if(first == '(') {
+                position++;
+                if(!expression(text, position, value)) {
+                    return false;
+                }
+                skip_spaces(text, position);
+                if(position >= text.size() || text[position] != ')') {
+                    return fail("missing ) in " + text);
+                }
+                position++;
+                return true;
+            }
+            if(isdigit((unsigned char) first)) {
+                const char *start = text.c_str() + position;
+                char *end;
+                value = strtoll(start, &end, 0);
+                position += end - start;
+                return true;
+            }
+
+            size_t start = position;
+            if(first == '%') {
+                position++;
+            }
+            while(position < text.size() && (isalnum((unsigned char) text[position]) || text[position] == '_' ||
+                                             text[position] == '.' || text[position] == '$')) {
+                position++;
+            }
+            std::string name = text.substr(start, position - start);
+            std::string bare = name[0] == '%' ? name.substr(1) : name;
+            if(bare.empty()) {
+                return fail("invalid operand " + text);
+            }
+            // Register names r0 to r31 and condition register fields cr0 to cr7
+            size_t digits = bare[0] == 'r' ? 1 : bare.compare(0, 2, "cr") == 0 ? 2 : 0;
+            if(digits > 0 && bare.size() > digits &&
+               bare.find_first_not_of("0123456789", digits) == std::string::npos) {
+                value = atoi(bare.c_str() + digits);
+                return true;
+            }
+            const char *bits[] = {"lt", "gt", "eq", "so", "un"};
+            for(uint32_t i = 0; i < 5; i++) {
+                if(bare == bits[i]) {
+                    value = i < 4 ? i : 3;
+                    return true;
+                }
+            }
+            auto label = labels.find(name);
+            if(label == labels.end()) {
+                return fail("unknown symbol " + name);
+            }
+            value = label->second;
+            return true;
+        }
+    };
+}
+
+bool assembler::assemble(const std::string &source, std::vector<uint32_t> &code, std::string &error) {
+    encoder encoder;
+    std::vector<statement_t> statements;
+    uint32_t address = 0;
+    uint32_t line_number = 1;
+
+    // First pass: statements and the addresses of the labels
+    size_t start = 0;
+    while(start <= source.size()) {
+        size_t end = source.find('\n', start);
+        if(end == std::string::npos) {
+            end = source.size();
+        }
+        std::string line = source.substr(start, end - start);
+        line = line.substr(0, line.find('#'));
+
+        size_t piece_start = 0;
+        while(piece_start <= line.size()) {
+            size_t piece_end = line.find(';', piece_start);
+            if(piece_end == std::string::npos) {
+                piece_end = line.size();
+            }
+            std::string piece = trim(line.substr(piece_start, piece_end - piece_start));
+            piece_start = piece_end + 1;
+
+            size_t colon;
+            while((colon = piece.find(':')) != std::string::npos) {
+                std::string label = trim(piece.substr(0, colon));
+                if(label.empty() || label.find_first_of(" \t,()") != std::string::npos) {
+                    error = "line " + std::to_string(line_number) + ": invalid label " + label;
+                    return false;
+                }
+                encoder.labels[label] = address;
+                piece = trim(piece.substr(colon + 1));
+            }
+            if(piece.empty()) {
+                continue;
+            }
+
+            size_t space = piece.find_first_of(" \t");
+            statement_t statement;
+            statement.mnemonic = piece.substr(0, space);
+            if(space != std::string::npos) {
+                std::string operands = piece.substr(space + 1);
+                size_t operand_start = 0;
+                while(true) {
+                    size_t comma = operands.find(',', operand_start);
+                    statement.operands.push_back(trim(operands.substr(operand_start, comma - operand_start)));
+                    if(comma == std::string::npos) {
+                        break;
+                    }
+                    operand_start = comma + 1;
+                }
+            }
+            statement.address = address;
+            statement.line = line_number;
+            statements.push_back(statement);
+            address += 4;
+        }
+
+        line_number++;
+        start = end + 1;
+    }
+
+    // Second pass: encoding with all labels known
+    for(const statement_t &statement : statements) {
+        uint32_t word;
+        if(!encoder.encode(statement, word)) {
+            error = encoder.error;
+            return false;
+        }
+        code.push_back(word);
+    }
+    return true;
+}
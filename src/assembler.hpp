@@ -0,0 +1,42 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_ASSEMBLER_HPP
+#define POWERPC_HLS_ASSEMBLER_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Software simulation only!
+// Assembler for the fixed point, branch and condition register instructions, which the decoder supports, and their
+// common extended mnemonics (li, mr, slwi, cmpwi, beq, blr, ...). Replaces the external toolchain for the tests.
+//
+// Syntax like the GNU assembler: one statement per line or separated by ';', comments start with '#', labels end
+// with ':'. Operands are numbers, labels or simple expressions with '+', '-' and '*', registers can be written as
+// 3, r3 or %r3 and condition register fields as cr1, so 4*cr1+eq is a BI operand. Branch targets are addresses, the
+// program starts at address 0. .long emits a data word.
+namespace assembler {
+    // Appends the instructions in host byte order to code. Returns false with a message in error on failures.
+    bool assemble(const std::string &source, std::vector<uint32_t> &code, std::string &error);
+}
+
+#endif //POWERPC_HLS_ASSEMBLER_HPP
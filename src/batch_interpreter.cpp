@@ -0,0 +1,468 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "batch_interpreter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include "decode_cache.hpp"
+#include "micro_op.hpp"
+#include "pipeline.hpp"
+
+namespace {
+    // Bits of the XER as returned by getXER
+    const uint32_t XER_CA = 1u << 29;
+    const uint32_t XER_OV = 1u << 30;
+    const uint32_t XER_SO = 1u << 31;
+
+    typedef uint32_t lanes_t[BATCH_LANES];
+
+    // Registers of all lanes as structure of arrays, a lane mask holds all bits set for selected lanes
+    typedef struct {
+        uint32_t GPR[32][BATCH_LANES];
+        lanes_t CR;
+        lanes_t XER;
+        lanes_t LR;
+        lanes_t CTR;
+        lanes_t PC;
+    } batch_registers_t;
+
+    void load_lane(batch_registers_t &batch, uint32_t lane, registers_t &registers) {
+        for(uint32_t i = 0; i < 32; i++) {
+            batch.GPR[i][lane] = registers.GPR[i];
+        }
+        batch.CR[lane] = registers.condition_reg.getCR();
+        batch.XER[lane] = registers.fixed_exception_reg.getXER();
+        batch.LR[lane] = registers.link_register;
+        batch.CTR[lane] = registers.count_register;
+        batch.PC[lane] = registers.program_counter;
+    }
+
+    void store_lane(const batch_registers_t &batch, uint32_t lane, registers_t &registers) {
+        for(uint32_t i = 0; i < 32; i++) {
+            registers.GPR[i] = batch.GPR[i][lane];
+        }
+        registers.condition_reg = batch.CR[lane];
+        registers.fixed_exception_reg = batch.XER[lane];
+        registers.link_register = batch.LR[lane];
+        registers.count_register = batch.CTR[lane];
+        registers.program_counter = batch.PC[lane];
+    }
+
+    inline uint32_t blend(uint32_t mask, uint32_t value, uint32_t old) {
+        return (value & mask) | (old & ~mask);
+    }
+
+    // Writes the result to the target register of the selected lanes and updates CR0 if requested
+    void write_result(const micro_op_t &op, batch_registers_t &batch, const lanes_t mask, const lanes_t result) {
+        for(uint32_t l = 0; l < BATCH_LANES; l++) {
+            batch.GPR[op.reg_c][l] = blend(mask[l], result[l], batch.GPR[op.reg_c][l]);
+        }
+        if(op.flags & micro_op::ALTER_CR0) {
+            for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                uint32_t field = result[l] == 0 ? CR_EQ : ((int32_t) result[l] < 0 ? CR_LT : CR_GT);
+                field |= (batch.XER[l] & XER_SO) ? CR_SO : 0;
+                batch.CR[l] = blend(mask[l], (batch.CR[l] & 0x0FFFFFFF) | (field << condition_field_shift(0)),
+                                    batch.CR[l]);
+            }
+        }
+    }
+
+    inline uint32_t operand_b(const micro_op_t &op, const batch_registers_t &batch, uint32_t lane) {
+        return (op.flags & micro_op::OP2_IMM) ? op.immediate : batch.GPR[op.reg_b][lane];
+    }
+
+    // Same as fixed_point::add_sub
+    void add_sub(const micro_op_t &op, batch_registers_t &batch, const lanes_t mask) {
+        const bool op1_imm = op.flags & micro_op::OP1_IMM;
+        const bool subtract = op.flags & micro_op::SUBTRACT;
+        const bool add_CA = op.flags & micro_op::ADD_CA;
+
+        lanes_t result;
+        lanes_t carry;
+        lanes_t overflow;
+        for(uint32_t l = 0; l < BATCH_LANES; l++) {
+            // The first immediate is always zero
+            uint32_t op1 = op1_imm ? 0 : batch.GPR[op.reg_a][l];
+            uint32_t op2 = operand_b(op, batch, l);
+            uint32_t carry_in = add_CA ? (batch.XER[l] >> 29) & 1 : (subtract ? 1 : 0);
+            if(subtract) {
+                op1 = ~op1;
+            }
+            uint32_t sum = op1 + op2 + carry_in;
+            result[l] = sum;
+            carry[l] = ((op1 & op2) | ((op1 | op2) & ~sum)) >> 31;
+            overflow[l] = ((op1 ^ sum) & (op2 ^ sum)) >> 31;
+        }
+
+        if(op.flags & micro_op::ALTER_CA) {
+            for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                batch.XER[l] = blend(mask[l], (batch.XER[l] & ~XER_CA) | (carry[l] << 29), batch.XER[l]);
+            }
+        }
+        if(op.flags & micro_op::ALTER_OV) {
+            // SO is sticky
+            for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                uint32_t XER = (batch.XER[l] & ~XER_OV) | (overflow[l] << 30) | (overflow[l] << 31);
+                batch.XER[l] = blend(mask[l], XER, batch.XER[l]);
+            }
+        }
+        write_result(op, batch, mask, result);
+    }
+
+    // Same as fixed_point::logical
+    void logical(const micro_op_t &op, batch_registers_t &batch, const lanes_t mask) {
+        lanes_t op1;
+        lanes_t op2;
+        for(uint32_t l = 0; l < BATCH_LANES; l++) {
+            op1[l] = batch.GPR[op.reg_a][l];
+            op2[l] = operand_b(op, batch, l);
+        }
+
+        lanes_t result;
+        switch(op.operation) {
+            case logical::AND:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = op1[l] & op2[l];
+                }
+                break;
+            case logical::OR:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = op1[l] | op2[l];
+                }
+                break;
+            case logical::XOR:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = op1[l] ^ op2[l];
+                }
+                break;
+            case logical::NAND:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = ~(op1[l] & op2[l]);
+                }
+                break;
+            case logical::NOR:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = ~(op1[l] | op2[l]);
+                }
+                break;
+            case logical::EQUIVALENT:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = ~(op1[l] ^ op2[l]);
+                }
+                break;
+            case logical::AND_COMPLEMENT:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = op1[l] & ~op2[l];
+                }
+                break;
+            case logical::OR_COMPLEMENT:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = op1[l] | ~op2[l];
+                }
+                break;
+            case logical::EXTEND_SIGN_BYTE:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = (int32_t) (int8_t) op1[l];
+                }
+                break;
+            case logical::EXTEND_SIGN_HALFWORD:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = (int32_t) (int16_t) op1[l];
+                }
+                break;
+            case logical::COUNT_LEDING_ZEROS_WORD:
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    result[l] = op1[l] == 0 ? 32 : __builtin_clz(op1[l]);
+                }
+                break;
+        }
+        write_result(op, batch, mask, result);
+    }
+
+    // Same as fixed_point::rotate, including the shifts
+    void rotate(const micro_op_t &op, batch_registers_t &batch, const lanes_t mask) {
+        const bool shift_imm = op.flags & micro_op::OP2_IMM;
+        const bool shift_op = op.flags & micro_op::SHIFT;
+        const bool left = op.flags & micro_op::LEFT;
+        const bool sign_extend = op.flags & micro_op::SHIFT_SIGN_EXTEND;
+        const bool insert_mask = op.flags & micro_op::MASK_INSERT;
+
+        const bool arithmetic = shift_op && !left && sign_extend;
+
+        lanes_t amount;
+        lanes_t rotate_mask;
+        if(!shift_op) {
+            // MB and ME are in big endian notation
+            uint32_t from_begin = 0xFFFFFFFFu >> op.field_b;
+            uint32_t to_end = 0xFFFFFFFFu << (31 - op.field_c);
+            uint32_t mask_MB_ME = op.field_b <= op.field_c ? from_begin & to_end : from_begin | to_end;
+            for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                uint32_t shift = shift_imm ? op.field_a : batch.GPR[op.reg_b][l];
+                amount[l] = shift & 0x1F;
+                rotate_mask[l] = mask_MB_ME;
+            }
+        } else if(left) {
+            // MB = 0 and ME = 31 - n, shift amounts above 31 clear the mask
+            for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                uint32_t shift = shift_imm ? op.field_a : batch.GPR[op.reg_b][l] & 0x3F;
+                amount[l] = shift & 0x1F;
+                rotate_mask[l] = shift < 32 ? 0xFFFFFFFFu << (shift & 0x1F) : 0;
+            }
+        } else {
+            // MB = n and ME = 31 with a rotate left by 32 - n, which goes around completely.
+            // Shift amounts above 31 clear the mask, srawi always computes it.
+            const bool always_mask = sign_extend && shift_imm;
+            for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                uint32_t shift = shift_imm ? op.field_a : batch.GPR[op.reg_b][l] & 0x3F;
+                amount[l] = (32 - shift) & 0x1F;
+                rotate_mask[l] = (always_mask | (shift < 32)) ? 0xFFFFFFFFu >> (shift & 0x1F) : 0;
+            }
+        }
+
+        lanes_t result;
+        lanes_t carry;
+        for(uint32_t l = 0; l < BATCH_LANES; l++) {
+            uint32_t source = batch.GPR[op.reg_a][l];
+            uint32_t shifted = (source << amount[l]) | (source >> ((32 - amount[l]) & 0x1F));
+            uint32_t sign = (int32_t) source >> 31;
+            uint32_t target = batch.GPR[op.reg_c][l];
+            uint32_t insert = insert_mask ? target : (arithmetic ? sign : 0);
+
+            result[l] = (shifted & rotate_mask[l]) | (insert & ~rotate_mask[l]);
+            carry[l] = sign & ((shifted & ~rotate_mask[l]) != 0);
+        }
+
+        if(arithmetic) {
+            for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                batch.XER[l] = blend(mask[l], (batch.XER[l] & ~XER_CA) | (carry[l] << 29), batch.XER[l]);
+            }
+        }
+        write_result(op, batch, mask, result);
+    }
+
+    // Same as fixed_point::compare
+    void compare(const micro_op_t &op, batch_registers_t &batch, const lanes_t mask) {
+        const bool cmp_signed = op.flags & micro_op::SIGNED;
+        const uint32_t shift = condition_field_shift(op.field_a);
+        for(uint32_t l = 0; l < BATCH_LANES; l++) {
+            uint32_t op1 = batch.GPR[op.reg_a][l];
+            uint32_t op2 = operand_b(op, batch, l);
+            bool less = cmp_signed ? (int32_t) op1 < (int32_t) op2 : op1 < op2;
+            bool greater = cmp_signed ? (int32_t) op1 > (int32_t) op2 : op1 > op2;
+            uint32_t field = less ? CR_LT : (greater ? CR_GT : CR_EQ);
+            field |= (batch.XER[l] & XER_SO) ? CR_SO : 0;
+            batch.CR[l] = blend(mask[l], (batch.CR[l] & ~(0xFu << shift)) | (field << shift), batch.CR[l]);
+        }
+    }
+
+    // Same as branch::branch, sets the program counter of the selected lanes to the next instruction
+    void branch(const micro_op_t &op, batch_registers_t &batch, const lanes_t mask) {
+        const uint32_t operation = op.operation;
+        // BO is in big endian notation
+        const bool BO_0 = op.field_a & 0x10;
+        const bool BO_1 = op.field_a & 0x08;
+        const bool BO_2 = op.field_a & 0x04;
+        const bool BO_3 = op.field_a & 0x02;
+        const uint32_t BI_shift = condition_bit_shift(op.field_b);
+        const bool decrement = operation != BRANCH_CONDITIONAL_COUNT && operation != ::BRANCH && !BO_2;
+
+        int32_t displacement;
+        if(operation == ::BRANCH) {
+            // Sign extend LI || 0b00
+            displacement = ((int32_t) (op.immediate << 8)) >> 6;
+        } else {
+            // Sign extend BD || 0b00
+            displacement = ((int32_t) (op.immediate << 18)) >> 16;
+        }
+
+        const bool unconditional = operation == ::BRANCH;
+        const bool to_link = operation == BRANCH_CONDITIONAL_LINK;
+        const bool to_count = operation == BRANCH_CONDITIONAL_COUNT;
+        const uint32_t link_mask = (op.flags & micro_op::LK) ? 0xFFFFFFFF : 0;
+        for(uint32_t l = 0; l < BATCH_LANES; l++) {
+            uint32_t CIA = batch.PC[l];
+            uint32_t CTR = batch.CTR[l] - (decrement ? 1 : 0);
+
+            bool ctr_ok = BO_2 | ((CTR != 0) != BO_3);
+            bool cond_ok = BO_0 | (((batch.CR[l] >> BI_shift) & 1) == BO_1);
+            bool taken = unconditional | (cond_ok & (to_count | ctr_ok));
+
+            uint32_t direct = (op.flags & micro_op::AA) ? displacement : CIA + displacement;
+            uint32_t target = to_link ? batch.LR[l] & ~3u : (to_count ? CTR & ~3u : direct);
+
+            batch.CTR[l] = blend(mask[l], CTR, batch.CTR[l]);
+            // Store return address to the link register
+            batch.LR[l] = blend(mask[l] & link_mask, CIA + 4, batch.LR[l]);
+            batch.PC[l] = blend(mask[l], taken ? target : CIA + 4, CIA);
+        }
+    }
+
+    // Runs up to BATCH_LANES instances
+    uint64_t run_group(ppc_uint<32> *instruction_memory, simulation_instance_t *instances, uint32_t count,
+                       const run_options_t &options, decode_cache &decoded) {
+        // Unused lanes stay zero, they are computed but never selected
+        batch_registers_t batch = {};
+        uint64_t retired[BATCH_LANES];
+        bool active[BATCH_LANES];
+        bool first[BATCH_LANES];
+        for(uint32_t l = 0; l < BATCH_LANES; l++) {
+            active[l] = l < count;
+            first[l] = true;
+            retired[l] = 0;
+            if(active[l]) {
+                load_lane(batch, l, instances[l].registers);
+                instances[l].result.reason = STOP_BUDGET;
+            }
+        }
+
+        auto stop = [&](uint32_t lane, stop_reason_t reason) {
+            active[lane] = false;
+            instances[lane].result.reason = reason;
+        };
+
+        while(true) {
+            // Select the lanes at the lowest program counter, lanes on other paths wait for them
+            bool any_active = false;
+            uint32_t program_counter = 0xFFFFFFFF;
+            for(uint32_t l = 0; l < count; l++) {
+                if(!active[l]) {
+                    continue;
+                }
+                if(retired[l] >= options.max_instructions) {
+                    stop(l, STOP_BUDGET);
+                    continue;
+                }
+                if(options.has_exit_address && batch.PC[l] == options.exit_address) {
+                    stop(l, STOP_EXIT);
+                    continue;
+                }
+                // Breakpoints don't stop the first instruction, so a run can continue from a breakpoint
+                if(!first[l] && !options.breakpoints.empty() &&
+                   std::find(options.breakpoints.begin(), options.breakpoints.end(), batch.PC[l]) !=
+                   options.breakpoints.end()) {
+                    stop(l, STOP_BREAKPOINT);
+                    continue;
+                }
+                any_active = true;
+                program_counter = std::min(program_counter, batch.PC[l]);
+            }
+            if(!any_active) {
+                break;
+            }
+
+            lanes_t mask;
+            for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                mask[l] = (active[l] && batch.PC[l] == program_counter) ? 0xFFFFFFFF : 0;
+            }
+
+            const micro_op_t &op = decoded.lookup(instruction_memory, program_counter);
+            bool vectorized = true;
+            switch(op.opcode) {
+                case micro_op::ADD_SUB:
+                    add_sub(op, batch, mask);
+                    break;
+                case micro_op::LOGICAL:
+                    logical(op, batch, mask);
+                    break;
+                case micro_op::ROTATE:
+                    rotate(op, batch, mask);
+                    break;
+                case micro_op::COMPARE:
+                    compare(op, batch, mask);
+                    break;
+                case micro_op::BRANCH:
+                    branch(op, batch, mask);
+                    break;
+                default:
+                    vectorized = false;
+                    break;
+            }
+
+            if(vectorized) {
+                if(op.opcode != micro_op::BRANCH) {
+                    for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                        batch.PC[l] += mask[l] & 4;
+                    }
+                }
+                for(uint32_t l = 0; l < BATCH_LANES; l++) {
+                    retired[l] += mask[l] & 1;
+                    first[l] = first[l] && !mask[l];
+                }
+                continue;
+            }
+
+            // Loads, stores and the remaining units run per lane on the complete register set
+            for(uint32_t l = 0; l < count; l++) {
+                if(!mask[l]) {
+                    continue;
+                }
+                registers_t &registers = instances[l].registers;
+                store_lane(batch, l, registers);
+                bool trap_happened = execute_decoded_instruction(op, registers,
+                                                                 instances[l].data_memory.data());
+                load_lane(batch, l, registers);
+                retired[l]++;
+                first[l] = false;
+
+                if(trap_happened && options.stop_on_trap) {
+                    stop(l, STOP_TRAP);
+                } else if(op.opcode == micro_op::SYSTEM_CALL && options.stop_on_system_call) {
+                    stop(l, STOP_SYSTEM_CALL);
+                }
+            }
+        }
+
+        uint64_t total = 0;
+        for(uint32_t l = 0; l < count; l++) {
+            store_lane(batch, l, instances[l].registers);
+            instances[l].result.retired = retired[l];
+            total += retired[l];
+        }
+        return total;
+    }
+}
+
+runner_summary_t run_batched(ppc_uint<32> *instruction_memory, std::vector<simulation_instance_t> &instances,
+                             const run_options_t &options) {
+    std::unique_ptr<decode_cache> own_cache;
+    decode_cache *decoded = options.decoded;
+    if(decoded == nullptr) {
+        own_cache.reset(new decode_cache());
+        decoded = own_cache.get();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t retired = 0;
+    for(size_t i = 0; i < instances.size(); i += BATCH_LANES) {
+        uint32_t count = std::min<size_t>(BATCH_LANES, instances.size() - i);
+        retired += run_group(instruction_memory, &instances[i], count, options, *decoded);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    runner_summary_t summary;
+    summary.instances = instances.size();
+    summary.threads = 1;
+    summary.retired = retired;
+    summary.seconds = elapsed.count();
+    summary.mips = summary.seconds > 0 ? summary.retired / summary.seconds / 1e6 : 0;
+    return summary;
+}
@@ -0,0 +1,44 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_BATCH_INTERPRETER_HPP
+#define POWERPC_HLS_BATCH_INTERPRETER_HPP
+
+#include "ppc_int.hpp"
+#include <vector>
+#include "parallel_runner.hpp"
+
+// Number of instances executed together. With 32 bit registers, 8 lanes fill an AVX2 and 16 lanes an AVX-512 vector.
+#ifndef BATCH_LANES
+#define BATCH_LANES 8
+#endif
+
+// Software simulation only!
+// Runs the instances in groups of BATCH_LANES. A group shares one instruction stream: every step executes the
+// instruction at the lowest program counter of the group for all lanes, which are at this address. Lanes on a
+// different branch path wait and rejoin as soon as the others reach their address again.
+// Add/sub, logical, rotate, compare and branch instructions are executed for all lanes at once on a structure of
+// arrays, everything else runs per lane through the regular execute functions.
+// Stop conditions are evaluated per lane, like run() does. The mmio map of the calling thread is shared by all lanes.
+runner_summary_t run_batched(ppc_uint<32> *instruction_memory, std::vector<simulation_instance_t> &instances,
+                             const run_options_t &options);
+
+#endif //POWERPC_HLS_BATCH_INTERPRETER_HPP
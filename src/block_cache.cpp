@@ -0,0 +1,284 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "block_cache.hpp"
+#include "instruction_decode.hpp"
+#include "pipeline.hpp"
+#include "micro_op.hpp"
+#include "macro_op_fusion.hpp"
+#include "mmio.hpp"
+
+namespace {
+    // Compares the architectural state except for the program counter
+    bool same_state(registers_t &a, registers_t &b) {
+        for(uint32_t i = 0; i < 32; i++) {
+            if(a.GPR[i] != b.GPR[i] || a.FPR[i] != b.FPR[i]) {
+                return false;
+            }
+        }
+        return a.condition_reg.getCR() == b.condition_reg.getCR() &&
+               a.fixed_exception_reg.getXER() == b.fixed_exception_reg.getXER() &&
+               a.link_register == b.link_register && a.count_register == b.count_register;
+    }
+}
+
+block_cache::block_cache(uint32_t instruction_memory_size, uint32_t jit_threshold)
+        : instruction_memory_size(instruction_memory_size), jit_threshold(jit_threshold) {
+}
+
+uint64_t block_cache::execute(ppc_uint<32> *instruction_memory, registers_t &registers, ppc_uint<32> *data_memory,
+                              uint64_t max_instructions, bool &trap_happened) {
+    trap_happened = false;
+    uint64_t retired = 0;
+    if(max_instructions == 0) {
+        return 0;
+    }
+
+    translated_block_t *block = lookup(instruction_memory, registers.program_counter);
+    while(true) {
+        const uint32_t length = block->instruction_count;
+        const uint32_t op_count = block->ops.size();
+        const threaded::threaded_op_t *ops = block->ops.data();
+
+        if(max_instructions - retired < length) {
+            // The instruction limit is reached inside of the block, branches are never executed here
+            uint32_t remaining = max_instructions - retired;
+            uint32_t executed = 0;
+            for(uint32_t i = 0; executed < remaining; i++) {
+                uint32_t op_length = micro_op::length(ops[i].op);
+                bool trap;
+                if(op_length > remaining - executed) {
+                    // Only the first instruction of a fused pair is left, execute it on its own
+                    uint32_t address = block->start_address + 4*executed;
+                    threaded::threaded_op_t single = threaded::thread(
+                            pipeline::decode(pipeline::fetch_index(instruction_memory, address >> 2)));
+                    trap = single.handler(single.op, registers, data_memory);
+                    op_length = 1;
+                } else {
+                    trap = ops[i].handler(ops[i].op, registers, data_memory);
+                }
+                executed += op_length;
+                if(trap) {
+                    trap_happened = true;
+                    break;
+                }
+            }
+            registers.program_counter = block->start_address + 4*executed;
+            return retired + executed;
+        }
+
+        if(block->countdown_loop) {
+            // Skip all iterations except for the last one, which leaves the loop
+            branch_decode_t decoded = micro_op::unpack_branch(ops[0].op);
+            bool cond_ok = decoded.BO[4-0] | (registers.condition_reg.bit(decoded.BI) ^ ~decoded.BO[4-1]);
+            if(cond_ok) {
+                uint64_t iterations = (uint32_t)(registers.count_register - 1);
+                if(iterations > max_instructions - retired) {
+                    iterations = max_instructions - retired;
+                }
+                registers.count_register = registers.count_register - (uint32_t)iterations;
+                retired += iterations;
+                if(retired == max_instructions) {
+                    return retired;
+                }
+            }
+        }
+
+        // A loop without stores, which does not change the state in one iteration, never changes it again.
+        // Device reads may change over time, so loops accessing them are excluded.
+        registers_t previous;
+        uint64_t previous_device_accesses = 0;
+        if(block->idle_checks != 0) {
+            previous = registers;
+            previous_device_accesses = mmio::access_count();
+        }
+
+        if(block->compiled != nullptr) {
+            uint32_t trap_position = block->compiled(&registers, data_memory);
+            if(trap_position != 0) {
+                registers.program_counter = block->start_address + 4*trap_position;
+                trap_happened = true;
+                return retired + trap_position;
+            }
+        } else {
+            if(++block->execution_count == jit_threshold && jit_threshold != 0) {
+                block->compiled = jit.compile(block->start_address, block->ops, block->ends_with_branch);
+            }
+
+            // Branches are always the last instruction of a block and need the current instruction address
+            if(block->ends_with_branch) {
+                registers.program_counter = block->start_address + 4*(length - 1);
+            }
+            for(uint32_t i = 0; i < op_count; i++) {
+                if(ops[i].handler(ops[i].op, registers, data_memory)) {
+                    uint32_t trap_position = 0;
+                    for(uint32_t j = 0; j <= i; j++) {
+                        trap_position += micro_op::length(ops[j].op);
+                    }
+                    registers.program_counter = block->start_address + 4*trap_position;
+                    trap_happened = true;
+                    return retired + trap_position;
+                }
+            }
+        }
+        retired += length;
+
+        if(!block->ends_with_branch) {
+            registers.program_counter = block->start_address + 4*length;
+        }
+        if(block->idle_checks != 0 && registers.program_counter == block->start_address) {
+            // Every check costs a copy of the registers, so a loop is only checked a few times
+            block->idle_checks--;
+            if(same_state(previous, registers) && mmio::access_count() == previous_device_accesses) {
+                retired += (max_instructions - retired) / length * length;
+            }
+        }
+        if(retired == max_instructions) {
+            return retired;
+        }
+
+        // Follow the chain, only indirect branches need to search the next block
+        uint32_t next_address = registers.program_counter;
+        if(block->has_taken_address && next_address == block->taken_address) {
+            if(block->taken == nullptr) {
+                block->taken = lookup(instruction_memory, next_address);
+            }
+            block = block->taken;
+        } else if(next_address == block->not_taken_address) {
+            if(block->not_taken == nullptr) {
+                block->not_taken = lookup(instruction_memory, next_address);
+            }
+            block = block->not_taken;
+        } else {
+            block = lookup(instruction_memory, next_address);
+        }
+    }
+}
+
+translated_block_t *block_cache::lookup(ppc_uint<32> *instruction_memory, uint32_t address) {
+    auto entry = blocks.find(address);
+    if(entry != blocks.end()) {
+        return entry->second.get();
+    }
+    return translate(instruction_memory, address);
+}
+
+translated_block_t *block_cache::translate(ppc_uint<32> *instruction_memory, uint32_t address) {
+    std::unique_ptr<translated_block_t> block(new translated_block_t);
+    block->start_address = address;
+    block->ends_with_branch = false;
+    block->has_taken_address = false;
+    block->taken_address = 0;
+    block->taken = nullptr;
+    block->not_taken = nullptr;
+    block->execution_count = 0;
+    block->compiled = nullptr;
+
+    uint32_t current = address;
+    block->instruction_count = 0;
+    do {
+        // Reading beyond the instruction memory yields no operation
+        micro_op_t op;
+        if((current >> 2) < instruction_memory_size) {
+            op = pipeline::decode(pipeline::fetch_index(instruction_memory, current >> 2));
+        } else {
+            op = micro_op::init(micro_op::NONE);
+        }
+
+#ifdef MACRO_OP_FUSION
+        micro_op_t fused;
+        if(!micro_op::is_branch(op) && (current >> 2) + 1 < instruction_memory_size &&
+           block->instruction_count + 2 <= MAX_BLOCK_LENGTH &&
+           pipeline::fuse(op, pipeline::decode(pipeline::fetch_index(instruction_memory, (current >> 2) + 1)), fused)) {
+            op = fused;
+        }
+#endif
+        block->ops.push_back(threaded::thread(op));
+        block->instruction_count += micro_op::length(op);
+        current += 4*micro_op::length(op);
+
+        if(micro_op::is_branch(op)) {
+            block->ends_with_branch = true;
+            block->has_taken_address = micro_op::direct_branch_target(op, current - 4, block->taken_address);
+            break;
+        }
+        if(op.opcode == micro_op::SYSTEM_CALL) {
+            break;
+        }
+    } while(block->instruction_count < MAX_BLOCK_LENGTH);
+    block->not_taken_address = current;
+
+    block->countdown_loop = false;
+    block->idle_checks = 0;
+    if(block->has_taken_address && block->taken_address == address) {
+        const micro_op_t &last = block->ops.back().op;
+        if(block->ops.size() == 1 && last.opcode == micro_op::BRANCH && last.operation == BRANCH_CONDITIONAL) {
+            // Decrement the CTR and branch while it is not zero, the condition does not change inside of the loop
+            branch_decode_t decoded = micro_op::unpack_branch(last);
+            block->countdown_loop = decoded.BO[4-2] == 0 && decoded.BO[4-3] == 0;
+        }
+
+        bool has_stores = false;
+        for(const threaded::threaded_op_t &entry : block->ops) {
+            has_stores |= entry.op.opcode == micro_op::STORE || entry.op.opcode == micro_op::STORE_STRING;
+        }
+        if(!block->countdown_loop && !has_stores) {
+            block->idle_checks = IDLE_LOOP_CHECKS;
+        }
+    }
+
+    translated_block_t *result = block.get();
+    blocks[address] = std::move(block);
+    return result;
+}
+
+void block_cache::invalidate(uint32_t address) {
+    invalidate_range(address, 4);
+}
+
+void block_cache::invalidate_range(uint32_t address, uint32_t size) {
+    // Ends are computed in 64 bits, so ranges and blocks up to the top of the address space don't wrap to zero
+    uint64_t first = address & ~3u;
+    uint64_t last = (uint64_t) address + size;
+    for(auto entry = blocks.begin(); entry != blocks.end();) {
+        uint64_t start = entry->second->start_address;
+        uint64_t end = start + 4*entry->second->instruction_count;
+        if(start < last && first < end) {
+            if(entry->second->compiled != nullptr) {
+                jit.release(entry->second->compiled);
+            }
+            entry = blocks.erase(entry);
+        } else {
+            entry++;
+        }
+    }
+
+    // Links might point to removed blocks
+    for(auto &entry : blocks) {
+        entry.second->taken = nullptr;
+        entry.second->not_taken = nullptr;
+    }
+}
+
+void block_cache::invalidate_all() {
+    blocks.clear();
+    jit.reset();
+}
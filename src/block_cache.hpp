@@ -0,0 +1,94 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_BLOCK_CACHE_HPP
+#define POWERPC_HLS_BLOCK_CACHE_HPP
+
+#include "ppc_int.hpp"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "ppc_types.h"
+#include "threaded_dispatch.hpp"
+#include "jit_x86.hpp"
+
+// Maximum number of instructions in a translated block
+#define MAX_BLOCK_LENGTH 64
+// Number of executions after which a block gets compiled to native code, 0 disables compilation
+#define JIT_THRESHOLD 16
+// Number of iterations in which a loop without stores may reach a fixed point, before it is executed normally
+#define IDLE_LOOP_CHECKS 4
+
+// A straight sequence of instructions, which ends with a branch, a system call or after MAX_BLOCK_LENGTH instructions.
+// With MACRO_OP_FUSION, adjacent instructions are fused during translation.
+typedef struct translated_block {
+    uint32_t start_address;
+    std::vector<threaded::threaded_op_t> ops;
+    uint32_t instruction_count; // Fused micro-ops cover two instructions
+    bool ends_with_branch;
+    // Successors, which are linked on their first use
+    bool has_taken_address; // False for branches to the link or count register
+    uint32_t taken_address;
+    uint32_t not_taken_address;
+    struct translated_block *taken;
+    struct translated_block *not_taken;
+    // Hot blocks are compiled
+    uint32_t execution_count;
+    x86_jit::compiled_block_t compiled;
+    // Loops, which branch back to their own start, are fast-forwarded
+    bool countdown_loop; // A single bdnz to itself
+    uint32_t idle_checks; // Remaining attempts to find a fixed point in a loop without stores
+} translated_block_t;
+
+// Software simulation only!
+// Translates instructions into blocks up to the next branch and executes them as a whole.
+// Blocks are chained directly to their successors, the lookup only runs for branches to the link or count register.
+// Blocks, which are executed often enough, are compiled to native code on supported hosts.
+// Delay loops (bdnz to itself) and loops, which do not change any state, are skipped in one step. Such a loop only
+// reads RAM, which it never changes, so it never exits. Poll loops on a device are not skipped: there is no simulated
+// time besides the retired instructions and devices don't announce when a polled value changes.
+// Writes to the instruction memory have to be announced with one of the invalidate functions.
+class block_cache {
+public:
+    // The memory size is given in words, translation never reads beyond it
+    explicit block_cache(uint32_t instruction_memory_size, uint32_t jit_threshold = JIT_THRESHOLD);
+
+    // Executes instructions starting at the program counter, until max_instructions are retired or a trap occurs.
+    // Returns the number of retired instructions, including the trapping one.
+    uint64_t execute(ppc_uint<32> *instruction_memory, registers_t &registers, ppc_uint<32> *data_memory,
+                     uint64_t max_instructions, bool &trap_happened);
+
+    // Addresses are byte addresses into the instruction memory
+    void invalidate(uint32_t address);
+    void invalidate_range(uint32_t address, uint32_t size);
+    void invalidate_all();
+
+private:
+    translated_block_t *lookup(ppc_uint<32> *instruction_memory, uint32_t address);
+    translated_block_t *translate(ppc_uint<32> *instruction_memory, uint32_t address);
+
+    uint32_t instruction_memory_size;
+    uint32_t jit_threshold;
+    x86_jit jit;
+    std::unordered_map<uint32_t, std::unique_ptr<translated_block_t>> blocks;
+};
+
+#endif //POWERPC_HLS_BLOCK_CACHE_HPP
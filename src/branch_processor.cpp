@@ -26,9 +26,9 @@
 #include "branch_processor.hpp"
 
 void branch::branch(branch_decode_t decoded, registers_t &registers) {
-    ap_uint<32> CIA = registers.program_counter;
-    ap_uint<32> NIA;
-    ap_uint<32> NIA_ext;
+    ppc_uint<32> CIA = registers.program_counter;
+    ppc_uint<32> NIA;
+    ppc_uint<32> NIA_ext;
     switch(decoded.operation) {
         case ::BRANCH:
             NIA_ext(1, 0) = 0;
@@ -55,7 +55,7 @@ void branch::branch(branch_decode_t decoded, registers_t &registers) {
                 registers.count_register--;
             }
             bool ctr_ok = decoded.BO[4-2] | ((registers.count_register != 0) ^ decoded.BO[4-3]);
-            bool cond_ok = decoded.BO[4-0] | (registers.condition_reg.getCR()[31-decoded.BI] ^ ~decoded.BO[4-1]);
+            bool cond_ok = decoded.BO[4-0] | (registers.condition_reg.bit(decoded.BI) ^ ~decoded.BO[4-1]);
             if(ctr_ok && cond_ok) {
                 NIA_ext(1, 0) = 0;
                 NIA_ext(15, 2) = decoded.BD;
@@ -82,7 +82,7 @@ void branch::branch(branch_decode_t decoded, registers_t &registers) {
                 registers.count_register--;
             }
             bool ctr_ok = decoded.BO[4 - 2] | ((registers.count_register != 0) ^ decoded.BO[4 - 3]);
-            bool cond_ok = decoded.BO[4 - 0] | (registers.condition_reg.getCR()[31-decoded.BI] ^ ~decoded.BO[4 - 1]);
+            bool cond_ok = decoded.BO[4 - 0] | (registers.condition_reg.bit(decoded.BI) ^ ~decoded.BO[4 - 1]);
             if (ctr_ok && cond_ok) {
                 NIA(1, 0) = 0;
                 NIA(31, 2) = registers.link_register(31, 2);
@@ -94,7 +94,7 @@ void branch::branch(branch_decode_t decoded, registers_t &registers) {
             break;
         case BRANCH_CONDITIONAL_COUNT: {
             // BO is in big endian notation, reverse the access (4-x)
-            bool cond_ok = decoded.BO[4-0] | (registers.condition_reg.getCR()[31-decoded.BI] ^ ~decoded.BO[4 - 1]);
+            bool cond_ok = decoded.BO[4-0] | (registers.condition_reg.bit(decoded.BI) ^ ~decoded.BO[4 - 1]);
             if(cond_ok) {
                 NIA(1, 0) = 0;
                 NIA(31, 2) = registers.count_register(31, 2);
@@ -113,7 +113,7 @@ void branch::branch(branch_decode_t decoded, registers_t &registers) {
 }
 
 void branch::condition(condition_decode_t decoded, registers_t &registers) {
-    ap_uint<32> CR = registers.condition_reg.getCR();
+    ppc_uint<32> CR = registers.condition_reg.getCR();
     // Big endian notation, reverse access (31-x)
     switch(decoded.operation) {
         case condition::AND:
@@ -142,8 +142,8 @@ void branch::condition(condition_decode_t decoded, registers_t &registers) {
             break;
         case condition::MOVE: {
             // Big endian notation, reverse (7-x)
-            ap_uint<3> BF = 7-decoded.CR_result_reg_address(4, 2);
-            ap_uint<3> BFA = 7-decoded.CR_op1_reg_address(4, 2);
+            ppc_uint<3> BF = 7-decoded.CR_result_reg_address(4, 2);
+            ppc_uint<3> BFA = 7-decoded.CR_op1_reg_address(4, 2);
             CR(4*(BF+1)-1, 4*BF) = CR(4*(BFA+1)-1, 4*BFA);
         }
             break;
@@ -0,0 +1,63 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "decode_cache.hpp"
+#include "instruction_decode.hpp"
+#include "pipeline.hpp"
+
+decode_cache::decode_cache() : entries(DECODE_CACHE_ENTRIES) {
+    invalidate_all();
+}
+
+const micro_op_t &decode_cache::lookup(ppc_uint<32> *instruction_memory, uint32_t program_counter) {
+    entry_t &entry = entries[(program_counter >> 2) & (DECODE_CACHE_ENTRIES - 1)];
+    if(!entry.valid || entry.program_counter != program_counter) {
+        entry.decoded = pipeline::decode(pipeline::fetch_index(instruction_memory, program_counter >> 2));
+        entry.program_counter = program_counter;
+        entry.valid = true;
+    }
+    return entry.decoded;
+}
+
+void decode_cache::invalidate(uint32_t address) {
+    entry_t &entry = entries[(address >> 2) & (DECODE_CACHE_ENTRIES - 1)];
+    if(entry.program_counter == (address & ~3u)) {
+        entry.valid = false;
+    }
+}
+
+void decode_cache::invalidate_range(uint32_t address, uint32_t size) {
+    if(size/4 >= DECODE_CACHE_ENTRIES) {
+        invalidate_all();
+        return;
+    }
+    // The end is computed in 64 bits, so a range up to the top of the address space doesn't wrap to zero
+    uint64_t end = (uint64_t) address + size;
+    for(uint64_t i = address & ~3u; i < end; i += 4) {
+        invalidate((uint32_t) i);
+    }
+}
+
+void decode_cache::invalidate_all() {
+    for(auto &entry : entries) {
+        entry.valid = false;
+    }
+}
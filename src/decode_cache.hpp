@@ -0,0 +1,56 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_DECODE_CACHE_HPP
+#define POWERPC_HLS_DECODE_CACHE_HPP
+
+#include "ppc_int.hpp"
+#include <vector>
+#include "ppc_types.h"
+
+// Number of cached instructions, has to be a power of two
+#define DECODE_CACHE_ENTRIES 4096
+
+// Software simulation only!
+// Keeps decoded instructions indexed by their program counter, so loops don't run through the decoder
+// on every iteration. Writes to the instruction memory have to be announced with one of the invalidate functions.
+class decode_cache {
+public:
+    decode_cache();
+
+    const micro_op_t &lookup(ppc_uint<32> *instruction_memory, uint32_t program_counter);
+
+    // Addresses are byte addresses into the instruction memory
+    void invalidate(uint32_t address);
+    void invalidate_range(uint32_t address, uint32_t size);
+    void invalidate_all();
+
+private:
+    typedef struct {
+        bool valid;
+        uint32_t program_counter;
+        micro_op_t decoded;
+    } entry_t;
+
+    std::vector<entry_t> entries;
+};
+
+#endif //POWERPC_HLS_DECODE_CACHE_HPP
@@ -0,0 +1,199 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "elf_loader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "test_bench_utils.hpp"
+
+namespace {
+    const uint8_t ELF_MAGIC[4] = {0x7F, 'E', 'L', 'F'};
+    const uint8_t ELF_CLASS_32 = 1;
+    const uint8_t ELF_DATA_BIG_ENDIAN = 2;
+    const uint16_t ELF_MACHINE_PPC = 20;
+    const uint16_t ELF_TYPE_RELOCATABLE = 1;
+
+    const uint32_t PT_LOAD = 1;
+    const uint32_t PF_X = 1;
+
+    const uint32_t SHT_PROGBITS = 1;
+    const uint32_t SHT_NOBITS = 8;
+    const uint32_t SHF_ALLOC = 2;
+    const uint32_t SHF_EXECINSTR = 4;
+
+    const uint32_t ELF_HEADER_SIZE = 52;
+    const uint32_t PROGRAM_HEADER_SIZE = 32;
+    const uint32_t SECTION_HEADER_SIZE = 40;
+
+    uint16_t get16(const uint8_t *bytes) {
+        return (uint16_t) (bytes[0] << 8 | bytes[1]);
+    }
+
+    uint32_t get32(const uint8_t *bytes) {
+        return (uint32_t) bytes[0] << 24 | (uint32_t) bytes[1] << 16 | (uint32_t) bytes[2] << 8 | bytes[3];
+    }
+
+    // Part of the file, which is loaded to address, the remaining bytes up to memory_size are zero
+    typedef struct {
+        uint32_t address;
+        uint32_t offset;
+        uint32_t file_size;
+        uint32_t memory_size;
+        bool executable;
+    } segment_t;
+
+    // The file is mapped read only when possible, so the segments are copied straight into the memories
+    class file_view {
+    public:
+        explicit file_view(const char *file_name) {
+            int fd = open(file_name, O_RDONLY);
+            if(fd < 0) {
+                return;
+            }
+            struct stat status;
+            if(fstat(fd, &status) == 0 && status.st_size > 0) {
+                size = status.st_size;
+                void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if(mapped != MAP_FAILED) {
+                    mapping = mapped;
+                    data = (const uint8_t *) mapped;
+                } else {
+                    buffer.resize(size);
+                    ssize_t done = pread(fd, buffer.data(), size, 0);
+                    data = done == (ssize_t) size ? buffer.data() : nullptr;
+                }
+            }
+            close(fd);
+        }
+
+        ~file_view() {
+            if(mapping != nullptr) {
+                munmap(mapping, size);
+            }
+        }
+
+        bool contains(uint64_t offset, uint64_t length) const {
+            return offset + length <= size;
+        }
+
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+
+    private:
+        void *mapping = nullptr;
+        std::vector<uint8_t> buffer;
+    };
+
+    // Writes the bytes in memory order, like read_data and read_byte_code do
+    void put_byte(ppc_uint<32> *memory, uint32_t address, uint8_t value) {
+        uint32_t lane = (address & 3) * 8;
+        memory[address >> 2](lane + 7, lane) = value;
+    }
+}
+
+int32_t read_elf(const char *file_name, ppc_uint<32> *instruction_memory, uint32_t instruction_memory_size,
+                 ppc_uint<32> *data_memory, uint32_t data_memory_size, uint32_t &entry_point) {
+    file_view file(file_name);
+    if(file.data == nullptr) {
+        std::cout << "Failed to open file " << file_name << "!" << std::endl;
+        return -1;
+    }
+    const uint8_t *header = file.data;
+    if(!file.contains(0, ELF_HEADER_SIZE) || memcmp(header, ELF_MAGIC, sizeof(ELF_MAGIC)) != 0 ||
+       header[4] != ELF_CLASS_32 || header[5] != ELF_DATA_BIG_ENDIAN || get16(header + 18) != ELF_MACHINE_PPC) {
+        std::cout << file_name << " is no big endian 32 bit PowerPC ELF file!" << std::endl;
+        return -1;
+    }
+    entry_point = get32(header + 24);
+
+    std::vector<segment_t> segments;
+    uint32_t program_headers = get32(header + 28);
+    uint32_t program_header_count = get16(header + 44);
+    uint32_t section_headers = get32(header + 32);
+    uint32_t section_header_count = get16(header + 48);
+    if(get16(header + 16) != ELF_TYPE_RELOCATABLE && program_header_count > 0) {
+        if(!file.contains(program_headers, (uint64_t) program_header_count * PROGRAM_HEADER_SIZE)) {
+            std::cout << "The program headers of " << file_name << " are truncated!" << std::endl;
+            return -1;
+        }
+        for(uint32_t i = 0; i < program_header_count; i++) {
+            const uint8_t *entry = file.data + program_headers + i * PROGRAM_HEADER_SIZE;
+            if(get32(entry) == PT_LOAD) {
+                segments.push_back({get32(entry + 8), get32(entry + 4), get32(entry + 16), get32(entry + 20),
+                                    (get32(entry + 24) & PF_X) != 0});
+            }
+        }
+    } else {
+        // Like objcopy, relocatable objects are loaded at the addresses of their sections without relocation
+        if(!file.contains(section_headers, (uint64_t) section_header_count * SECTION_HEADER_SIZE)) {
+            std::cout << "The section headers of " << file_name << " are truncated!" << std::endl;
+            return -1;
+        }
+        for(uint32_t i = 0; i < section_header_count; i++) {
+            const uint8_t *entry = file.data + section_headers + i * SECTION_HEADER_SIZE;
+            uint32_t type = get32(entry + 4);
+            uint32_t flags = get32(entry + 8);
+            if((flags & SHF_ALLOC) && (type == SHT_PROGBITS || type == SHT_NOBITS)) {
+                uint32_t size = get32(entry + 20);
+                segments.push_back({get32(entry + 12), get32(entry + 16), type == SHT_NOBITS ? 0 : size, size,
+                                    (flags & SHF_EXECINSTR) != 0});
+            }
+        }
+    }
+
+    uint32_t program_size = 0;
+    for(const segment_t &segment : segments) {
+        if(segment.memory_size == 0) {
+            continue;
+        }
+        ppc_uint<32> *memory = segment.executable ? instruction_memory : data_memory;
+        uint32_t memory_size = segment.executable ? instruction_memory_size : data_memory_size;
+        if(!file.contains(segment.offset, segment.file_size) || segment.file_size > segment.memory_size) {
+            std::cout << "A segment of " << file_name << " is truncated!" << std::endl;
+            return -1;
+        }
+        if(memory == nullptr || (uint64_t) segment.address + segment.memory_size > (uint64_t) memory_size * 4) {
+            std::cout << (segment.executable ? "The instruction memory" : "The data memory")
+                      << " is not big enough!" << std::endl;
+            return -1;
+        }
+        if(segment.executable && (segment.address % 4 != 0 || segment.memory_size % 4 != 0)) {
+            std::cout << "The instructions of " << file_name << " aren't word aligned!" << std::endl;
+            return -1;
+        }
+
+        const uint8_t *bytes = file.data + segment.offset;
+        for(uint32_t i = 0; i < segment.memory_size; i++) {
+            put_byte(memory, segment.address + i, i < segment.file_size ? bytes[i] : 0);
+        }
+        if(segment.executable) {
+            prepare_instructions(instruction_memory + segment.address / 4, segment.memory_size / 4);
+            program_size = std::max(program_size, (segment.address + segment.memory_size) / 4);
+        }
+    }
+    return program_size;
+}
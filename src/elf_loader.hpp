@@ -0,0 +1,38 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_ELF_LOADER_HPP
+#define POWERPC_HLS_ELF_LOADER_HPP
+
+#include <stdint.h>
+#include "ppc_int.hpp"
+
+// Software simulation only!
+// Loads an ELF32 big endian PowerPC file, which replaces the conversion with objcopy into a flat binary.
+// Executables are loaded by their PT_LOAD segments, relocatable objects without program headers (e.g. the output
+// of the assembler) by their allocated sections, both at their link address. Executable segments go into the
+// instruction memory and are prepared for fetching (see prepare_instructions), all others into the data memory.
+// Sizes are in words like for read_byte_code and read_data. Returns the size of the program in words, which is
+// the end of the highest executable segment, or -1 on errors. entry_point receives the entry of the ELF header.
+int32_t read_elf(const char *file_name, ppc_uint<32> *instruction_memory, uint32_t instruction_memory_size,
+                 ppc_uint<32> *data_memory, uint32_t data_memory_size, uint32_t &entry_point);
+
+#endif //POWERPC_HLS_ELF_LOADER_HPP
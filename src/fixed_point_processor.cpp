@@ -23,8 +23,8 @@
 #include "fixed_point_utils.hpp"
 
 void fixed_point::add_sub(add_sub_decode_t decoded, registers_t &registers) {
-    ap_uint<32> op1;
-    ap_uint<32> op2;
+    ppc_uint<32> op1;
+    ppc_uint<32> op2;
 
     if (decoded.op1_imm) {
         op1 = decoded.op1_immediate;
@@ -38,7 +38,7 @@ void fixed_point::add_sub(add_sub_decode_t decoded, registers_t &registers) {
         op2 = registers.GPR[decoded.op2_reg_address];
     }
 
-    ap_uint<1> carry_in;
+    ppc_uint<1> carry_in;
     if (decoded.subtract) {
         // Two's complement
         op1 = ~op1;
@@ -73,7 +73,7 @@ void fixed_point::add_sub(add_sub_decode_t decoded, registers_t &registers) {
 }
 
 void fixed_point::multiply(mul_decode_t decoded, registers_t &registers) {
-    ap_int<33> op1, op2;
+    ppc_int<33> op1, op2;
 
     op1 = registers.GPR[decoded.op1_reg_address];
     if (decoded.op2_imm) {
@@ -92,10 +92,10 @@ void fixed_point::multiply(mul_decode_t decoded, registers_t &registers) {
         op2[32] = 0;
     }
 
-    ap_int<66> op_result = op1 * op2;
+    ppc_int<66> op_result = op1 * op2;
     // Choose upper or lower part of result
     uint32_t result = decoded.mul_higher ? op_result(63, 32) : op_result(31, 0);
-    ap_uint<1> overflow;
+    ppc_uint<1> overflow;
 
     registers.GPR[decoded.result_reg_address] = result;
 
@@ -133,8 +133,8 @@ void fixed_point::multiply(mul_decode_t decoded, registers_t &registers) {
 }
 
 void fixed_point::divide(div_decode_t decoded, registers_t &registers) {
-    ap_int<33> signed_dividend;
-    ap_int<33> signed_divisor;
+    ppc_int<33> signed_dividend;
+    ppc_int<33> signed_divisor;
     signed_dividend(31, 0) = registers.GPR[decoded.dividend_reg_address];
     signed_divisor(31, 0) = registers.GPR[decoded.divisor_reg_address];
     if (decoded.div_signed) {
@@ -147,7 +147,7 @@ void fixed_point::divide(div_decode_t decoded, registers_t &registers) {
         signed_divisor[32] = 0;
     }
 
-    ap_int<32> quotient;
+    ppc_int<32> quotient;
     // avoid division by zero, since this will raise an exception, when executed in software
     if (signed_divisor != 0) {
         quotient = signed_dividend / signed_divisor;
@@ -157,7 +157,7 @@ void fixed_point::divide(div_decode_t decoded, registers_t &registers) {
 
     registers.GPR[decoded.result_reg_address] = quotient;
 
-    ap_uint<1> overflow;
+    ppc_uint<1> overflow;
 
     if (signed_divisor == 0 || (signed_divisor == -1 && signed_dividend(31, 0) == 0x80000000)) {
         // divide by zero and the most negative number divided by -1 (the result wouldn't fit in 32 bits) is undefined
@@ -178,7 +178,7 @@ void fixed_point::divide(div_decode_t decoded, registers_t &registers) {
 }
 
 void fixed_point::compare(cmp_decode_t decoded, registers_t &registers) {
-    ap_int<33> op1, op2;
+    ppc_int<33> op1, op2;
 
     op1(31, 0) = registers.GPR[decoded.op1_reg_address];
     if (decoded.op2_imm) {
@@ -195,24 +195,20 @@ void fixed_point::compare(cmp_decode_t decoded, registers_t &registers) {
         op2[32] = 0;
     }
 
-    condition_field &CR = registers.condition_reg[decoded.BF];
-
+    uint32_t result;
     if (op1 < op2) {
-        CR.condition_fixed_point.LT = 1;
-        CR.condition_fixed_point.GT = 0;
-        CR.condition_fixed_point.EQ = 0;
+        result = CR_LT;
     } else if (op1 > op2) {
-        CR.condition_fixed_point.LT = 0;
-        CR.condition_fixed_point.GT = 1;
-        CR.condition_fixed_point.EQ = 0;
+        result = CR_GT;
     } else { // op1 == op2
-        CR.condition_fixed_point.LT = 0;
-        CR.condition_fixed_point.GT = 0;
-        CR.condition_fixed_point.EQ = 1;
+        result = CR_EQ;
     }
 
     // Copy SO into the given SPR
-    CR.condition_fixed_point.SO = registers.fixed_exception_reg.exception_fields.SO;
+    if (registers.fixed_exception_reg.exception_fields.SO == 1) {
+        result |= CR_SO;
+    }
+    registers.condition_reg.set_field(decoded.BF, result);
 }
 
 bool fixed_point::trap(trap_decode_t decoded, registers_t &registers) {
@@ -228,7 +224,7 @@ bool fixed_point::trap(trap_decode_t decoded, registers_t &registers) {
     uint32_t u_op1 = op1;
     uint32_t u_op2 = op2;
 
-    ap_uint<5> TO = decoded.TO;
+    ppc_uint<5> TO = decoded.TO;
 
     return (
             (op1 < op2 && TO[4] == 1) ||
@@ -240,8 +236,8 @@ bool fixed_point::trap(trap_decode_t decoded, registers_t &registers) {
 }
 
 void fixed_point::logical(log_decode_t decoded, registers_t &registers) {
-    ap_uint<32> op1 = registers.GPR[decoded.op1_reg_address];
-    ap_uint<32> op2;
+    ppc_uint<32> op1 = registers.GPR[decoded.op1_reg_address];
+    ppc_uint<32> op2;
 
     if (decoded.op2_imm) {
         op2 = decoded.op2_immediate;
@@ -249,7 +245,7 @@ void fixed_point::logical(log_decode_t decoded, registers_t &registers) {
         op2 = registers.GPR[decoded.op2_reg_address];
     }
 
-    ap_uint<32> result;
+    ppc_uint<32> result;
 
     switch (decoded.operation) {
         case logical::AND:
@@ -297,7 +293,7 @@ void fixed_point::logical(log_decode_t decoded, registers_t &registers) {
             }
             break;
         case logical::COUNT_LEDING_ZEROS_WORD: {
-            ap_uint<6> count = 0;
+            ppc_uint<6> count = 0;
             for (int32_t i = 31; i >= 0; i--) {
 #pragma HLS unroll
                 if (op1[i] == 0) {
@@ -314,8 +310,8 @@ void fixed_point::logical(log_decode_t decoded, registers_t &registers) {
             case logical::POPULATION_COUNT_BYTES:
                 for(int32_t b = 0; b < 4; b++) {
 #pragma HLS unroll
-                    ap_uint<4> count = 0;
-                    ap_uint<8> byte = op1((b+1)*8-1, b*8);
+                    ppc_uint<4> count = 0;
+                    ppc_uint<8> byte = op1((b+1)*8-1, b*8);
                     for(uint32_t i = 0; i < 8; i++) {
 #pragma HLS unroll
                         if(byte[i] == 1) {
@@ -337,16 +333,16 @@ void fixed_point::logical(log_decode_t decoded, registers_t &registers) {
 }
 
 void fixed_point::rotate(rotate_decode_t decoded, registers_t &registers) {
-    ap_uint<32> source = registers.GPR[decoded.source_reg_address];
-    ap_uint<6> shift;
+    ppc_uint<32> source = registers.GPR[decoded.source_reg_address];
+    ppc_uint<6> shift;
     if (decoded.shift_imm) {
         shift = decoded.shift_immediate;
     } else {
         shift = registers.GPR[decoded.shift_reg_address](5, 0);
     }
 
-    ap_uint<5> mask_begin = 0;
-    ap_uint<5> mask_end = 0;
+    ppc_uint<5> mask_begin = 0;
+    ppc_uint<5> mask_end = 0;
 
     bool compute_mask;
 
@@ -388,7 +384,7 @@ void fixed_point::rotate(rotate_decode_t decoded, registers_t &registers) {
         compute_mask = true;
     }
 
-    ap_uint<32> mask = 0;
+    ppc_uint<32> mask = 0;
 
     if(compute_mask) {
         // Generate the mask
@@ -413,26 +409,26 @@ void fixed_point::rotate(rotate_decode_t decoded, registers_t &registers) {
         }
     }
 
-    ap_uint<32> shifted;
+    ppc_uint<32> shifted;
     // Rotate left
     for (uint32_t i = 0; i < 32; i++) {
 #pragma HLS unroll
-        ap_uint<5> target_index = i + shift(4, 0);
+        ppc_uint<5> target_index = i + shift(4, 0);
         shifted[target_index] = source[i];
     }
 
-    ap_uint<32> result;
+    ppc_uint<32> result;
     if (decoded.mask_insert) {
         result = (shifted & mask) | (registers.GPR[decoded.target_reg_address] & ~mask);
     } else if(decoded.shift && !decoded.left && decoded.sign_extend) {
-        ap_uint<32> sign;
+        ppc_uint<32> sign;
         if(source[31] == 1) {
             sign = 0xFFFFFFFF;
         } else {
             sign = 0;
         }
         result = (shifted & mask) | (sign & ~mask);
-        ap_uint<1> carry = sign & ((shifted & ~mask) != 0);
+        ppc_uint<1> carry = sign & ((shifted & ~mask) != 0);
         registers.fixed_exception_reg.exception_fields.CA = carry;
     } else {
         result = shifted & mask;
@@ -449,12 +445,12 @@ void fixed_point::rotate(rotate_decode_t decoded, registers_t &registers) {
 
 void fixed_point::system(system_decode_t decoded, registers_t &registers) {
     // The order of the two 5 bit halves is reversed
-    ap_uint<10> SPR;
+    ppc_uint<10> SPR;
     SPR(4, 0) = decoded.SPR(9, 5);
     SPR(9, 5) = decoded.SPR(4, 0);
 
-    ap_uint<8> FXM = decoded.FXM;
-    ap_uint<32> mask;
+    ppc_uint<8> FXM = decoded.FXM;
+    ppc_uint<32> mask;
     for (uint32_t n = 0, b = 0; n < 8; n++) {
 #pragma HLS unroll
         for (uint32_t i = 0; i < 4; i++) {
@@ -24,10 +24,48 @@
 #define __FIXED_POINT_PROCESSOR__
 
 #include <stdint.h>
-#include <ap_int.h>
+#include "ppc_int.hpp"
 #include "ppc_types.h"
+#ifndef __SYNTHESIS__
+#include "mmio.hpp"
+#endif
 
 namespace fixed_point {
+    // Memory words hold the byte with the lowest address in bits 7 to 0, registers are big endian
+    inline ppc_uint<32> reverse_bytes(ppc_uint<32> word) {
+#pragma HLS inline
+#ifndef __SYNTHESIS__
+        return __builtin_bswap32((uint32_t) word);
+#else
+        ppc_uint<32> reversed;
+        reversed(31, 24) = word(7, 0);
+        reversed(23, 16) = word(15, 8);
+        reversed(15, 8) = word(23, 16);
+        reversed(7, 0) = word(31, 24);
+        return reversed;
+#endif
+    }
+
+    // lmw with a word aligned address: the registers RT to 31 are read as one burst of consecutive words
+    template<typename T>
+    void load_multiple(ppc_uint<5> first_register, ppc_uint<30> upper_address, registers_t &registers, T data_memory) {
+        for (int32_t i = first_register; i < 32; i++) {
+#pragma HLS pipeline II=1
+#pragma HLS loop_tripcount min=1 max=32 avg=16
+            registers.GPR[i] = reverse_bytes(data_memory[upper_address + (i - first_register)]);
+        }
+    }
+
+    // stmw with a word aligned address: the registers RS to 31 are written as one burst of consecutive words
+    template<typename T>
+    void store_multiple(ppc_uint<5> first_register, ppc_uint<30> upper_address, registers_t &registers, T data_memory) {
+        for (int32_t i = first_register; i < 32; i++) {
+#pragma HLS pipeline II=1
+#pragma HLS loop_tripcount min=1 max=32 avg=16
+            data_memory[upper_address + (i - first_register)] = reverse_bytes(registers.GPR[i]);
+        }
+    }
+
     template<typename T>
     void load(load_store_decode_t decoded, registers_t &registers, T data_memory) {
         uint32_t sum1, sum2;
@@ -43,12 +81,60 @@ namespace fixed_point {
             sum2 = registers.GPR[decoded.sum2_reg_address];
         }
 
-        ap_uint<32> effective_address = sum1 + sum2;
-        ap_uint<30> upper_address = effective_address(31, 2);
-        ap_uint<2> lower_address = effective_address;
+        ppc_uint<32> effective_address = sum1 + sum2;
+#ifndef __SYNTHESIS__
+        // lmw and stmw cover all registers up to r31, unaligned accesses may reach into the next word
+        uint32_t access_size = decoded.multiple ? (32 - (uint32_t) decoded.result_reg_address) * 4 :
+                               (uint32_t) decoded.word_size + 1;
+        if (mmio::overlaps(effective_address, access_size)) {
+            mmio::load(decoded, effective_address, registers, mmio::ram(data_memory));
+            return;
+        }
+#endif
+        ppc_uint<30> upper_address = effective_address(31, 2);
+        ppc_uint<2> lower_address = effective_address;
+
+        if (decoded.multiple && lower_address == 0) {
+            load_multiple<T>(decoded.result_reg_address, upper_address, registers, data_memory);
+            return;
+        }
+
+#ifndef __SYNTHESIS__
+        // Software simulation only: naturally aligned accesses need a single word access and a byte swap
+        if (!decoded.multiple && decoded.word_size != 2 && ((uint32_t) lower_address & (uint32_t) decoded.word_size) == 0) {
+            uint32_t word = data_memory[upper_address];
+            uint32_t value;
+            switch (decoded.word_size) {
+                case 0: // Byte
+                    value = (word >> (lower_address * 8)) & 0xFF;
+                    if (decoded.sign_extend) {
+                        value = (int32_t) (int8_t) value;
+                    }
+                    break;
+                case 1: // Halfword
+                    value = (word >> (lower_address * 8)) & 0xFFFF;
+                    if (!decoded.little_endian) {
+                        value = __builtin_bswap16(value);
+                    }
+                    if (decoded.sign_extend) {
+                        value = (int32_t) (int16_t) value;
+                    }
+                    break;
+                default: // Word
+                    value = decoded.little_endian ? word : __builtin_bswap32(word);
+                    break;
+            }
+            registers.GPR[decoded.result_reg_address] = value;
+
+            if (decoded.write_ea) {
+                registers.GPR[decoded.ea_reg_address] = effective_address;
+            }
+            return;
+        }
+#endif
 
-        ap_uint<32> interm;
-        ap_uint<32> result = 0;
+        ppc_uint<32> interm;
+        ppc_uint<32> result = 0;
 
         int32_t n;
         if (decoded.multiple) {
@@ -205,9 +291,57 @@ namespace fixed_point {
             sum2 = registers.GPR[decoded.sum2_reg_address];
         }
 
-        ap_uint<32> effective_address = sum1 + sum2;
-        ap_uint<30> upper_address = effective_address(31, 2);
-        ap_uint<2> lower_address = effective_address;
+        ppc_uint<32> effective_address = sum1 + sum2;
+#ifndef __SYNTHESIS__
+        // lmw and stmw cover all registers up to r31, unaligned accesses may reach into the next word
+        uint32_t access_size = decoded.multiple ? (32 - (uint32_t) decoded.result_reg_address) * 4 :
+                               (uint32_t) decoded.word_size + 1;
+        if (mmio::overlaps(effective_address, access_size)) {
+            mmio::store(decoded, effective_address, registers, mmio::ram(data_memory));
+            return;
+        }
+#endif
+        ppc_uint<30> upper_address = effective_address(31, 2);
+        ppc_uint<2> lower_address = effective_address;
+
+        if (decoded.multiple && lower_address == 0) {
+            store_multiple<T>(decoded.result_reg_address, upper_address, registers, data_memory);
+            return;
+        }
+
+#ifndef __SYNTHESIS__
+        // Software simulation only: naturally aligned accesses need a single word access and a byte swap
+        if (!decoded.multiple && decoded.word_size != 2 && ((uint32_t) lower_address & (uint32_t) decoded.word_size) == 0) {
+            uint32_t value = registers.GPR[decoded.result_reg_address];
+            uint32_t mask;
+            switch (decoded.word_size) {
+                case 0: // Byte
+                    mask = 0xFF;
+                    value &= 0xFF;
+                    break;
+                case 1: // Halfword
+                    mask = 0xFFFF;
+                    value = decoded.little_endian ? value & 0xFFFF : __builtin_bswap16(value);
+                    break;
+                default: // Word
+                    mask = 0xFFFFFFFF;
+                    value = decoded.little_endian ? value : __builtin_bswap32(value);
+                    break;
+            }
+            if (mask == 0xFFFFFFFF) {
+                data_memory[upper_address] = value;
+            } else {
+                uint32_t shift = lower_address * 8;
+                uint32_t word = data_memory[upper_address];
+                data_memory[upper_address] = (word & ~(mask << shift)) | (value << shift);
+            }
+
+            if (decoded.write_ea) {
+                registers.GPR[decoded.ea_reg_address] = effective_address;
+            }
+            return;
+        }
+#endif
 
         int32_t n;
         if (decoded.multiple) {
@@ -218,7 +352,7 @@ namespace fixed_point {
 
         for (int32_t i = decoded.result_reg_address; i < n; i++) {
 #pragma HLS loop_tripcount min=1 max=32 avg=16
-            ap_uint<32> result = registers.GPR[i];
+            ppc_uint<32> result = registers.GPR[i];
             switch (decoded.word_size) {
                 case 0: // Byte
                     data_memory[upper_address]((lower_address + 1) * 8 - 1, lower_address * 8) = result(7, 0);
@@ -333,8 +467,8 @@ namespace fixed_point {
     template<typename T>
     void load_string(load_store_decode_t decoded, registers_t &registers, T data_memory) {
         uint32_t sum1, sum2;
-        ap_uint<7> n;
-        ap_uint<5> r = decoded.result_reg_address - 1;
+        ppc_uint<7> n;
+        ppc_uint<5> r = decoded.result_reg_address - 1;
         if (decoded.sum1_imm) {
             sum1 = (int32_t) decoded.sum1_immediate;
         } else {
@@ -355,26 +489,49 @@ namespace fixed_point {
             n = registers.fixed_exception_reg.exception_fields.string_bytes;
         }
 
-        ap_uint<32> ea = sum1 + sum2;
-        for (ap_uint<2> i = 3; n > 0; i--, n--, ea++) {
-//#pragma HLS unroll factor=4 TODO: write the loop in a way, that 4 bytes accesses the memory once
-#pragma HLS loop_tripcount min=1 max=120 avg=32
-            if (i == 3) {
-                r++;
-                registers.GPR[r] = 0;
+        ppc_uint<32> ea = sum1 + sum2;
+#ifndef __SYNTHESIS__
+        if (mmio::overlaps(ea, n)) {
+            mmio::load_string(decoded.result_reg_address, n, ea, registers, mmio::ram(data_memory));
+            return;
+        }
+#endif
+        // Every register takes up to four bytes, which lie in at most two memory words
+        for (; n > 0; ea += 4) {
+#pragma HLS loop_tripcount min=1 max=32 avg=8
+            r++;
+            ppc_uint<30> upper_address = ea(31, 2);
+            ppc_uint<2> lower_address = ea;
+            ppc_uint<3> bytes = n > 4 ? (ppc_uint<7>) 4 : n;
+
+            ppc_uint<32> first_word = data_memory[upper_address];
+            ppc_uint<64> memory_bytes = first_word;
+            if (lower_address + bytes > 4) {
+                ppc_uint<32> second_word = data_memory[upper_address + 1];
+                memory_bytes(63, 32) = second_word;
             }
-            ap_uint<30> upper_address = ea(31, 2);
-            ap_uint<2> lower_address = ea;
-            registers.GPR[r]((i + 1) * 8 - 1, i * 8) =
-                    data_memory[upper_address]((lower_address + 1) * 8 - 1,lower_address * 8);
+            ppc_uint<32> interm = memory_bytes >> (lower_address * 8);
+
+            // The first byte in memory is the most significant byte of the register
+            ppc_uint<32> result;
+            result(31, 24) = interm(7, 0);
+            result(23, 16) = interm(15, 8);
+            result(15, 8) = interm(23, 16);
+            result(7, 0) = interm(31, 24);
+            if (bytes < 4) {
+                // The remaining bytes of the last register are cleared
+                result = result & ~((ppc_uint<32>) 0xFFFFFFFF >> (bytes * 8));
+            }
+            registers.GPR[r] = result;
+            n -= bytes;
         }
     }
 
     template<typename T>
     void store_string(load_store_decode_t decoded, registers_t &registers, T data_memory) {
         uint32_t sum1, sum2;
-        ap_uint<7> n;
-        ap_uint<5> r = decoded.result_reg_address - 1;
+        ppc_uint<7> n;
+        ppc_uint<5> r = decoded.result_reg_address - 1;
         if (decoded.sum1_imm) {
             sum1 = (int32_t) decoded.sum1_immediate;
         } else {
@@ -395,17 +552,45 @@ namespace fixed_point {
             n = registers.fixed_exception_reg.exception_fields.string_bytes;
         }
 
-        ap_uint<32> ea = sum1 + sum2;
-        for (ap_uint<2> i = 3; n > 0; i--, n--, ea++) {
-//#pragma HLS unroll factor=4 TODO: write the loop in a way, that 4 bytes accesses the memory once
-#pragma HLS loop_tripcount min=1 max=120 avg=32
-            if (i == 3) {
-                r++;
+        ppc_uint<32> ea = sum1 + sum2;
+#ifndef __SYNTHESIS__
+        if (mmio::overlaps(ea, n)) {
+            mmio::store_string(decoded.result_reg_address, n, ea, registers, mmio::ram(data_memory));
+            return;
+        }
+#endif
+        // Every register provides up to four bytes, which lie in at most two memory words
+        for (; n > 0; ea += 4) {
+#pragma HLS loop_tripcount min=1 max=32 avg=8
+            r++;
+            ppc_uint<30> upper_address = ea(31, 2);
+            ppc_uint<2> lower_address = ea;
+            ppc_uint<3> bytes = n > 4 ? (ppc_uint<7>) 4 : n;
+
+            // The most significant byte of the register is the first byte in memory
+            ppc_uint<32> source = registers.GPR[r];
+            ppc_uint<32> interm;
+            interm(31, 24) = source(7, 0);
+            interm(23, 16) = source(15, 8);
+            interm(15, 8) = source(23, 16);
+            interm(7, 0) = source(31, 24);
+
+            ppc_uint<64> mask = ((ppc_uint<64>) 0xFFFFFFFF >> ((4 - bytes) * 8)) << (lower_address * 8);
+            ppc_uint<64> value = ((ppc_uint<64>) interm << (lower_address * 8)) & mask;
+
+            ppc_uint<32> first_word = data_memory[upper_address];
+            ppc_uint<64> memory_bytes = first_word;
+            if (lower_address + bytes > 4) {
+                ppc_uint<32> second_word = data_memory[upper_address + 1];
+                memory_bytes(63, 32) = second_word;
+            }
+            memory_bytes = (memory_bytes & ~mask) | value;
+
+            data_memory[upper_address] = memory_bytes(31, 0);
+            if (lower_address + bytes > 4) {
+                data_memory[upper_address + 1] = memory_bytes(63, 32);
             }
-            ap_uint<30> upper_address = ea(31, 2);
-            ap_uint<2> lower_address = ea;
-            data_memory[upper_address]((lower_address + 1) * 8 - 1, lower_address * 8) =
-                    registers.GPR[r]((i + 1) * 8 - 1, i * 8);
+            n -= bytes;
         }
     }
 
@@ -22,30 +22,32 @@
 #include "fixed_point_utils.hpp"
 
 void fixed_point::check_condition(int32_t result, registers_t &registers) {
-    condition_field &CR = registers.condition_reg[0];
+#ifdef LAZY_FLAGS
+    // The summary overflow is final at this point, copy_summary_overflow will not change it
+    registers.condition_reg.defer_CR0(result, registers.fixed_exception_reg.exception_fields.SO);
+#else
+    uint32_t SO = registers.condition_reg.field(0) & CR_SO;
 	if(result == 0) {
-		// CR0 is at position 7
-		CR.condition_fixed_point.LT = 0;
-        CR.condition_fixed_point.GT = 0;
-        CR.condition_fixed_point.EQ = 1;
+		registers.condition_reg.set_field(0, CR_EQ | SO);
 	} else if(result < 0) {
-		// CR0 is at position 7
-        CR.condition_fixed_point.LT = 1;
-        CR.condition_fixed_point.GT = 0;
-        CR.condition_fixed_point.EQ = 0;
+        registers.condition_reg.set_field(0, CR_LT | SO);
 	} else { // > 0
-		// CR0 is at position 7
-        CR.condition_fixed_point.LT = 0;
-        CR.condition_fixed_point.GT = 1;
-        CR.condition_fixed_point.EQ = 0;
+        registers.condition_reg.set_field(0, CR_GT | SO);
 	}
+#endif
 }
 
 void fixed_point::copy_summary_overflow(registers_t &registers) {
+#ifdef LAZY_FLAGS
+    if(registers.condition_reg.CR0_pending) {
+        registers.condition_reg.CR0_SO = registers.fixed_exception_reg.exception_fields.SO;
+        return;
+    }
+#endif
     registers.condition_reg[0].condition_fixed_point.SO = registers.fixed_exception_reg.exception_fields.SO;
 }
 
-void fixed_point::set_overflow(ap_uint<1> overflow, registers_t &registers) {
+void fixed_point::set_overflow(ppc_uint<1> overflow, registers_t &registers) {
 	registers.fixed_exception_reg.exception_fields.OV = overflow;
 	// SO bit is sticky
 	if(registers.fixed_exception_reg.exception_fields.SO == 0) {
@@ -24,7 +24,7 @@
 #define __FIXED_POINT_UTILS__
 
 #include <stdint.h>
-#include <ap_int.h>
+#include "ppc_int.hpp"
 #include "ppc_types.h"
 
 namespace fixed_point {
@@ -33,28 +33,28 @@ namespace fixed_point {
 
     void copy_summary_overflow(registers_t &registers);
 
-    void set_overflow(ap_uint<1> overflow, registers_t &registers);
+    void set_overflow(ppc_uint<1> overflow, registers_t &registers);
 
     template<int T>
     struct add_result {
-        ap_uint<T> sum;
-        ap_uint<1> carry;
-        ap_uint<1> overflow;
+        ppc_uint<T> sum;
+        ppc_uint<1> carry;
+        ppc_uint<1> overflow;
     };
 
     template<int T>
-    add_result<T> add(ap_uint<T> op1, ap_uint<T> op2, ap_uint<1> carry_in) {
+    add_result<T> add(ppc_uint<T> op1, ppc_uint<T> op2, ppc_uint<1> carry_in) {
         fixed_point::add_result<T> result;
 
 #ifdef OWN_ADDER
-        ap_uint<T+1> carry;
+        ppc_uint<T+1> carry;
 
         carry[0] = carry_in;
 
         // helper signals
-        ap_uint<T> sum = op1 ^ op2;
-        ap_uint<T> carry_generate = op1 & op2;
-        ap_uint<T> carry_propagate = op1 | op2;
+        ppc_uint<T> sum = op1 ^ op2;
+        ppc_uint<T> carry_generate = op1 & op2;
+        ppc_uint<T> carry_propagate = op1 | op2;
 
         // adder
         for(int32_t i = 0; i < T; i++) {
@@ -66,7 +66,7 @@ namespace fixed_point {
         result.carry = carry[T];
         result.overflow = carry[T] ^ carry[T-1];
 #else
-        ap_uint<T+1> sum = op1 + op2 + carry_in;
+        ppc_uint<T+1> sum = op1 + op2 + carry_in;
         if((op1[T-1] == 1 && op2[T-1] == 1 && sum[T-1] == 0) ||
          (op1[T-1] == 0 && op2[T-1] == 0 && sum[T-1] == 1)) {
           result.overflow = 1;
@@ -26,13 +26,12 @@
 
 #include "instruction_decode.hpp"
 #include "decode_utils.hpp"
+#include "micro_op.hpp"
 
-decode_result_t pipeline::decode(uint32_t instruction_port) {
+micro_op_t pipeline::decode(uint32_t instruction_port) {
 //#pragma HLS pipeline
 	instruction_t instruction;
-	instruction = ap_uint<32>(instruction_port);
-
-	decode_result_t decode_result;
+	instruction = ppc_uint<32>(instruction_port);
 
 	// branch processor decode structures
 	branch_decode_result_t branch_result;
@@ -77,38 +76,6 @@ decode_result_t pipeline::decode(uint32_t instruction_port) {
 	system_decode_t system_decoded;
 	init_system(system_decoded)
 
-	// floating point processor decode structures
-	floating_point_decode_result_t floating_point_decode_result;
-	floating_point_decode_result.execute_load = false;
-	floating_point_decode_result.execute_store = false;
-	floating_point_decode_result.execute_move = false;
-	floating_point_decode_result.execute_arithmetic = false;
-	floating_point_decode_result.execute_madd = false;
-	floating_point_decode_result.execute_convert = false;
-	floating_point_decode_result.execute_compare = false;
-	floating_point_decode_result.execute_status = false;
-
-	float_load_store_decode_t float_load_store_decoded;
-	init_load_store(float_load_store_decoded)
-
-	float_move_decode_t float_move_decoded;
-	init_float_move(float_move_decoded)
-
-	float_arithmetic_decode_t float_arithmetic_decoded;
-	init_float_arithmetic(float_arithmetic_decoded)
-
-	float_madd_decode_t float_madd_decoded;
-	init_float_madd(float_madd_decoded)
-
-	float_convert_decode_t float_convert_decoded;
-	init_float_convert(float_convert_decoded)
-
-	float_compare_decode_t float_compare_decoded;
-	init_float_compare(float_compare_decoded)
-
-	float_status_decode_t float_status_decoded;
-	init_float_status(float_status_decoded)
-
 	switch(instruction.I_Form.OPCD) {
 		// B Form Branch instructions
 		case 16: // bc, bca, bcl, bcla
@@ -1213,43 +1180,6 @@ decode_result_t pipeline::decode(uint32_t instruction_port) {
 					system_decoded.SPR = instruction.XFX_Form.spr;
 					system_decoded.FXM = 0;
 					break;
-				// X Form floating point Load/Store instructions
-				case 535: // lfsx
-					floating_point_decode_result.execute_load = true;
-					decode_load_store_and_zero_x_form(float_load_store_decoded, instruction, 4)
-					break;
-				case 567: // lfsux
-					floating_point_decode_result.execute_load = true;
-					decode_load_store_and_zero_with_update_x_form(float_load_store_decoded, instruction, 4)
-					break;
-				case 599: // lfdx
-					floating_point_decode_result.execute_load = true;
-					decode_load_store_and_zero_x_form(float_load_store_decoded, instruction, 8)
-					break;
-				case 631: // lfdux
-					floating_point_decode_result.execute_load = true;
-					decode_load_store_and_zero_with_update_x_form(float_load_store_decoded, instruction, 8)
-					break;
-				case 663: // stfsx
-					floating_point_decode_result.execute_store = true;
-					decode_load_store_and_zero_x_form(float_load_store_decoded, instruction, 4)
-					break;
-				case 695: // stfsux
-					floating_point_decode_result.execute_store = true;
-					decode_load_store_and_zero_with_update_x_form(float_load_store_decoded, instruction, 4)
-					break;
-				case 727: // stfdx
-					floating_point_decode_result.execute_store = true;
-					decode_load_store_and_zero_x_form(float_load_store_decoded, instruction, 8)
-					break;
-				case 759: // stfdux
-					floating_point_decode_result.execute_store = true;
-					decode_load_store_and_zero_with_update_x_form(float_load_store_decoded, instruction, 8)
-					break;
-				case 983: // stfiwx
-					floating_point_decode_result.execute_store = true;
-					// Load decode is used here to be able to reduce the amount of macros, sign extend means that float should be stored as integer
-					decode_load_algebraic_x_form(float_load_store_decoded, instruction, 4)
 					break;
 			}
 			break;
@@ -1352,7 +1282,7 @@ decode_result_t pipeline::decode(uint32_t instruction_port) {
 			add_sub_decoded.op1_immediate = 0;
 			add_sub_decoded.op1_reg_address = instruction.D_Form.RA;
 			add_sub_decoded.op2_imm = true;
-			add_sub_decoded.op2_immediate = ap_int<16>(instruction.D_Form.D);
+			add_sub_decoded.op2_immediate = ppc_int<16>(instruction.D_Form.D);
 			add_sub_decoded.op2_reg_address = 0;
 			add_sub_decoded.result_reg_address = instruction.D_Form.RT;
 			add_sub_decoded.alter_CA = true;
@@ -1367,7 +1297,7 @@ decode_result_t pipeline::decode(uint32_t instruction_port) {
 			add_sub_decoded.op1_immediate = 0;
 			add_sub_decoded.op1_reg_address = instruction.D_Form.RA;
 			add_sub_decoded.op2_imm = true;
-			add_sub_decoded.op2_immediate = ap_int<16>(instruction.D_Form.D);
+			add_sub_decoded.op2_immediate = ppc_int<16>(instruction.D_Form.D);
 			add_sub_decoded.op2_reg_address = 0;
 			add_sub_decoded.result_reg_address = instruction.D_Form.RT;
 			add_sub_decoded.alter_CA = true;
@@ -1382,7 +1312,7 @@ decode_result_t pipeline::decode(uint32_t instruction_port) {
 			add_sub_decoded.op1_immediate = 0;
 			add_sub_decoded.op1_reg_address = instruction.D_Form.RA;
 			add_sub_decoded.op2_imm = true;
-			add_sub_decoded.op2_immediate = ap_int<16>(instruction.D_Form.D);
+			add_sub_decoded.op2_immediate = ppc_int<16>(instruction.D_Form.D);
 			add_sub_decoded.op2_reg_address = 0;
 			add_sub_decoded.result_reg_address = instruction.D_Form.RT;
 			add_sub_decoded.alter_CA = true;
@@ -1403,7 +1333,7 @@ decode_result_t pipeline::decode(uint32_t instruction_port) {
 				add_sub_decoded.op1_reg_address = instruction.D_Form.RA;
 			}
 			add_sub_decoded.op2_imm = true;
-			add_sub_decoded.op2_immediate = ap_int<16>(instruction.D_Form.D);
+			add_sub_decoded.op2_immediate = ppc_int<16>(instruction.D_Form.D);
 			add_sub_decoded.op2_reg_address = 0;
 			add_sub_decoded.result_reg_address = instruction.D_Form.RT;
 			add_sub_decoded.alter_CA = false;
@@ -1438,7 +1368,7 @@ decode_result_t pipeline::decode(uint32_t instruction_port) {
 			fixed_point_decode_result.execute = fixed_point::MUL;
 			mul_decoded.op1_reg_address = instruction.D_Form.RA;
 			mul_decoded.op2_imm = true;
-			mul_decoded.op2_immediate = ap_int<16>(instruction.D_Form.D);
+			mul_decoded.op2_immediate = ppc_int<16>(instruction.D_Form.D);
 			mul_decoded.op2_reg_address = 0;
 			mul_decoded.result_reg_address = instruction.D_Form.RT;
 			mul_decoded.mul_signed = true;
@@ -1466,7 +1396,7 @@ decode_result_t pipeline::decode(uint32_t instruction_port) {
 				cmp_decoded.cmp_signed = true;
 				cmp_decoded.op1_reg_address = instruction.D_Form.RA;
 				cmp_decoded.op2_imm = true;
-				cmp_decoded.op2_immediate = ap_int<16>(instruction.D_Form.D);
+				cmp_decoded.op2_immediate = ppc_int<16>(instruction.D_Form.D);
 				cmp_decoded.op2_reg_address = 0;
 				cmp_decoded.BF = instruction.D_Form.RT(4, 2);
 			}
@@ -1479,7 +1409,7 @@ decode_result_t pipeline::decode(uint32_t instruction_port) {
 			fixed_point_decode_result.execute = fixed_point::TRAP;
 			trap_decoded.op1_reg_address = instruction.D_Form.RA;
 			trap_decoded.op2_imm = true;
-			trap_decoded.op2_immediate = ap_int<16>(instruction.D_Form.D);
+			trap_decoded.op2_immediate = ppc_int<16>(instruction.D_Form.D);
 			trap_decoded.op2_reg_address = 0;
 			trap_decoded.TO = instruction.D_Form.RT;
 			break;
@@ -1547,521 +1477,66 @@ decode_result_t pipeline::decode(uint32_t instruction_port) {
 			log_decoded.result_reg_address = instruction.D_Form.RA;
 			log_decoded.alter_CR0 = true;
 			break;
-		// D Form floating point Load/Store instructions
-		case 48: // lfs
-			floating_point_decode_result.execute_load = true;
-			decode_load_store_and_zero(float_load_store_decoded, instruction, 4)
+
+	}
+
+	// Only one unit is active, pass its decode result as a compact micro-op.
+	// Floating point instructions are not decoded, they result in micro_op::NONE like unknown instructions.
+	micro_op_t decode_result;
+	switch(fixed_point_decode_result.execute) {
+		case fixed_point::LOAD:
+			decode_result = micro_op::pack(micro_op::LOAD, load_store_decoded);
 			break;
-		case 49: // lfsu
-			floating_point_decode_result.execute_load = true;
-			decode_load_store_and_zero_with_update(float_load_store_decoded, instruction, 4)
+		case fixed_point::STORE:
+			decode_result = micro_op::pack(micro_op::STORE, load_store_decoded);
 			break;
-		case 50: // lfd
-			floating_point_decode_result.execute_load = true;
-			decode_load_store_and_zero(float_load_store_decoded, instruction, 8)
+		case fixed_point::LOAD_STRING:
+			decode_result = micro_op::pack(micro_op::LOAD_STRING, load_store_decoded);
 			break;
-		case 51: // lfdu
-			floating_point_decode_result.execute_load = true;
-			decode_load_store_and_zero_with_update(float_load_store_decoded, instruction, 8)
+		case fixed_point::STORE_STRING:
+			decode_result = micro_op::pack(micro_op::STORE_STRING, load_store_decoded);
 			break;
-		case 52: // stfs
-			floating_point_decode_result.execute_store = true;
-			decode_load_store_and_zero(float_load_store_decoded, instruction, 4)
+		case fixed_point::ADD_SUB:
+			decode_result = micro_op::pack(micro_op::ADD_SUB, add_sub_decoded);
 			break;
-		case 53: // stfsu
-			floating_point_decode_result.execute_store = true;
-			decode_load_store_and_zero_with_update(float_load_store_decoded, instruction, 4)
+		case fixed_point::MUL:
+			decode_result = micro_op::pack(micro_op::MUL, mul_decoded);
 			break;
-		case 54: // stfd
-			floating_point_decode_result.execute_store = true;
-			decode_load_store_and_zero(float_load_store_decoded, instruction, 8)
+		case fixed_point::DIV:
+			decode_result = micro_op::pack(micro_op::DIV, div_decoded);
 			break;
-		case 55: // stfdu
-			floating_point_decode_result.execute_store = true;
-			decode_load_store_and_zero_with_update(float_load_store_decoded, instruction, 8)
+		case fixed_point::COMPARE:
+			decode_result = micro_op::pack(micro_op::COMPARE, cmp_decoded);
 			break;
-		case 63:
-			switch(instruction.X_Form.XO) {
-				// X Form floating point Move instructions
-				case 40: // fneg, fneg.
-					floating_point_decode_result.execute_move = true;
-					float_move_decoded.operation = NEGATE;
-					float_move_decoded.source_reg_address = instruction.X_Form.RB;
-					float_move_decoded.target_reg_address = instruction.X_Form.RT;
-					if(instruction.X_Form.Rc == 1) {
-						float_move_decoded.alter_CR1 = true;
-					} else {
-						float_move_decoded.alter_CR1 = false;
-					}
-					break;
-				case 72: // fmr, fmr.
-					floating_point_decode_result.execute_move = true;
-					float_move_decoded.operation = MOVE;
-					float_move_decoded.source_reg_address = instruction.X_Form.RB;
-					float_move_decoded.target_reg_address = instruction.X_Form.RT;
-					if(instruction.X_Form.Rc == 1) {
-						float_move_decoded.alter_CR1 = true;
-					} else {
-						float_move_decoded.alter_CR1 = false;
-					}
-					break;
-				case 136: // fnabs, fnabs.
-					floating_point_decode_result.execute_move = true;
-					float_move_decoded.operation = NEGATIVE_ABSOLUTE;
-					float_move_decoded.source_reg_address = instruction.X_Form.RB;
-					float_move_decoded.target_reg_address = instruction.X_Form.RT;
-					if(instruction.X_Form.Rc == 1) {
-						float_move_decoded.alter_CR1 = true;
-					} else {
-						float_move_decoded.alter_CR1 = false;
-					}
-					break;
-				case 264: // fabs, fabs.
-					floating_point_decode_result.execute_move = true;
-					float_move_decoded.operation = ABSOLUTE;
-					float_move_decoded.source_reg_address = instruction.X_Form.RB;
-					float_move_decoded.target_reg_address = instruction.X_Form.RT;
-					if(instruction.X_Form.Rc == 1) {
-						float_move_decoded.alter_CR1 = true;
-					} else {
-						float_move_decoded.alter_CR1 = false;
-					}
-					break;
-				// X Form floating point Convert instructions
-				case 12: // frsp, frsp.
-					floating_point_decode_result.execute_convert = true;
-					float_convert_decoded.source_reg_address = instruction.X_Form.RB;
-					float_convert_decoded.target_reg_address = instruction.X_Form.RT;
-					float_convert_decoded.round_to_single = true;
-					float_convert_decoded.convert_to_integer = false;
-					float_convert_decoded.round_toward_zero = false;
-					if(instruction.X_Form.Rc == 1) {
-						float_convert_decoded.alter_CR1 = true;
-					} else {
-						float_convert_decoded.alter_CR1 = false;
-					}
-					break;
-				case 14: // fctiw, fctiw.
-					floating_point_decode_result.execute_convert = true;
-					float_convert_decoded.source_reg_address = instruction.X_Form.RB;
-					float_convert_decoded.target_reg_address = instruction.X_Form.RT;
-					float_convert_decoded.round_to_single = false;
-					float_convert_decoded.convert_to_integer = true;
-					float_convert_decoded.round_toward_zero = false;
-					if(instruction.X_Form.Rc == 1) {
-						float_convert_decoded.alter_CR1 = true;
-					} else {
-						float_convert_decoded.alter_CR1 = false;
-					}
-					break;
-				case 15: // fctiwz, fctiwz.
-					floating_point_decode_result.execute_convert = true;
-					float_convert_decoded.source_reg_address = instruction.X_Form.RB;
-					float_convert_decoded.target_reg_address = instruction.X_Form.RT;
-					float_convert_decoded.round_to_single = false;
-					float_convert_decoded.convert_to_integer = true;
-					float_convert_decoded.round_toward_zero = true;
-					if(instruction.X_Form.Rc == 1) {
-						float_convert_decoded.alter_CR1 = true;
-					} else {
-						float_convert_decoded.alter_CR1 = false;
-					}
-					break;
-				case 814: // fctid, fctid.
-					// NOT SUPPORTED!!!
-					break;
-				case 815: // fctidz, fctidz.
-					// NOT SUPPORTED!!!
-					break;
-				case 846: // fcfid, fcfid.
-					// NOT SUPPORTED!!!
-					break;
-				// X Form floating point compare instructions
-				case 0: // fcmpu
-					floating_point_decode_result.execute_compare = true;
-					float_compare_decoded.FRA = instruction.X_Form.RA;
-					float_compare_decoded.FRA = instruction.X_Form.RB;
-					float_compare_decoded.BF = instruction.X_Form.RT(4, 2);
-					float_compare_decoded.unordered = true;
-					break;
-				case 63: // fcmpo
-					floating_point_decode_result.execute_compare = true;
-					float_compare_decoded.FRA = instruction.X_Form.RA;
-					float_compare_decoded.FRA = instruction.X_Form.RB;
-					float_compare_decoded.BF = instruction.X_Form.RT(4, 2);
-					float_compare_decoded.unordered = false;
-					break;
-				// X Form floating point status instructions
-				case 38: // mtfsb1, mtfsb1.
-					floating_point_decode_result.execute_status = true;
-					float_status_decoded.FRT_FRB = 0;
-					float_status_decoded.BF_BT = instruction.X_Form.RT;
-					float_status_decoded.BFA = 0;
-					float_status_decoded.U = 0;
-					float_status_decoded.FLM = 0;
-					float_status_decoded.move_to_FPR = false;
-					float_status_decoded.move_to_CR = false;
-					float_status_decoded.move_to_FPSCR = true;
-					float_status_decoded.use_U = false;
-					float_status_decoded.bit_0 = false;
-					float_status_decoded.bit_1 = true;
-					if(instruction.X_Form.Rc == 1) {
-						float_status_decoded.alter_CR1 = true;
-					} else {
-						float_status_decoded.alter_CR1 = false;
-					}
-					break;
-				case 64: // mcrfs
-					floating_point_decode_result.execute_status = true;
-					float_status_decoded.FRT_FRB = 0;
-					float_status_decoded.BF_BT = instruction.X_Form.RT(4, 2);
-					float_status_decoded.BFA = instruction.X_Form.RA(4, 2);
-					float_status_decoded.U = 0;
-					float_status_decoded.FLM = 0;
-					float_status_decoded.move_to_FPR = false;
-					float_status_decoded.move_to_CR = true;
-					float_status_decoded.move_to_FPSCR = false;
-					float_status_decoded.use_U = false;
-					float_status_decoded.bit_0 = false;
-					float_status_decoded.bit_1 = false;
-					float_status_decoded.alter_CR1 = false;
-					break;
-				case 70: // mtfsb0, mtfsb0.
-					floating_point_decode_result.execute_status = true;
-					float_status_decoded.FRT_FRB = 0;
-					float_status_decoded.BF_BT = instruction.X_Form.RT;
-					float_status_decoded.BFA = 0;
-					float_status_decoded.U = 0;
-					float_status_decoded.FLM = 0;
-					float_status_decoded.move_to_FPR = false;
-					float_status_decoded.move_to_CR = false;
-					float_status_decoded.move_to_FPSCR = true;
-					float_status_decoded.use_U = false;
-					float_status_decoded.bit_0 = true;
-					float_status_decoded.bit_1 = false;
-					if(instruction.X_Form.Rc == 1) {
-						float_status_decoded.alter_CR1 = true;
-					} else {
-						float_status_decoded.alter_CR1 = false;
-					}
-					break;
-				case 134: // mtfsfi, mtfsfi.
-					floating_point_decode_result.execute_status = true;
-					float_status_decoded.FRT_FRB = 0;
-					float_status_decoded.BF_BT = instruction.X_Form.RT(4, 2);
-					float_status_decoded.BFA = 0;
-					float_status_decoded.U = instruction.X_Form.RB(4, 1);
-					float_status_decoded.FLM = 0;
-					float_status_decoded.move_to_FPR = false;
-					float_status_decoded.move_to_CR = false;
-					float_status_decoded.move_to_FPSCR = true;
-					float_status_decoded.use_U = true;
-					float_status_decoded.bit_0 = false;
-					float_status_decoded.bit_1 = false;
-					if(instruction.X_Form.Rc == 1) {
-						float_status_decoded.alter_CR1 = true;
-					} else {
-						float_status_decoded.alter_CR1 = false;
-					}
-					break;
-				case 583: // mffs, mffs.
-					floating_point_decode_result.execute_status = true;
-					float_status_decoded.FRT_FRB = instruction.X_Form.RT;
-					float_status_decoded.BF_BT = 0;
-					float_status_decoded.BFA = 0;
-					float_status_decoded.U = 0;
-					float_status_decoded.FLM = 0;
-					float_status_decoded.move_to_FPR = true;
-					float_status_decoded.move_to_CR = false;
-					float_status_decoded.move_to_FPSCR = false;
-					float_status_decoded.use_U = false;
-					float_status_decoded.bit_0 = false;
-					float_status_decoded.bit_1 = false;
-					if(instruction.X_Form.Rc == 1) {
-						float_status_decoded.alter_CR1 = true;
-					} else {
-						float_status_decoded.alter_CR1 = false;
-					}
-					break;
-				// XFL Form floating point status instructions
-				case 711: // mtfsf, mtfsf.
-					floating_point_decode_result.execute_status = true;
-					float_status_decoded.FRT_FRB = instruction.XFL_Form.FRB;
-					float_status_decoded.BF_BT = 0;
-					float_status_decoded.BFA = 0;
-					float_status_decoded.U = 0;
-					float_status_decoded.FLM = instruction.XFL_Form.FLM;
-					float_status_decoded.move_to_FPR = false;
-					float_status_decoded.move_to_CR = false;
-					float_status_decoded.move_to_FPSCR = true;
-					float_status_decoded.use_U = false;
-					float_status_decoded.bit_0 = false;
-					float_status_decoded.bit_1 = false;
-					if(instruction.XFL_Form.Rc == 1) {
-						float_status_decoded.alter_CR1 = true;
-					} else {
-						float_status_decoded.alter_CR1 = false;
-					}
-					break;
-			}
-
-			switch(instruction.A_Form.XO) {
-				// A Form floating point Arithmetic instructions
-				case 18: // fdiv, fdiv.
-					floating_point_decode_result.execute_arithmetic = true;
-					float_arithmetic_decoded.operation = floating_point::DIVIDE;
-					float_arithmetic_decoded.op1_reg_address = instruction.A_Form.FRA;
-					float_arithmetic_decoded.op2_reg_address = instruction.A_Form.FRB;
-					float_arithmetic_decoded.result_reg_address = instruction.A_Form.FRT;
-					float_arithmetic_decoded.single_precision = false;
-					if(instruction.A_Form.Rc == 1) {
-						float_arithmetic_decoded.alter_CR1 = true;
-					} else {
-						float_arithmetic_decoded.alter_CR1 = false;
-					}
-					break;
-				case 20: // fsub, fsub.
-					floating_point_decode_result.execute_arithmetic = true;
-					float_arithmetic_decoded.operation = floating_point::SUBTRACT;
-					float_arithmetic_decoded.op1_reg_address = instruction.A_Form.FRA;
-					float_arithmetic_decoded.op2_reg_address = instruction.A_Form.FRB;
-					float_arithmetic_decoded.result_reg_address = instruction.A_Form.FRT;
-					float_arithmetic_decoded.single_precision = false;
-					if(instruction.A_Form.Rc == 1) {
-						float_arithmetic_decoded.alter_CR1 = true;
-					} else {
-						float_arithmetic_decoded.alter_CR1 = false;
-					}
-					break;
-				case 21: // fadd, fadd.
-					floating_point_decode_result.execute_arithmetic = true;
-					float_arithmetic_decoded.operation = floating_point::ADD;
-					float_arithmetic_decoded.op1_reg_address = instruction.A_Form.FRA;
-					float_arithmetic_decoded.op2_reg_address = instruction.A_Form.FRB;
-					float_arithmetic_decoded.result_reg_address = instruction.A_Form.FRT;
-					float_arithmetic_decoded.single_precision = false;
-					if(instruction.A_Form.Rc == 1) {
-						float_arithmetic_decoded.alter_CR1 = true;
-					} else {
-						float_arithmetic_decoded.alter_CR1 = false;
-					}
-					break;
-				case 25: // fmul, fmul.
-					floating_point_decode_result.execute_arithmetic = true;
-					float_arithmetic_decoded.operation = floating_point::MULTIPLY;
-					float_arithmetic_decoded.op1_reg_address = instruction.A_Form.FRA;
-					float_arithmetic_decoded.op2_reg_address = instruction.A_Form.FRB;
-					float_arithmetic_decoded.result_reg_address = instruction.A_Form.FRT;
-					float_arithmetic_decoded.single_precision = false;
-					if(instruction.A_Form.Rc == 1) {
-						float_arithmetic_decoded.alter_CR1 = true;
-					} else {
-						float_arithmetic_decoded.alter_CR1 = false;
-					}
-					break;
-
-				// A Form floating point Madd instructions
-				case 28: // fmsub, fmsub.
-					floating_point_decode_result.execute_madd = true;
-					float_madd_decoded.mul1_reg_address = instruction.A_Form.FRA;
-					float_madd_decoded.mul2_reg_address = instruction.A_Form.FRC;
-					float_madd_decoded.add_reg_address = instruction.A_Form.FRB;
-					float_madd_decoded.single_precision = false;
-					float_madd_decoded.negate_add = true;
-					float_madd_decoded.negate_result = false;
-					if(instruction.A_Form.Rc == 1) {
-						float_madd_decoded.alter_CR1 = true;
-					} else {
-						float_madd_decoded.alter_CR1 = false;
-					}
+		case fixed_point::TRAP:
+			decode_result = micro_op::pack(micro_op::TRAP, trap_decoded);
+			break;
+		case fixed_point::LOGICAL:
+			decode_result = micro_op::pack(micro_op::LOGICAL, log_decoded);
+			break;
+		case fixed_point::ROTATE:
+			decode_result = micro_op::pack(micro_op::ROTATE, rotate_decoded);
+			break;
+		case fixed_point::SYSTEM:
+			decode_result = micro_op::pack(micro_op::SYSTEM, system_decoded);
+			break;
+		case fixed_point::NONE:
+			switch(branch_result.execute) {
+				case branch::BRANCH:
+					decode_result = micro_op::pack(micro_op::BRANCH, branch_decoded);
 					break;
-				case 29: // fmadd, fmadd.
-					floating_point_decode_result.execute_madd = true;
-					float_madd_decoded.mul1_reg_address = instruction.A_Form.FRA;
-					float_madd_decoded.mul2_reg_address = instruction.A_Form.FRC;
-					float_madd_decoded.add_reg_address = instruction.A_Form.FRB;
-					float_madd_decoded.single_precision = false;
-					float_madd_decoded.negate_add = false;
-					float_madd_decoded.negate_result = false;
-					if(instruction.A_Form.Rc == 1) {
-						float_madd_decoded.alter_CR1 = true;
-					} else {
-						float_madd_decoded.alter_CR1 = false;
-					}
+				case branch::SYSTEM_CALL:
+					decode_result = micro_op::pack_system_call(system_call_decoded);
 					break;
-				case 30: // fnmsub, fnmsub.
-					floating_point_decode_result.execute_madd = true;
-					float_madd_decoded.mul1_reg_address = instruction.A_Form.FRA;
-					float_madd_decoded.mul2_reg_address = instruction.A_Form.FRC;
-					float_madd_decoded.add_reg_address = instruction.A_Form.FRB;
-					float_madd_decoded.single_precision = false;
-					float_madd_decoded.negate_add = true;
-					float_madd_decoded.negate_result = true;
-					if(instruction.A_Form.Rc == 1) {
-						float_madd_decoded.alter_CR1 = true;
-					} else {
-						float_madd_decoded.alter_CR1 = false;
-					}
+				case branch::CONDITION:
+					decode_result = micro_op::pack(micro_op::CONDITION, condition_decoded);
 					break;
-				case 31: // fnmadd, fnmadd.
-					floating_point_decode_result.execute_madd = true;
-					float_madd_decoded.mul1_reg_address = instruction.A_Form.FRA;
-					float_madd_decoded.mul2_reg_address = instruction.A_Form.FRC;
-					float_madd_decoded.add_reg_address = instruction.A_Form.FRB;
-					float_madd_decoded.single_precision = false;
-					float_madd_decoded.negate_add = false;
-					float_madd_decoded.negate_result = true;
-					if(instruction.A_Form.Rc == 1) {
-						float_madd_decoded.alter_CR1 = true;
-					} else {
-						float_madd_decoded.alter_CR1 = false;
-					}
+				case branch::NONE:
+					decode_result = micro_op::init(micro_op::NONE);
 					break;
 			}
 			break;
-
-			case 59:
-				switch(instruction.A_Form.XO) {
-					// A Form floating point Arithmetic instructions
-					case 18: // fdivs, fdivs.
-						floating_point_decode_result.execute_arithmetic = true;
-						float_arithmetic_decoded.operation = floating_point::DIVIDE;
-						float_arithmetic_decoded.op1_reg_address = instruction.A_Form.FRA;
-						float_arithmetic_decoded.op2_reg_address = instruction.A_Form.FRB;
-						float_arithmetic_decoded.result_reg_address = instruction.A_Form.FRT;
-						float_arithmetic_decoded.single_precision = true;
-						if(instruction.A_Form.Rc == 1) {
-							float_arithmetic_decoded.alter_CR1 = true;
-						} else {
-							float_arithmetic_decoded.alter_CR1 = false;
-						}
-						break;
-					case 20: // fsubs, fsubs.
-						floating_point_decode_result.execute_arithmetic = true;
-						float_arithmetic_decoded.operation = floating_point::SUBTRACT;
-						float_arithmetic_decoded.op1_reg_address = instruction.A_Form.FRA;
-						float_arithmetic_decoded.op2_reg_address = instruction.A_Form.FRB;
-						float_arithmetic_decoded.result_reg_address = instruction.A_Form.FRT;
-						float_arithmetic_decoded.single_precision = true;
-						if(instruction.A_Form.Rc == 1) {
-							float_arithmetic_decoded.alter_CR1 = true;
-						} else {
-							float_arithmetic_decoded.alter_CR1 = false;
-						}
-						break;
-					case 21: // fadds, fadds.
-						floating_point_decode_result.execute_arithmetic = true;
-						float_arithmetic_decoded.operation = floating_point::ADD;
-						float_arithmetic_decoded.op1_reg_address = instruction.A_Form.FRA;
-						float_arithmetic_decoded.op2_reg_address = instruction.A_Form.FRB;
-						float_arithmetic_decoded.result_reg_address = instruction.A_Form.FRT;
-						float_arithmetic_decoded.single_precision = true;
-						if(instruction.A_Form.Rc == 1) {
-							float_arithmetic_decoded.alter_CR1 = true;
-						} else {
-							float_arithmetic_decoded.alter_CR1 = false;
-						}
-						break;
-					case 25: // fmuls, fmuls.
-						floating_point_decode_result.execute_arithmetic = true;
-						float_arithmetic_decoded.operation = floating_point::MULTIPLY;
-						float_arithmetic_decoded.op1_reg_address = instruction.A_Form.FRA;
-						float_arithmetic_decoded.op2_reg_address = instruction.A_Form.FRB;
-						float_arithmetic_decoded.result_reg_address = instruction.A_Form.FRT;
-						float_arithmetic_decoded.single_precision = true;
-						if(instruction.A_Form.Rc == 1) {
-							float_arithmetic_decoded.alter_CR1 = true;
-						} else {
-							float_arithmetic_decoded.alter_CR1 = false;
-						}
-						break;
-					// A Form floating point Madd instructions
-					case 28: // fmsubs, fmsubs.
-						floating_point_decode_result.execute_madd = true;
-						float_madd_decoded.mul1_reg_address = instruction.A_Form.FRA;
-						float_madd_decoded.mul2_reg_address = instruction.A_Form.FRC;
-						float_madd_decoded.add_reg_address = instruction.A_Form.FRB;
-						float_madd_decoded.single_precision = true;
-						float_madd_decoded.negate_add = true;
-						float_madd_decoded.negate_result = false;
-						if(instruction.A_Form.Rc == 1) {
-							float_madd_decoded.alter_CR1 = true;
-						} else {
-							float_madd_decoded.alter_CR1 = false;
-						}
-						break;
-					case 29: // fmadds, fmadds.
-						floating_point_decode_result.execute_madd = true;
-						float_madd_decoded.mul1_reg_address = instruction.A_Form.FRA;
-						float_madd_decoded.mul2_reg_address = instruction.A_Form.FRC;
-						float_madd_decoded.add_reg_address = instruction.A_Form.FRB;
-						float_madd_decoded.single_precision = true;
-						float_madd_decoded.negate_add = false;
-						float_madd_decoded.negate_result = false;
-						if(instruction.A_Form.Rc == 1) {
-							float_madd_decoded.alter_CR1 = true;
-						} else {
-							float_madd_decoded.alter_CR1 = false;
-						}
-						break;
-					case 30: // fnmsubs, fnmsubs.
-						floating_point_decode_result.execute_madd = true;
-						float_madd_decoded.mul1_reg_address = instruction.A_Form.FRA;
-						float_madd_decoded.mul2_reg_address = instruction.A_Form.FRC;
-						float_madd_decoded.add_reg_address = instruction.A_Form.FRB;
-						float_madd_decoded.single_precision = true;
-						float_madd_decoded.negate_add = true;
-						float_madd_decoded.negate_result = true;
-						if(instruction.A_Form.Rc == 1) {
-							float_madd_decoded.alter_CR1 = true;
-						} else {
-							float_madd_decoded.alter_CR1 = false;
-						}
-						break;
-					case 31: // fnmadds, fnmadds.
-						floating_point_decode_result.execute_madd = true;
-						float_madd_decoded.mul1_reg_address = instruction.A_Form.FRA;
-						float_madd_decoded.mul2_reg_address = instruction.A_Form.FRC;
-						float_madd_decoded.add_reg_address = instruction.A_Form.FRB;
-						float_madd_decoded.single_precision = true;
-						float_madd_decoded.negate_add = false;
-						float_madd_decoded.negate_result = true;
-						if(instruction.A_Form.Rc == 1) {
-							float_madd_decoded.alter_CR1 = true;
-						} else {
-							float_madd_decoded.alter_CR1 = false;
-						}
-						break;
-				}
-				break;
-
 	}
 
-	branch_result.branch_decoded = branch_decoded;
-	branch_result.system_call_decoded = system_call_decoded;
-	branch_result.condition_decoded = condition_decoded;
-
-	fixed_point_decode_result.load_store_decoded = load_store_decoded;
-	fixed_point_decode_result.add_sub_decoded = add_sub_decoded;
-	fixed_point_decode_result.mul_decoded = mul_decoded;
-	fixed_point_decode_result.div_decoded = div_decoded;
-	fixed_point_decode_result.cmp_decoded = cmp_decoded;
-	fixed_point_decode_result.trap_decoded = trap_decoded;
-	fixed_point_decode_result.log_decoded = log_decoded;
-	fixed_point_decode_result.rotate_decoded = rotate_decoded;
-	fixed_point_decode_result.system_decoded = system_decoded;
-
-	floating_point_decode_result.float_load_store_decoded = float_load_store_decoded;
-	floating_point_decode_result.float_move_decoded = float_move_decoded;
-	floating_point_decode_result.float_arithmetic_decoded = float_arithmetic_decoded;
-	floating_point_decode_result.float_madd_decoded = float_madd_decoded;
-	floating_point_decode_result.float_convert_decoded = float_convert_decoded;
-	floating_point_decode_result.float_compare_decoded = float_compare_decoded;
-	floating_point_decode_result.float_status_decoded = float_status_decoded;
-
-	decode_result.branch_decode_result = branch_result;
-	decode_result.fixed_point_decode_result = fixed_point_decode_result;
-	decode_result.floating_point_decode_result = floating_point_decode_result;
-
 	return decode_result;
 }
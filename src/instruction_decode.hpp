@@ -30,7 +30,7 @@
 #include <stdint.h>
 #include "ppc_types.h"
 namespace pipeline {
-    decode_result_t decode(uint32_t instruction_port);
+    micro_op_t decode(uint32_t instruction_port);
 }
 
 #endif
@@ -0,0 +1,405 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "jit_x86.hpp"
+#include "micro_op.hpp"
+#include <cstring>
+
+#ifdef JIT_X86_SUPPORTED
+#include <sys/mman.h>
+#include <unistd.h>
+
+// The generated code accesses the registers as plain 32 bit words
+static_assert(sizeof(ppc_uint<32>) == sizeof(uint32_t), "ppc_uint<32> has to be stored in a single word");
+
+namespace {
+    class emitter {
+    public:
+        std::vector<uint8_t> bytes;
+
+        void byte(uint8_t value) {
+            bytes.push_back(value);
+        }
+
+        void word(uint32_t value) {
+            for(uint32_t i = 0; i < 4; i++) {
+                bytes.push_back(value >> (i*8));
+            }
+        }
+
+        void quad(uint64_t value) {
+            for(uint32_t i = 0; i < 8; i++) {
+                bytes.push_back(value >> (i*8));
+            }
+        }
+
+        // <opcode> eax, [rbx + displacement]
+        void eax_rbx(uint8_t opcode, uint32_t displacement) {
+            byte(opcode);
+            byte(0x83);
+            word(displacement);
+        }
+    };
+
+    // Offsets of the registers inside of registers_t
+    uint32_t gpr_offset(uint32_t index) {
+        static registers_t layout;
+        return (uint8_t *) &layout.GPR[index] - (uint8_t *) &layout;
+    }
+
+    uint32_t program_counter_offset() {
+        static registers_t layout;
+        return (uint8_t *) &layout.program_counter - (uint8_t *) &layout;
+    }
+
+    uint32_t link_register_offset() {
+        static registers_t layout;
+        return (uint8_t *) &layout.link_register - (uint8_t *) &layout;
+    }
+
+    uint32_t count_register_offset() {
+        static registers_t layout;
+        return (uint8_t *) &layout.count_register - (uint8_t *) &layout;
+    }
+
+    // mov dword [rbx + displacement], imm32
+    void store_immediate(emitter &e, uint32_t displacement, uint32_t value) {
+        e.byte(0xC7);
+        e.byte(0x83);
+        e.word(displacement);
+        e.word(value);
+    }
+
+    // Emits b and bc, which do not depend on the condition register.
+    // Returns false, if the branch has to call its handler.
+    bool emit_branch(emitter &e, const micro_op_t &op, uint32_t address) {
+        uint32_t target;
+        if(op.opcode != micro_op::BRANCH || !micro_op::direct_branch_target(op, address, target)) {
+            return false;
+        }
+
+        // BO is in big endian notation
+        const uint32_t BO = op.field_a;
+        if(op.operation == ::BRANCH || (BO & 0x04)) {
+            if(op.operation == BRANCH_CONDITIONAL && !(BO & 0x10)) {
+                return false;
+            }
+            store_immediate(e, program_counter_offset(), target);
+        } else {
+            if(!(BO & 0x10)) {
+                return false;
+            }
+            // dec dword [rbx + CTR]
+            e.byte(0xFF);
+            e.byte(0x8B);
+            e.word(count_register_offset());
+            // cmp dword [rbx + CTR], 0
+            e.byte(0x83);
+            e.byte(0xBB);
+            e.word(count_register_offset());
+            e.byte(0x00);
+            store_immediate(e, program_counter_offset(), address + 4);
+            // Skip the taken path: jne/je +10
+            e.byte((BO & 0x02) ? 0x75 : 0x74);
+            e.byte(0x0A);
+            store_immediate(e, program_counter_offset(), target);
+        }
+
+        if(op.flags & micro_op::LK) {
+            store_immediate(e, link_register_offset(), address + 4);
+        }
+        return true;
+    }
+
+    // MB and ME are in big endian notation
+    uint32_t rotate_mask(uint32_t mask_begin, uint32_t mask_end) {
+        uint32_t mask = 0;
+        for(uint32_t i = 0; i < 32; i++) {
+            bool set;
+            if(mask_begin > mask_end) {
+                set = i <= mask_end || i >= mask_begin;
+            } else {
+                set = i >= mask_begin && i <= mask_end;
+            }
+            if(set) {
+                mask |= 1u << (31 - i);
+            }
+        }
+        return mask;
+    }
+
+    const uint16_t ADD_FLAGS = micro_op::ALTER_CR0 | micro_op::ALTER_OV | micro_op::ALTER_CA |
+                               micro_op::ADD_CA | micro_op::SUBTRACT;
+    const uint16_t ROTATE_FLAGS = micro_op::MASK_INSERT | micro_op::SHIFT | micro_op::ALTER_CR0;
+
+    // Returns false, if the instruction has to call its handler
+    bool emit_inline(emitter &e, const micro_op_t &op) {
+        if(op.opcode == micro_op::ADD_SUB && !(op.flags & ADD_FLAGS)) {
+            if(op.flags & micro_op::OP1_IMM) {
+                // xor eax, eax
+                e.byte(0x31);
+                e.byte(0xC0);
+            } else {
+                e.eax_rbx(0x8B, gpr_offset(op.reg_a));
+            }
+            if(op.flags & micro_op::OP2_IMM) {
+                // add eax, imm32
+                e.byte(0x05);
+                e.word(op.immediate);
+            } else {
+                e.eax_rbx(0x03, gpr_offset(op.reg_b));
+            }
+        } else if(op.opcode == micro_op::LOGICAL && !(op.flags & micro_op::ALTER_CR0) &&
+                  (op.operation == logical::AND || op.operation == logical::OR || op.operation == logical::XOR)) {
+            uint8_t register_opcode;
+            uint8_t immediate_opcode;
+            if(op.operation == logical::AND) {
+                register_opcode = 0x23;
+                immediate_opcode = 0x25;
+            } else if(op.operation == logical::OR) {
+                register_opcode = 0x0B;
+                immediate_opcode = 0x0D;
+            } else {
+                register_opcode = 0x33;
+                immediate_opcode = 0x35;
+            }
+            e.eax_rbx(0x8B, gpr_offset(op.reg_a));
+            if(op.flags & micro_op::OP2_IMM) {
+                e.byte(immediate_opcode);
+                e.word(op.immediate);
+            } else {
+                e.eax_rbx(register_opcode, gpr_offset(op.reg_b));
+            }
+        } else if(op.opcode == micro_op::ROTATE && (op.flags & micro_op::OP2_IMM) && !(op.flags & ROTATE_FLAGS)) {
+            // rlwinm
+            e.eax_rbx(0x8B, gpr_offset(op.reg_a));
+            // rol eax, imm8
+            e.byte(0xC1);
+            e.byte(0xC0);
+            e.byte(op.field_a & 31);
+            // and eax, imm32
+            e.byte(0x25);
+            e.word(rotate_mask(op.field_b & 31, op.field_c & 31));
+        } else {
+            return false;
+        }
+        // mov [rbx + result], eax
+        e.eax_rbx(0x89, gpr_offset(op.reg_c));
+        return true;
+    }
+}
+
+x86_jit::x86_jit() : used(0) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef __APPLE__
+    // The hardened runtime only allows executable mappings, which are created for a JIT
+    flags |= MAP_JIT;
+#endif
+    void *memory = mmap(nullptr, JIT_CODE_SIZE, PROT_READ | PROT_EXEC, flags, -1, 0);
+    if(memory == MAP_FAILED) {
+        code = nullptr;
+    } else {
+        code = (uint8_t *) memory;
+    }
+}
+
+x86_jit::~x86_jit() {
+    if(code != nullptr) {
+        munmap(code, JIT_CODE_SIZE);
+    }
+}
+
+x86_jit::compiled_block_t x86_jit::compile(uint32_t start_address, const std::vector<threaded::threaded_op_t> &ops,
+                                           bool ends_with_branch) {
+    if(code == nullptr) {
+        return nullptr;
+    }
+
+    emitter e;
+    std::vector<size_t> exit_jumps;
+
+    // push rbx; push r12; sub rsp, 8
+    e.byte(0x53);
+    e.byte(0x41); e.byte(0x54);
+    e.byte(0x48); e.byte(0x83); e.byte(0xEC); e.byte(0x08);
+    // mov rbx, rdi (registers); mov r12, rsi (data memory)
+    e.byte(0x48); e.byte(0x89); e.byte(0xFB);
+    e.byte(0x49); e.byte(0x89); e.byte(0xF4);
+
+    // Number of instructions up to and including the current micro-op
+    uint32_t position = 0;
+    for(uint32_t i = 0; i < ops.size(); i++) {
+        const micro_op_t &op = ops[i].op;
+        position += micro_op::length(op);
+        if(emit_inline(e, op)) {
+            continue;
+        }
+
+        if(ends_with_branch && i == ops.size() - 1) {
+            uint32_t address = start_address + 4*(position - 1);
+            if(emit_branch(e, op, address)) {
+                continue;
+            }
+            // The branch handler needs its own address
+            store_immediate(e, program_counter_offset(), address);
+        }
+        // mov rdi, &op; mov rsi, rbx; mov rdx, r12; mov rax, handler; call rax
+        e.byte(0x48); e.byte(0xBF);
+        e.quad((uint64_t) &op);
+        e.byte(0x48); e.byte(0x89); e.byte(0xDE);
+        e.byte(0x4C); e.byte(0x89); e.byte(0xE2);
+        e.byte(0x48); e.byte(0xB8);
+        e.quad((uint64_t) ops[i].handler);
+        e.byte(0xFF); e.byte(0xD0);
+
+        // Leave on traps: test al, al; je +10; mov eax, position; jmp exit
+        e.byte(0x84); e.byte(0xC0);
+        e.byte(0x74); e.byte(0x0A);
+        e.byte(0xB8);
+        e.word(position);
+        e.byte(0xE9);
+        exit_jumps.push_back(e.bytes.size());
+        e.word(0);
+    }
+
+    // xor eax, eax
+    e.byte(0x31); e.byte(0xC0);
+    size_t exit = e.bytes.size();
+    // add rsp, 8; pop r12; pop rbx; ret
+    e.byte(0x48); e.byte(0x83); e.byte(0xC4); e.byte(0x08);
+    e.byte(0x41); e.byte(0x5C);
+    e.byte(0x5B);
+    e.byte(0xC3);
+
+    for(size_t jump : exit_jumps) {
+        uint32_t relative = exit - (jump + 4);
+        std::memcpy(&e.bytes[jump], &relative, 4);
+    }
+
+    uint8_t *block = allocate(e.bytes.size());
+    if(block == nullptr) {
+        return nullptr;
+    }
+
+    // Only the pages of the block are writable while it is copied
+    uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t first_page = (uintptr_t) block & ~(page_size - 1);
+    size_t length = (uintptr_t) block + e.bytes.size() - first_page;
+    if(mprotect((void *) first_page, length, PROT_READ | PROT_WRITE) != 0) {
+        release((compiled_block_t) block);
+        return nullptr;
+    }
+    std::memcpy(block, e.bytes.data(), e.bytes.size());
+    if(mprotect((void *) first_page, length, PROT_READ | PROT_EXEC) != 0) {
+        release((compiled_block_t) block);
+        return nullptr;
+    }
+    return (compiled_block_t) block;
+}
+
+uint8_t *x86_jit::allocate(size_t size) {
+    // Keep the blocks 16 byte aligned
+    size = (size + 15) & ~(size_t) 15;
+
+    size_t offset = used;
+    auto gap = gaps.begin();
+    while(gap != gaps.end() && gap->second < size) {
+        gap++;
+    }
+    if(gap != gaps.end()) {
+        offset = gap->first;
+        if(gap->second > size) {
+            gaps[offset + size] = gap->second - size;
+        }
+        gaps.erase(gap);
+    } else if(used + size > JIT_CODE_SIZE) {
+        return nullptr;
+    } else {
+        used += size;
+    }
+    blocks[offset] = size;
+    return code + offset;
+}
+
+void x86_jit::release(compiled_block_t block) {
+    auto entry = blocks.find((uint8_t *) block - code);
+    if(entry == blocks.end()) {
+        return;
+    }
+    size_t offset = entry->first;
+    size_t size = entry->second;
+    blocks.erase(entry);
+
+    // Merge with the gaps before and after the block
+    auto next = gaps.lower_bound(offset);
+    if(next != gaps.end() && next->first == offset + size) {
+        size += next->second;
+        next = gaps.erase(next);
+    }
+    if(next != gaps.begin()) {
+        auto previous = std::prev(next);
+        if(previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            gaps.erase(previous);
+        }
+    }
+
+    if(offset + size == used) {
+        used = offset;
+    } else {
+        gaps[offset] = size;
+    }
+}
+
+void x86_jit::reset() {
+    used = 0;
+    blocks.clear();
+    gaps.clear();
+}
+
+size_t x86_jit::code_size() const {
+    return used;
+}
+
+#else
+
+x86_jit::x86_jit() : code(nullptr), used(0) {
+}
+
+x86_jit::~x86_jit() {
+}
+
+x86_jit::compiled_block_t x86_jit::compile(uint32_t, const std::vector<threaded::threaded_op_t> &, bool) {
+    return nullptr;
+}
+
+void x86_jit::release(compiled_block_t) {
+}
+
+void x86_jit::reset() {
+}
+
+size_t x86_jit::code_size() const {
+    return 0;
+}
+
+#endif
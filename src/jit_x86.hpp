@@ -0,0 +1,78 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_JIT_X86_HPP
+#define POWERPC_HLS_JIT_X86_HPP
+
+#include "ppc_int.hpp"
+#include <cstddef>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "ppc_types.h"
+#include "threaded_dispatch.hpp"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__)) && !defined(__SYNTHESIS__)
+#define JIT_X86_SUPPORTED
+#endif
+
+// Size of the executable memory for compiled blocks
+#define JIT_CODE_SIZE (16 * 1024 * 1024)
+
+// Software simulation only!
+// Compiles translated blocks to x86-64 code, which works directly on registers_t.
+// Simple integer instructions are emitted inline, all others call their threaded handler.
+// The code memory is never writable and executable at the same time, it is only made writable while a block is copied
+// into it. Released blocks leave gaps, which later blocks reuse.
+// On hosts without support, compile always returns nullptr and the blocks stay interpreted.
+class x86_jit {
+public:
+    // Returns 0 if all instructions were executed, otherwise the number of instructions up to and including the trap
+    typedef uint32_t (*compiled_block_t)(registers_t *registers, ppc_uint<32> *data_memory);
+
+    x86_jit();
+    ~x86_jit();
+    x86_jit(const x86_jit &) = delete;
+    x86_jit &operator=(const x86_jit &) = delete;
+
+    // The ops have to stay at the same address as long as the compiled block is used.
+    // Returns nullptr, if the code memory is exhausted.
+    compiled_block_t compile(uint32_t start_address, const std::vector<threaded::threaded_op_t> &ops,
+                             bool ends_with_branch);
+
+    // Frees the code of a block, which must not be executed anymore
+    void release(compiled_block_t block);
+    // Drops all compiled blocks
+    void reset();
+
+    // Bytes of the code memory, which are used by compiled blocks or gaps between them
+    size_t code_size() const;
+
+private:
+    uint8_t *allocate(size_t size);
+
+    uint8_t *code;
+    size_t used; // End of the used part of the code memory
+    std::unordered_map<size_t, size_t> blocks; // Offset and size of the compiled blocks
+    std::map<size_t, size_t> gaps; // Offset and size of released code below used, adjacent gaps are merged
+};
+
+#endif //POWERPC_HLS_JIT_X86_HPP
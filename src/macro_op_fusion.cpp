@@ -0,0 +1,84 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "macro_op_fusion.hpp"
+#include "micro_op.hpp"
+
+bool pipeline::fuse(const micro_op_t &first, const micro_op_t &second, micro_op_t &fused) {
+#pragma HLS inline
+    // lis/li rD, x + ori rD, rD, y
+    if(first.opcode == micro_op::ADD_SUB && first.flags == (micro_op::OP1_IMM | micro_op::OP2_IMM) &&
+       second.opcode == micro_op::LOGICAL && second.operation == logical::OR && second.flags == micro_op::OP2_IMM &&
+       second.reg_a == first.reg_c && second.reg_c == first.reg_c) {
+        fused = micro_op::init(micro_op::FUSED_LOAD_IMMEDIATE);
+        fused.reg_c = first.reg_c;
+        fused.immediate = first.immediate | second.immediate;
+        return true;
+    }
+
+    // addis rT, rA, x + lwz/lhz/lha/lbz rD, y(rT)
+    const uint16_t load_flags = micro_op::SUM2_IMM | micro_op::SIGN_EXTEND;
+    if(first.opcode == micro_op::ADD_SUB && (first.flags & ~micro_op::OP1_IMM) == micro_op::OP2_IMM &&
+       (first.immediate & 0xFFFF) == 0 &&
+       second.opcode == micro_op::LOAD && (second.flags & ~load_flags) == 0 && (second.flags & micro_op::SUM2_IMM) &&
+       second.reg_a == first.reg_c) {
+        fused = micro_op::init(micro_op::FUSED_ADDRESS_LOAD);
+        fused.flags = ((first.flags & micro_op::OP1_IMM) ? micro_op::SUM1_IMM : 0) |
+                      (second.flags & micro_op::SIGN_EXTEND);
+        fused.reg_a = first.reg_a;
+        fused.reg_b = first.reg_c;
+        fused.reg_c = second.reg_c;
+        fused.field_a = second.field_a;
+        fused.immediate = (first.immediate & 0xFFFF0000) | (second.immediate & 0xFFFF);
+        return true;
+    }
+
+    // rlwinm rA, rS, SH, MB, ME + cmpwi/cmplwi crX, rA, x
+    if(first.opcode == micro_op::ROTATE && first.flags == micro_op::OP2_IMM &&
+       second.opcode == micro_op::COMPARE && (second.flags & micro_op::OP2_IMM) && second.reg_a == first.reg_c) {
+        fused = micro_op::init(micro_op::FUSED_ROTATE_COMPARE);
+        fused.flags = second.flags & micro_op::SIGNED;
+        fused.reg_a = first.reg_a;
+        fused.reg_c = first.reg_c;
+        fused.field_a = first.field_a;
+        fused.field_b = first.field_b;
+        fused.field_c = first.field_c;
+        fused.field_d = second.field_a;
+        fused.immediate = second.immediate;
+        return true;
+    }
+
+    // cmpw/cmplw/cmpwi/cmplwi crX, ... + bc BO, BI, target (without link and absolute addressing)
+    if(first.opcode == micro_op::COMPARE &&
+       second.opcode == micro_op::BRANCH && second.operation == BRANCH_CONDITIONAL && second.flags == 0) {
+        fused = micro_op::init(micro_op::FUSED_COMPARE_BRANCH);
+        fused.flags = first.flags & (micro_op::OP2_IMM | micro_op::SIGNED);
+        fused.reg_a = first.reg_a;
+        fused.reg_b = first.reg_b;
+        fused.field_a = second.field_a;
+        fused.field_b = second.field_b;
+        fused.field_c = first.field_a;
+        fused.immediate = (second.immediate << 16) | (first.immediate & 0xFFFF);
+        return true;
+    }
+
+    return false;
+}
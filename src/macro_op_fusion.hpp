@@ -0,0 +1,36 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_MACRO_OP_FUSION_HPP
+#define POWERPC_HLS_MACRO_OP_FUSION_HPP
+
+#include "ppc_types.h"
+
+// Optional fusion stage after the decoder, enabled with MACRO_OP_FUSION.
+// Common pairs of adjacent instructions are combined into a single micro-op:
+// lis/li + ori (constant), addis + D-form load (address formation), rlwinm + cmpi and cmp + bc.
+// A fused micro-op writes the same registers as both instructions executed one after another.
+namespace pipeline {
+    // Returns true and sets fused, if the two decoded instructions can be executed as one micro-op
+    bool fuse(const micro_op_t &first, const micro_op_t &second, micro_op_t &fused);
+}
+
+#endif //POWERPC_HLS_MACRO_OP_FUSION_HPP
@@ -30,12 +30,13 @@
 #include "test_bench_utils.hpp"
 #include "fixed_point_utils.hpp"
 #include "pipeline.hpp"
+#include "block_cache.hpp"
+#include "mmio.hpp"
+#include "elf_loader.hpp"
+#include "assembler.hpp"
 
 #define PROGRAM_PATH "../tests/programs"
 
-#define GCC_LOCATION "/opt/devkitpro/devkitPPC/bin/powerpc-eabi-as"
-#define OBJCOPY_LOCATION "/opt/devkitpro/devkitPPC/bin/powerpc-eabi-objcopy"
-
 #ifndef CATCH_CONFIG_MAIN
 #define I_MEM_SIZE 8192
 #define D_MEM_SIZE 16384
@@ -45,26 +46,45 @@
 
     // Complete assembly program tests can go here
     int main() {
-        ap_uint<32> i_mem[I_MEM_SIZE/4];
-        ap_uint<32> d_mem[D_MEM_SIZE/4];
+        ppc_uint<32> i_mem[I_MEM_SIZE/4];
+        ppc_uint<32> d_mem[D_MEM_SIZE/4];
         registers_t registers;
+        block_cache cache(I_MEM_SIZE/4);
 
-        int32_t program_size = read_byte_code("../tests/binaries/led_short.bin", i_mem, I_MEM_SIZE);
+        uint32_t entry_point;
+        int32_t program_size = read_elf("../tests/binaries/led_short.elf", i_mem, I_MEM_SIZE/4, d_mem, D_MEM_SIZE/4,
+                                        entry_point);
         if(program_size < 0) {
             std::cout << "Error loading program binary!!!" << std::endl;
             exit(-1);
         }
-
-        registers.program_counter = 0;
-
-        uint32_t last_val = 0;
+        // The instruction memory has been written
+        cache.invalidate_all();
+
+        // GPIO model, which prints the registers whenever the data register changes
+        uint32_t gpio[2] = {0, 0};
+        mmio::map(GPIO_DATA_ADDRESS, 8,
+                  [&gpio](uint32_t address, uint32_t) {
+                      return gpio[(address - GPIO_DATA_ADDRESS)/4];
+                  },
+                  [&gpio](uint32_t address, uint32_t, uint32_t value) {
+                      uint32_t &reg = gpio[(address - GPIO_DATA_ADDRESS)/4];
+                      bool changed = reg != value;
+                      reg = value;
+                      if(changed && address == GPIO_DATA_ADDRESS) {
+                          std::cout << "GPIO data reg: " << std::to_string(gpio[0])
+                                    << " GPIO tri reg: " << std::to_string(gpio[1]) << "\r" << std::flush;
+                      }
+                  });
+
+        registers.program_counter = entry_point;
+
+        run_options_t options;
+        options.max_instructions = UINT64_MAX;
+        options.stop_on_trap = false;
+        options.blocks = &cache;
         while(true) {
-            execute_single_instruction(pipeline::instruction_fetch(i_mem, registers), registers, d_mem);
-            if(last_val != d_mem[GPIO_DATA_ADDRESS/4]) {
-                std::cout << "GPIO data reg: " << std::to_string(d_mem[GPIO_DATA_ADDRESS / 4])
-                          << " GPIO tri reg: " << std::to_string(d_mem[GPIO_TRI_ADDRESS / 4]) << "\r" << std::flush;
-                last_val = d_mem[GPIO_DATA_ADDRESS/4];
-            }
+            run(registers, i_mem, d_mem, options);
         }
     }
 #else
@@ -72,8 +92,8 @@
 #define D_MEM_SIZE 1024
 
 TEST_CASE("Automatic program execution", "[program execution]") {
-    ap_uint<32> i_mem[I_MEM_SIZE];
-    ap_uint<32> d_mem[D_MEM_SIZE];
+    ppc_uint<32> i_mem[I_MEM_SIZE];
+    ppc_uint<32> d_mem[D_MEM_SIZE];
     registers_t registers;
 
     std::vector<std::filesystem::path> filenames;
@@ -127,7 +147,12 @@ TEST_CASE("Automatic program execution", "[program execution]") {
 
             if(instruction_file.is_string()) {
                 auto bin_name = instruction_file.get<std::string>();
-                program_size = read_byte_code(bin_name.c_str(), i_mem, I_MEM_SIZE);
+                uint32_t entry_point;
+                if(std::filesystem::path(bin_name).extension() == ".elf") {
+                    program_size = read_elf(bin_name.c_str(), i_mem, I_MEM_SIZE, d_mem, D_MEM_SIZE, entry_point);
+                } else {
+                    program_size = read_byte_code(bin_name.c_str(), i_mem, I_MEM_SIZE);
+                }
                 if(program_size < 0) {
                     FAIL("Config " + file.string() + " has no valid instructions!!!");
                 }
@@ -135,20 +160,22 @@ TEST_CASE("Automatic program execution", "[program execution]") {
                 auto &binary = instructions.get_binary();
                 memcpy(i_mem, binary.data(), binary.size());
                 program_size = binary.size()/4;
+                prepare_instructions(i_mem, program_size);
             } else if(assembly.is_string()) {
-                auto as_program = assembly.get<std::string>();
-                auto compile_cmd = "echo \"" + as_program + "\" | " + GCC_LOCATION + " -o as.elf";
-                auto objcopy_cmd = std::string(OBJCOPY_LOCATION) + " -O binary as.elf as.bin";
-                if(system(compile_cmd.c_str())) {
-                    FAIL("Error while compiling assembly code of file " + file.string() + " !!!");
+                std::vector<uint32_t> code;
+                std::string error;
+                if(!assembler::assemble(assembly.get<std::string>(), code, error)) {
+                    FAIL("Error while assembling the code of file " + file.string() + ": " + error + " !!!");
                 }
-                if(system(objcopy_cmd.c_str())) {
-                    FAIL("Error while converting elf to binary with objcopy of file " + file.string() + " !!!");
+                if(code.size() > I_MEM_SIZE) {
+                    FAIL("Config " + file.string() + " has more instructions than the instruction memory holds!!!");
                 }
-                program_size = read_byte_code("as.bin", i_mem, I_MEM_SIZE);
-                if(program_size < 0) {
-                    FAIL("Config " + file.string() + " has no valid instructions or the compiler path is incorrect!!!");
+                // The instruction memory holds big endian words like a loaded binary
+                for(uint32_t i = 0; i < code.size(); i++) {
+                    i_mem[i] = pipeline::swap_endianness(code[i]);
                 }
+                program_size = code.size();
+                prepare_instructions(i_mem, program_size);
             } else {
                 FAIL("Config " + file.string() + " has no valid instructions!!!");
             }
@@ -167,7 +194,7 @@ TEST_CASE("Automatic program execution", "[program execution]") {
                 }
                 // Ceiling division will add padding to word boundary
                 for(uint32_t i = 0; i < (binary.size()+3)/4; i++) {
-                    ap_uint<32> big;
+                    ppc_uint<32> big;
                     if(i*4+3 > binary.size())
                         big(7, 0) = binary[i*4+3];
                     if(i*4+2 > binary.size())
@@ -215,7 +242,7 @@ TEST_CASE("Automatic program execution", "[program execution]") {
                         for(uint32_t i = 0; i < 8; i++) {
                             auto CR_i = CR["CR" + std::to_string(i)];
                             if (CR_i.is_object()) {
-                                condition_field &reg = registers.condition_reg[i];
+                                condition_field reg = registers.condition_reg[i];
                                 // Fixed Point conditions
                                 if(CR_i["LT"].is_boolean()) {
                                     reg.condition_fixed_point.LT = CR_i["LT"].get<bool>();
@@ -305,8 +332,8 @@ TEST_CASE("Automatic program execution", "[program execution]") {
                 if(!sa_data.is_null()) {
                     for (uint32_t i = 0; i < D_MEM_SIZE; i++) {
                         if (!sa_data[std::to_string(i*4)].is_null()) {
-                            ap_uint<32> little = sa_data[std::to_string(i*4)].get<int32_t>();
-                            ap_uint<32> big;
+                            ppc_uint<32> little = sa_data[std::to_string(i*4)].get<int32_t>();
+                            ppc_uint<32> big;
                             big(7, 0) = little(31, 24);
                             big(15, 8) = little(23, 16);
                             big(23, 16) = little(15, 8);
@@ -364,7 +391,7 @@ TEST_CASE("Automatic program execution", "[program execution]") {
                         for(uint32_t i = 0; i < 8; i++) {
                             auto CR_i = CR["CR" + std::to_string(i)];
                             if (CR_i.is_object()) {
-                                condition_field &reg = registers.condition_reg[i];
+                                condition_field reg = registers.condition_reg[i];
                                 // Fixed Point conditions
                                 if(CR_i["LT"].is_boolean()) {
                                     INFO("Checking CR" + std::to_string(i) + " LT bit.")
@@ -489,8 +516,8 @@ TEST_CASE("Automatic program execution", "[program execution]") {
                 if (!sa_data.is_null()) {
                     for (uint32_t i = 0; i < D_MEM_SIZE; i++) {
                         if (!sa_data[std::to_string(i*4)].is_null()) {
-                            ap_uint<32> little = sa_data[std::to_string(i*4)].get<int32_t>();
-                            ap_uint<32> big;
+                            ppc_uint<32> little = sa_data[std::to_string(i*4)].get<int32_t>();
+                            ppc_uint<32> big;
                             big(7, 0) = little(31, 24);
                             big(15, 8) = little(23, 16);
                             big(23, 16) = little(15, 8);
@@ -0,0 +1,545 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_MICRO_OP_HPP
+#define POWERPC_HLS_MICRO_OP_HPP
+
+#include "ppc_types.h"
+
+// Conversion between the unit specific decode structs and the compact micro-op.
+//
+// Field mapping:
+// Load/Store:  reg_a = sum1, reg_b = sum2 (NB for string instructions), reg_c = result (source for stores),
+//              reg_d = effective address target, field_a = word size, immediate = sum2 immediate
+// Add/Sub:     reg_a = op1, reg_b = op2, reg_c = result, immediate = op2 immediate (op1 immediate is always zero)
+// Mul:         reg_a = op1, reg_b = op2, reg_c = result, immediate = op2 immediate
+// Div:         reg_a = dividend, reg_b = divisor, reg_c = result
+// Compare:     reg_a = op1, reg_b = op2, field_a = BF, immediate = op2 immediate
+// Trap:        reg_a = op1, reg_b = op2, field_a = TO, immediate = op2 immediate
+// Logical:     reg_a = op1, reg_b = op2, reg_c = result, immediate = op2 immediate
+// Rotate:      reg_a = source, reg_b = shift, reg_c = target, field_a = shift immediate, field_b = MB, field_c = ME
+// System:      reg_c = RS/RT, field_a = FXM, immediate = SPR
+// Branch:      field_a = BO, field_b = BI, field_c = BH, immediate = LI or BD
+// Condition:   reg_a = op1, reg_b = op2, reg_c = result
+// System call: field_a = LEV
+//
+// Fused operations:
+// lis + ori:     reg_c = target, immediate = constant
+// addis + load:  reg_a = addis source (SUM1_IMM for zero), reg_b = addis target, reg_c = load result,
+//                field_a = word size, immediate = addis immediate (upper half) | load displacement (lower half)
+// rlwinm + cmpi: reg_a = source, reg_c = target, field_a = shift, field_b = MB, field_c = ME, field_d = BF,
+//                immediate = compare immediate
+// cmp + bc:      reg_a = op1, reg_b = op2, field_a = BO, field_b = BI, field_c = BF,
+//                immediate = BD (upper half) | compare immediate (lower half)
+namespace micro_op {
+#ifndef __SYNTHESIS__
+    static_assert(sizeof(micro_op_t) == 16, "micro_op_t has to stay 16 bytes");
+#endif
+
+
+    inline micro_op_t init(opcode_t opcode) {
+#pragma HLS inline
+        micro_op_t op;
+        op.opcode = opcode;
+        op.operation = 0;
+        op.flags = 0;
+        op.reg_a = 0;
+        op.reg_b = 0;
+        op.reg_c = 0;
+        op.reg_d = 0;
+        op.field_a = 0;
+        op.field_b = 0;
+        op.field_c = 0;
+        op.field_d = 0;
+        op.immediate = 0;
+        return op;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const load_store_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.flags = (decoded.sum1_imm ? SUM1_IMM : 0) |
+                   (decoded.sum2_imm ? SUM2_IMM : 0) |
+                   (decoded.write_ea ? WRITE_EA : 0) |
+                   (decoded.sign_extend ? SIGN_EXTEND : 0) |
+                   (decoded.little_endian ? BYTE_REVERSED : 0) |
+                   (decoded.multiple ? MULTIPLE : 0);
+        op.reg_a = decoded.sum1_reg_address;
+        op.reg_b = decoded.sum2_reg_address;
+        op.reg_c = decoded.result_reg_address;
+        op.reg_d = decoded.ea_reg_address;
+        op.field_a = decoded.word_size;
+        op.immediate = (int32_t) decoded.sum2_immediate;
+        return op;
+    }
+
+    inline load_store_decode_t unpack_load_store(const micro_op_t &op) {
+#pragma HLS inline
+        load_store_decode_t decoded;
+        decoded.word_size = op.field_a;
+        decoded.sum1_imm = op.flags & SUM1_IMM;
+        decoded.sum1_immediate = 0;
+        decoded.sum1_reg_address = op.reg_a;
+        decoded.sum2_imm = op.flags & SUM2_IMM;
+        decoded.sum2_immediate = op.immediate;
+        decoded.sum2_reg_address = op.reg_b;
+        decoded.write_ea = op.flags & WRITE_EA;
+        decoded.ea_reg_address = op.reg_d;
+        decoded.result_reg_address = op.reg_c;
+        decoded.sign_extend = op.flags & SIGN_EXTEND;
+        decoded.little_endian = op.flags & BYTE_REVERSED;
+        decoded.multiple = op.flags & MULTIPLE;
+        return decoded;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const add_sub_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.flags = (decoded.subtract ? SUBTRACT : 0) |
+                   (decoded.op1_imm ? OP1_IMM : 0) |
+                   (decoded.op2_imm ? OP2_IMM : 0) |
+                   (decoded.alter_CA ? ALTER_CA : 0) |
+                   (decoded.alter_CR0 ? ALTER_CR0 : 0) |
+                   (decoded.alter_OV ? ALTER_OV : 0) |
+                   (decoded.add_CA ? ADD_CA : 0);
+        op.reg_a = decoded.op1_reg_address;
+        op.reg_b = decoded.op2_reg_address;
+        op.reg_c = decoded.result_reg_address;
+        op.immediate = (int32_t) decoded.op2_immediate;
+        return op;
+    }
+
+    inline add_sub_decode_t unpack_add_sub(const micro_op_t &op) {
+#pragma HLS inline
+        add_sub_decode_t decoded;
+        decoded.subtract = op.flags & SUBTRACT;
+        decoded.op1_imm = op.flags & OP1_IMM;
+        decoded.op1_immediate = 0;
+        decoded.op1_reg_address = op.reg_a;
+        decoded.op2_imm = op.flags & OP2_IMM;
+        decoded.op2_immediate = op.immediate;
+        decoded.op2_reg_address = op.reg_b;
+        decoded.result_reg_address = op.reg_c;
+        decoded.alter_CA = op.flags & ALTER_CA;
+        decoded.alter_CR0 = op.flags & ALTER_CR0;
+        decoded.alter_OV = op.flags & ALTER_OV;
+        decoded.add_CA = op.flags & ADD_CA;
+        return decoded;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const mul_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.flags = (decoded.op2_imm ? OP2_IMM : 0) |
+                   (decoded.mul_signed ? SIGNED : 0) |
+                   (decoded.mul_higher ? HIGHER : 0) |
+                   (decoded.alter_CR0 ? ALTER_CR0 : 0) |
+                   (decoded.alter_OV ? ALTER_OV : 0);
+        op.reg_a = decoded.op1_reg_address;
+        op.reg_b = decoded.op2_reg_address;
+        op.reg_c = decoded.result_reg_address;
+        op.immediate = (int32_t) decoded.op2_immediate;
+        return op;
+    }
+
+    inline mul_decode_t unpack_mul(const micro_op_t &op) {
+#pragma HLS inline
+        mul_decode_t decoded;
+        decoded.op1_reg_address = op.reg_a;
+        decoded.op2_imm = op.flags & OP2_IMM;
+        decoded.op2_immediate = op.immediate;
+        decoded.op2_reg_address = op.reg_b;
+        decoded.result_reg_address = op.reg_c;
+        decoded.mul_signed = op.flags & SIGNED;
+        decoded.mul_higher = op.flags & HIGHER;
+        decoded.alter_CR0 = op.flags & ALTER_CR0;
+        decoded.alter_OV = op.flags & ALTER_OV;
+        return decoded;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const div_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.flags = (decoded.div_signed ? SIGNED : 0) |
+                   (decoded.alter_CR0 ? ALTER_CR0 : 0) |
+                   (decoded.alter_OV ? ALTER_OV : 0);
+        op.reg_a = decoded.dividend_reg_address;
+        op.reg_b = decoded.divisor_reg_address;
+        op.reg_c = decoded.result_reg_address;
+        return op;
+    }
+
+    inline div_decode_t unpack_div(const micro_op_t &op) {
+#pragma HLS inline
+        div_decode_t decoded;
+        decoded.dividend_reg_address = op.reg_a;
+        decoded.divisor_reg_address = op.reg_b;
+        decoded.result_reg_address = op.reg_c;
+        decoded.div_signed = op.flags & SIGNED;
+        decoded.alter_CR0 = op.flags & ALTER_CR0;
+        decoded.alter_OV = op.flags & ALTER_OV;
+        return decoded;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const cmp_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.flags = (decoded.op2_imm ? OP2_IMM : 0) |
+                   (decoded.cmp_signed ? SIGNED : 0);
+        op.reg_a = decoded.op1_reg_address;
+        op.reg_b = decoded.op2_reg_address;
+        op.field_a = decoded.BF;
+        op.immediate = (int32_t) decoded.op2_immediate;
+        return op;
+    }
+
+    inline cmp_decode_t unpack_cmp(const micro_op_t &op) {
+#pragma HLS inline
+        cmp_decode_t decoded;
+        decoded.op1_reg_address = op.reg_a;
+        decoded.op2_imm = op.flags & OP2_IMM;
+        decoded.op2_immediate = op.immediate;
+        decoded.op2_reg_address = op.reg_b;
+        decoded.cmp_signed = op.flags & SIGNED;
+        decoded.BF = op.field_a;
+        return decoded;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const trap_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.flags = decoded.op2_imm ? OP2_IMM : 0;
+        op.reg_a = decoded.op1_reg_address;
+        op.reg_b = decoded.op2_reg_address;
+        op.field_a = decoded.TO;
+        op.immediate = (int32_t) decoded.op2_immediate;
+        return op;
+    }
+
+    inline trap_decode_t unpack_trap(const micro_op_t &op) {
+#pragma HLS inline
+        trap_decode_t decoded;
+        decoded.op1_reg_address = op.reg_a;
+        decoded.op2_imm = op.flags & OP2_IMM;
+        decoded.op2_immediate = op.immediate;
+        decoded.op2_reg_address = op.reg_b;
+        decoded.TO = op.field_a;
+        return decoded;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const log_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.operation = decoded.operation;
+        op.flags = (decoded.op2_imm ? OP2_IMM : 0) |
+                   (decoded.alter_CR0 ? ALTER_CR0 : 0);
+        op.reg_a = decoded.op1_reg_address;
+        op.reg_b = decoded.op2_reg_address;
+        op.reg_c = decoded.result_reg_address;
+        op.immediate = decoded.op2_immediate;
+        return op;
+    }
+
+    inline log_decode_t unpack_log(const micro_op_t &op) {
+#pragma HLS inline
+        log_decode_t decoded;
+        decoded.operation = (logical::logical_op_t) op.operation;
+        decoded.op1_reg_address = op.reg_a;
+        decoded.op2_imm = op.flags & OP2_IMM;
+        decoded.op2_immediate = op.immediate;
+        decoded.op2_reg_address = op.reg_b;
+        decoded.result_reg_address = op.reg_c;
+        decoded.alter_CR0 = op.flags & ALTER_CR0;
+        return decoded;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const rotate_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.flags = (decoded.shift_imm ? OP2_IMM : 0) |
+                   (decoded.mask_insert ? MASK_INSERT : 0) |
+                   (decoded.shift ? SHIFT : 0) |
+                   (decoded.left ? LEFT : 0) |
+                   (decoded.sign_extend ? SHIFT_SIGN_EXTEND : 0) |
+                   (decoded.alter_CR0 ? ALTER_CR0 : 0);
+        op.reg_a = decoded.source_reg_address;
+        op.reg_b = decoded.shift_reg_address;
+        op.reg_c = decoded.target_reg_address;
+        op.field_a = decoded.shift_immediate;
+        op.field_b = decoded.MB;
+        op.field_c = decoded.ME;
+        return op;
+    }
+
+    inline rotate_decode_t unpack_rotate(const micro_op_t &op) {
+#pragma HLS inline
+        rotate_decode_t decoded;
+        decoded.shift_imm = op.flags & OP2_IMM;
+        decoded.shift_immediate = op.field_a;
+        decoded.shift_reg_address = op.reg_b;
+        decoded.source_reg_address = op.reg_a;
+        decoded.target_reg_address = op.reg_c;
+        decoded.MB = op.field_b;
+        decoded.ME = op.field_c;
+        decoded.mask_insert = op.flags & MASK_INSERT;
+        decoded.shift = op.flags & SHIFT;
+        decoded.left = op.flags & LEFT;
+        decoded.sign_extend = op.flags & SHIFT_SIGN_EXTEND;
+        decoded.alter_CR0 = op.flags & ALTER_CR0;
+        return decoded;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const system_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.operation = decoded.operation;
+        op.reg_c = decoded.RS_RT;
+        op.field_a = decoded.FXM;
+        op.immediate = decoded.SPR;
+        return op;
+    }
+
+    inline system_decode_t unpack_system(const micro_op_t &op) {
+#pragma HLS inline
+        system_decode_t decoded;
+        decoded.operation = (system_ppc::system_op_t) op.operation;
+        decoded.RS_RT = op.reg_c;
+        decoded.SPR = op.immediate;
+        decoded.FXM = op.field_a;
+        return decoded;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const branch_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.operation = decoded.operation;
+        op.flags = (decoded.LK ? LK : 0) |
+                   (decoded.AA ? AA : 0);
+        op.field_a = decoded.BO;
+        op.field_b = decoded.BI;
+        op.field_c = decoded.BH;
+        // Only unconditional branches use LI, all others use BD
+        if(decoded.operation == ::BRANCH) {
+            op.immediate = decoded.LI;
+        } else {
+            op.immediate = decoded.BD;
+        }
+        return op;
+    }
+
+    inline branch_decode_t unpack_branch(const micro_op_t &op) {
+#pragma HLS inline
+        branch_decode_t decoded;
+        decoded.operation = (branch_op_t) op.operation;
+        decoded.LK = (op.flags & LK) != 0;
+        decoded.AA = (op.flags & AA) != 0;
+        if(decoded.operation == ::BRANCH) {
+            decoded.LI = op.immediate;
+            decoded.BD = 0;
+        } else {
+            decoded.LI = 0;
+            decoded.BD = op.immediate;
+        }
+        decoded.BI = op.field_b;
+        decoded.BO = op.field_a;
+        decoded.BH = op.field_c;
+        return decoded;
+    }
+
+    // Computes the target of a branch with a target encoded in the instruction (b and bc).
+    // Returns false for branches to the link or count register, since their target is only known at runtime.
+    // The program counter has to be the address of the branch.
+    inline bool direct_branch_target(const micro_op_t &op, uint32_t program_counter, uint32_t &target) {
+#pragma HLS inline
+        int32_t displacement;
+        if(op.opcode == FUSED_COMPARE_BRANCH) {
+            // Fused branches are always relative, their flags belong to the compare and OP2_IMM shares the bit with AA
+            // Sign extend BD || 0b00
+            target = program_counter + (((int32_t) ((op.immediate >> 16) << 18)) >> 16);
+            return true;
+        } else if(op.opcode != BRANCH) {
+            return false;
+        } else if(op.operation == ::BRANCH) {
+            // Sign extend LI || 0b00
+            displacement = ((int32_t) (op.immediate << 8)) >> 6;
+        } else if(op.operation == BRANCH_CONDITIONAL) {
+            // Sign extend BD || 0b00
+            displacement = ((int32_t) (op.immediate << 18)) >> 16;
+        } else {
+            return false;
+        }
+
+        if(op.flags & AA) {
+            target = displacement;
+        } else {
+            target = program_counter + displacement;
+        }
+        return true;
+    }
+
+    inline micro_op_t pack(opcode_t opcode, const condition_decode_t &decoded) {
+#pragma HLS inline
+        micro_op_t op = init(opcode);
+        op.operation = decoded.operation;
+        op.reg_a = decoded.CR_op1_reg_address;
+        op.reg_b = decoded.CR_op2_reg_address;
+        op.reg_c = decoded.CR_result_reg_address;
+        return op;
+    }
+
+    inline condition_decode_t unpack_condition(const micro_op_t &op) {
+#pragma HLS inline
+        condition_decode_t decoded;
+        decoded.operation = (condition::condition_op_t) op.operation;
+        decoded.CR_op1_reg_address = op.reg_a;
+        decoded.CR_op2_reg_address = op.reg_b;
+        decoded.CR_result_reg_address = op.reg_c;
+        return decoded;
+    }
+
+    inline micro_op_t pack_system_call(system_call_decode_t decoded) {
+#pragma HLS inline
+        micro_op_t op = init(SYSTEM_CALL);
+        op.field_a = decoded;
+        return op;
+    }
+
+    inline system_call_decode_t unpack_system_call(const micro_op_t &op) {
+#pragma HLS inline
+        return op.field_a;
+    }
+    // Number of instructions executed by the micro-op
+    inline uint32_t length(const micro_op_t &op) {
+#pragma HLS inline
+        if(op.opcode >= FUSED_LOAD_IMMEDIATE) {
+            return 2;
+        }
+        return 1;
+    }
+
+    // Branches have to be executed with the program counter set to their own address
+    inline bool is_branch(const micro_op_t &op) {
+#pragma HLS inline
+        return op.opcode == BRANCH || op.opcode == FUSED_COMPARE_BRANCH;
+    }
+
+    inline add_sub_decode_t unpack_fused_addis(const micro_op_t &op) {
+#pragma HLS inline
+        add_sub_decode_t decoded;
+        decoded.subtract = false;
+        decoded.op1_imm = op.flags & SUM1_IMM;
+        decoded.op1_immediate = 0;
+        decoded.op1_reg_address = op.reg_a;
+        decoded.op2_imm = true;
+        decoded.op2_immediate = (int32_t) (op.immediate & 0xFFFF0000);
+        decoded.op2_reg_address = 0;
+        decoded.result_reg_address = op.reg_b;
+        decoded.alter_CA = false;
+        decoded.alter_CR0 = false;
+        decoded.alter_OV = false;
+        decoded.add_CA = false;
+        return decoded;
+    }
+
+    inline load_store_decode_t unpack_fused_load(const micro_op_t &op) {
+#pragma HLS inline
+        load_store_decode_t decoded;
+        decoded.word_size = op.field_a;
+        decoded.sum1_imm = false;
+        decoded.sum1_immediate = 0;
+        decoded.sum1_reg_address = op.reg_b;
+        decoded.sum2_imm = true;
+        decoded.sum2_immediate = (int16_t) (op.immediate & 0xFFFF);
+        decoded.sum2_reg_address = 0;
+        decoded.write_ea = false;
+        decoded.ea_reg_address = 0;
+        decoded.result_reg_address = op.reg_c;
+        decoded.sign_extend = op.flags & SIGN_EXTEND;
+        decoded.little_endian = false;
+        decoded.multiple = false;
+        return decoded;
+    }
+
+    inline rotate_decode_t unpack_fused_rotate(const micro_op_t &op) {
+#pragma HLS inline
+        rotate_decode_t decoded;
+        decoded.shift_imm = true;
+        decoded.shift_immediate = op.field_a;
+        decoded.shift_reg_address = 0;
+        decoded.source_reg_address = op.reg_a;
+        decoded.target_reg_address = op.reg_c;
+        decoded.MB = op.field_b;
+        decoded.ME = op.field_c;
+        decoded.mask_insert = false;
+        decoded.shift = false;
+        decoded.left = false;
+        decoded.sign_extend = false;
+        decoded.alter_CR0 = false;
+        return decoded;
+    }
+
+    // Compare of a fused rlwinm + cmpi
+    inline cmp_decode_t unpack_fused_rotate_compare(const micro_op_t &op) {
+#pragma HLS inline
+        cmp_decode_t decoded;
+        decoded.op1_reg_address = op.reg_c;
+        decoded.op2_imm = true;
+        decoded.op2_immediate = op.immediate;
+        decoded.op2_reg_address = 0;
+        decoded.cmp_signed = op.flags & SIGNED;
+        decoded.BF = op.field_d;
+        return decoded;
+    }
+
+    // Compare of a fused cmp + bc
+    inline cmp_decode_t unpack_fused_branch_compare(const micro_op_t &op) {
+#pragma HLS inline
+        cmp_decode_t decoded;
+        decoded.op1_reg_address = op.reg_a;
+        decoded.op2_imm = op.flags & OP2_IMM;
+        if(op.flags & SIGNED) {
+            decoded.op2_immediate = (int16_t) (op.immediate & 0xFFFF);
+        } else {
+            decoded.op2_immediate = op.immediate & 0xFFFF;
+        }
+        decoded.op2_reg_address = op.reg_b;
+        decoded.cmp_signed = op.flags & SIGNED;
+        decoded.BF = op.field_c;
+        return decoded;
+    }
+
+    // Branch of a fused cmp + bc
+    inline branch_decode_t unpack_fused_branch(const micro_op_t &op) {
+#pragma HLS inline
+        branch_decode_t decoded;
+        decoded.operation = BRANCH_CONDITIONAL;
+        decoded.LK = 0;
+        decoded.AA = 0;
+        decoded.LI = 0;
+        decoded.BD = op.immediate >> 16;
+        decoded.BI = op.field_b;
+        decoded.BO = op.field_a;
+        decoded.BH = 0;
+        return decoded;
+    }
+}
+
+#endif //POWERPC_HLS_MICRO_OP_HPP
@@ -0,0 +1,198 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "mmio.hpp"
+#include <algorithm>
+#include "replay.hpp"
+
+thread_local uint32_t mmio::window_start = 0;
+thread_local uint32_t mmio::window_size = 0;
+
+namespace {
+    thread_local std::vector<mmio::region_t> regions;
+    thread_local uint64_t accesses = 0;
+
+    const mmio::region_t *find(uint32_t address) {
+        for(const mmio::region_t &region : regions) {
+            if(address - region.start < region.size) {
+                return &region;
+            }
+        }
+        return nullptr;
+    }
+
+    // Elements outside of all regions go to the RAM, big endian like the devices
+    uint32_t read(uint32_t address, uint32_t size, const mmio::ram_t &ram) {
+        const mmio::region_t *region = find(address);
+        if(region == nullptr) {
+            uint32_t value = 0;
+            for(uint32_t i = 0; i < size; i++) {
+                value = (value << 8) | ram.read(address + i);
+            }
+            return value;
+        }
+        accesses++;
+        uint32_t value = region->read ? region->read(address, size) : 0;
+        value = size < 4 ? value & ((1u << (size*8)) - 1) : value;
+        replay::device_read(address, size, value);
+        return value;
+    }
+
+    void write(uint32_t address, uint32_t size, uint32_t value, const mmio::ram_t &ram) {
+        const mmio::region_t *region = find(address);
+        if(region == nullptr) {
+            for(uint32_t i = 0; i < size; i++) {
+                ram.write(address + i, (uint8_t) (value >> ((size - 1 - i) * 8)));
+            }
+            return;
+        }
+        accesses++;
+        replay::device_write(address, size, value);
+        if(region->write) {
+            region->write(address, size, value);
+        }
+    }
+
+    uint32_t reverse_bytes(uint32_t value, uint32_t size) {
+        switch(size) {
+            case 2:
+                return __builtin_bswap16(value);
+            case 4:
+                return __builtin_bswap32(value);
+            default:
+                return value;
+        }
+    }
+}
+
+bool mmio::map(uint32_t start, uint32_t size, read_callback_t read, write_callback_t write) {
+    if(size == 0) {
+        return false;
+    }
+    for(const region_t &region : regions) {
+        if((uint64_t) start + size > region.start && start < (uint64_t) region.start + region.size) {
+            return false;
+        }
+    }
+    regions.push_back({start, size, read, write});
+
+    uint64_t first = regions[0].start;
+    uint64_t last = (uint64_t) regions[0].start + regions[0].size;
+    for(const region_t &region : regions) {
+        first = std::min<uint64_t>(first, region.start);
+        last = std::max<uint64_t>(last, (uint64_t) region.start + region.size);
+    }
+    window_start = first;
+    window_size = std::min<uint64_t>(last - first, UINT32_MAX);
+    return true;
+}
+
+void mmio::unmap_all() {
+    regions.clear();
+    window_start = 0;
+    window_size = 0;
+}
+
+const std::vector<mmio::region_t> &mmio::mapped_regions() {
+    return regions;
+}
+
+bool mmio::claims(uint32_t address, uint32_t size) {
+    for(const region_t &region : regions) {
+        if((uint64_t) address + size > region.start && address < (uint64_t) region.start + region.size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t mmio::access_count() {
+    return accesses;
+}
+
+void mmio::load(load_store_decode_t decoded, uint32_t effective_address, registers_t &registers, const ram_t &ram) {
+    uint32_t size = (uint32_t) decoded.word_size + 1;
+    uint32_t address = effective_address;
+    uint32_t last = decoded.multiple ? 31 : (uint32_t) decoded.result_reg_address;
+    for(uint32_t i = decoded.result_reg_address; i <= last; i++, address += size) {
+        uint32_t value = read(address, size, ram);
+        if(decoded.little_endian) {
+            value = reverse_bytes(value, size);
+        }
+        if(decoded.sign_extend && size == 1) {
+            value = (int32_t) (int8_t) value;
+        } else if(decoded.sign_extend && size == 2) {
+            value = (int32_t) (int16_t) value;
+        }
+        registers.GPR[i] = value;
+    }
+
+    if(decoded.write_ea) {
+        registers.GPR[decoded.ea_reg_address] = effective_address;
+    }
+}
+
+void mmio::store(load_store_decode_t decoded, uint32_t effective_address, registers_t &registers, const ram_t &ram) {
+    uint32_t size = (uint32_t) decoded.word_size + 1;
+    uint32_t address = effective_address;
+    uint32_t last = decoded.multiple ? 31 : (uint32_t) decoded.result_reg_address;
+    for(uint32_t i = decoded.result_reg_address; i <= last; i++, address += size) {
+        uint32_t value = registers.GPR[i];
+        if(size < 4) {
+            value &= (1u << (size*8)) - 1;
+        }
+        if(decoded.little_endian) {
+            value = reverse_bytes(value, size);
+        }
+        write(address, size, value, ram);
+    }
+
+    if(decoded.write_ea) {
+        registers.GPR[decoded.ea_reg_address] = effective_address;
+    }
+}
+
+void mmio::load_string(uint32_t first_register, uint32_t n, uint32_t effective_address, registers_t &registers,
+                       const ram_t &ram) {
+    uint32_t r = first_register;
+    for(uint32_t i = 0; i < n; i++) {
+        if(i % 4 == 0) {
+            if(i != 0) {
+                r = (r + 1) % 32;
+            }
+            registers.GPR[r] = 0;
+        }
+        uint32_t shift = (3 - i % 4) * 8;
+        registers.GPR[r] = (uint32_t) registers.GPR[r] | (read(effective_address + i, 1, ram) << shift);
+    }
+}
+
+void mmio::store_string(uint32_t first_register, uint32_t n, uint32_t effective_address, registers_t &registers,
+                        const ram_t &ram) {
+    uint32_t r = first_register;
+    for(uint32_t i = 0; i < n; i++) {
+        if(i % 4 == 0 && i != 0) {
+            r = (r + 1) % 32;
+        }
+        uint32_t shift = (3 - i % 4) * 8;
+        write(effective_address + i, 1, ((uint32_t) registers.GPR[r] >> shift) & 0xFF, ram);
+    }
+}
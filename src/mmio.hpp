@@ -0,0 +1,107 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_MMIO_HPP
+#define POWERPC_HLS_MMIO_HPP
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include "ppc_int.hpp"
+#include "ppc_types.h"
+
+// Software simulation only!
+// Table of memory mapped I/O regions. Loads and stores with an effective address inside of a region are passed to
+// the callbacks of its device instead of the data memory. Addresses outside of the window, which spans all regions,
+// are rejected with a single compare, so RAM accesses stay cheap. Inside of the window every region is checked, so
+// RAM between two regions is still served by the data memory.
+// Every host thread has its own table, so parallel instances can attach their own devices.
+namespace mmio {
+    // Accesses are 1, 2 or 4 bytes wide, values are big endian like in the registers
+    typedef std::function<uint32_t(uint32_t address, uint32_t size)> read_callback_t;
+    typedef std::function<void(uint32_t address, uint32_t size, uint32_t value)> write_callback_t;
+
+    typedef struct {
+        uint32_t start;
+        uint32_t size;
+        read_callback_t read;
+        write_callback_t write;
+    } region_t;
+
+    // Byte access to the data memory for the parts of an access that are not mapped
+    typedef struct {
+        std::function<uint8_t(uint32_t address)> read;
+        std::function<void(uint32_t address, uint8_t value)> write;
+    } ram_t;
+
+    // Returns false and maps nothing if the region is empty or overlaps a mapped region.
+    // A missing callback ignores writes or reads zero.
+    bool map(uint32_t start, uint32_t size, read_callback_t read, write_callback_t write);
+    void unmap_all();
+    const std::vector<region_t> &mapped_regions();
+
+    extern thread_local uint32_t window_start;
+    extern thread_local uint32_t window_size;
+
+    // Checks every region, only called for accesses within the window
+    bool claims(uint32_t address, uint32_t size);
+
+    // True if any byte of address to address + size - 1 is mapped
+    inline bool overlaps(uint32_t address, uint32_t size) {
+        return (uint64_t) address + size > window_start && address < (uint64_t) window_start + window_size &&
+               claims(address, size);
+    }
+
+    inline bool mapped(uint32_t address) {
+        return overlaps(address, 1);
+    }
+
+    // Number of device accesses so far, changes tell that a loop depends on a device
+    uint64_t access_count();
+
+    // Executes a load, store, lmw or stmw on the devices, elements outside of all regions go to the RAM
+    void load(load_store_decode_t decoded, uint32_t effective_address, registers_t &registers, const ram_t &ram);
+    void store(load_store_decode_t decoded, uint32_t effective_address, registers_t &registers, const ram_t &ram);
+    // Executes a string load or store of n bytes starting with register first_register on the devices
+    void load_string(uint32_t first_register, uint32_t n, uint32_t effective_address, registers_t &registers,
+                     const ram_t &ram);
+    void store_string(uint32_t first_register, uint32_t n, uint32_t effective_address, registers_t &registers,
+                      const ram_t &ram);
+
+    // Byte access to a data memory of 32 bit words, byte 0 of a word is in its lowest bits
+    template<typename T>
+    ram_t ram(T &data_memory) {
+        return {
+            [&data_memory](uint32_t address) -> uint8_t {
+                uint32_t word = data_memory[address >> 2];
+                return (uint8_t) (word >> ((address & 3) * 8));
+            },
+            [&data_memory](uint32_t address, uint8_t value) {
+                uint32_t word = data_memory[address >> 2];
+                uint32_t shift = (address & 3) * 8;
+                word = (word & ~(0xFFu << shift)) | ((uint32_t) value << shift);
+                data_memory[address >> 2] = (ppc_uint<32>) word;
+            }
+        };
+    }
+}
+
+#endif //POWERPC_HLS_MMIO_HPP
@@ -0,0 +1,365 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_NATIVE_INT_HPP
+#define POWERPC_HLS_NATIVE_INT_HPP
+
+#include <cstdint>
+#include <cassert>
+#include <type_traits>
+
+// Software simulation only!
+// Fixed width integers with the interface of ap_uint/ap_int used by this project: bit and range selection,
+// implicit widening arithmetic and conversion to the native integer types.
+// The value is kept in the smallest native word, which holds W bits, unused upper bits are always zero.
+// Arithmetic is done in int64_t, or __int128 if the result can exceed 64 bits.
+
+namespace native_detail {
+    template<int W> struct storage {
+        typedef typename std::conditional<(W <= 32), uint32_t,
+                typename std::conditional<(W <= 64), uint64_t, unsigned __int128>::type>::type type;
+    };
+
+    template<int BITS> struct wide {
+        typedef typename std::conditional<(BITS <= 64), int64_t, __int128>::type type;
+    };
+
+    template<typename T> struct is_integer : std::integral_constant<bool, std::is_integral<T>::value ||
+            std::is_same<T, __int128>::value || std::is_same<T, unsigned __int128>::value> {};
+
+    // Bits needed to hold any value of T as a signed number
+    template<typename T> struct integer_bits {
+        static const int value = (int) sizeof(T) * 8 +
+                                 (std::is_signed<T>::value || std::is_same<T, __int128>::value ? 0 : 1);
+    };
+
+    template<bool FITS_64> struct result { typedef int64_t type; };
+    template<> struct result<false> { typedef __int128 type; };
+}
+
+template<int W, bool S> class native_integer;
+
+template<int W, bool S>
+class native_bit_ref {
+public:
+    typedef typename native_integer<W, S>::storage_t storage_t;
+
+    native_bit_ref(native_integer<W, S> *parent, int index) : parent(parent), index(index) {
+    }
+
+    operator bool() const {
+        return (parent->V >> index) & 1;
+    }
+
+    bool operator~() const {
+        return !bool(*this);
+    }
+
+    native_bit_ref &operator=(bool value) {
+        parent->V = (parent->V & ~(storage_t(1) << index)) | (storage_t(value ? 1 : 0) << index);
+        return *this;
+    }
+
+    template<typename I, typename std::enable_if<native_detail::is_integer<I>::value && !std::is_same<I, bool>::value, int>::type = 0>
+    native_bit_ref &operator=(I value) {
+        return *this = (bool) (value & 1);
+    }
+
+    native_bit_ref &operator=(const native_bit_ref &other) {
+        return *this = bool(other);
+    }
+
+    template<int W2, bool S2>
+    native_bit_ref &operator=(const native_bit_ref<W2, S2> &other) {
+        return *this = bool(other);
+    }
+
+private:
+    native_integer<W, S> *parent;
+    int index;
+};
+
+template<int W, bool S>
+class native_range_ref {
+public:
+    typedef typename native_integer<W, S>::storage_t storage_t;
+
+    native_range_ref(native_integer<W, S> *parent, int high, int low) : parent(parent), high(high), low(low) {
+        assert(high >= low && high < W && low >= 0);
+    }
+
+    storage_t mask() const {
+        int width = high - low + 1;
+        return width >= (int) (sizeof(storage_t) * 8) ? ~storage_t(0) : ((storage_t(1) << width) - 1);
+    }
+
+    unsigned long long get() const {
+        return (unsigned long long) ((parent->V >> low) & mask());
+    }
+
+    operator unsigned long long() const {
+        return get();
+    }
+
+    native_range_ref &set(unsigned __int128 value) {
+        storage_t field = mask() << low;
+        parent->V = (parent->V & ~field) | ((storage_t(value) << low) & field);
+        parent->normalize();
+        return *this;
+    }
+
+    template<typename I, typename std::enable_if<native_detail::is_integer<I>::value, int>::type = 0>
+    native_range_ref &operator=(I value) {
+        return set((unsigned __int128) value);
+    }
+
+    template<int W2, bool S2>
+    native_range_ref &operator=(const native_integer<W2, S2> &value) {
+        return set((unsigned __int128) value.value());
+    }
+
+    native_range_ref &operator=(const native_range_ref &other) {
+        return set(other.get());
+    }
+
+    template<int W2, bool S2>
+    native_range_ref &operator=(const native_range_ref<W2, S2> &other) {
+        return set(other.get());
+    }
+
+    template<int W2, bool S2>
+    native_range_ref &operator=(const native_bit_ref<W2, S2> &other) {
+        return set(bool(other));
+    }
+
+private:
+    native_integer<W, S> *parent;
+    int high;
+    int low;
+};
+
+template<int W, bool S>
+class native_integer {
+public:
+    typedef typename native_detail::storage<W>::type storage_t;
+    typedef typename native_detail::wide<W + (S ? 0 : 1)>::type wide_t;
+    // Type for the implicit conversion, like ap_int it converts to the next native type of the same signedness
+    typedef typename std::conditional<(W <= 32), typename std::conditional<S, int, unsigned>::type,
+            typename std::conditional<(W <= 64), typename std::conditional<S, long long, unsigned long long>::type,
+                    typename std::conditional<S, __int128, unsigned __int128>::type>::type>::type native_t;
+
+    storage_t V;
+
+    static storage_t mask() {
+        return W >= (int) (sizeof(storage_t) * 8) ? ~storage_t(0) : ((storage_t(1) << W) - 1);
+    }
+
+    void normalize() {
+        V &= mask();
+    }
+
+    native_integer() : V(0) {
+    }
+
+    template<typename I, typename std::enable_if<native_detail::is_integer<I>::value, int>::type = 0>
+    native_integer(I value) : V(storage_t(value) & mask()) {
+    }
+
+    template<int W2, bool S2>
+    native_integer(const native_integer<W2, S2> &other) : V(storage_t(other.value()) & mask()) {
+    }
+
+    template<int W2, bool S2>
+    native_integer(const native_bit_ref<W2, S2> &other) : V(bool(other)) {
+    }
+
+    template<int W2, bool S2>
+    native_integer(const native_range_ref<W2, S2> &other) : V(storage_t(other.get()) & mask()) {
+    }
+
+    // Sign extended value
+    wide_t value() const {
+        if(S && ((V >> (W - 1)) & 1)) {
+            return (wide_t) V - ((wide_t) 1 << (W - 1)) - ((wide_t) 1 << (W - 1));
+        }
+        return (wide_t) V;
+    }
+
+    operator native_t() const {
+        return (native_t) value();
+    }
+
+    native_bit_ref<W, S> operator[](int index) {
+        return native_bit_ref<W, S>(this, index);
+    }
+
+    bool operator[](int index) const {
+        return (V >> index) & 1;
+    }
+
+    native_range_ref<W, S> operator()(int high, int low) {
+        return native_range_ref<W, S>(this, high, low);
+    }
+
+    native_range_ref<W, S> range(int high, int low) {
+        return native_range_ref<W, S>(this, high, low);
+    }
+
+    unsigned long long operator()(int high, int low) const {
+        return native_range_ref<W, S>(const_cast<native_integer *>(this), high, low).get();
+    }
+
+    native_integer operator~() const {
+        native_integer result;
+        result.V = ~V & mask();
+        return result;
+    }
+
+    wide_t operator-() const {
+        return -value();
+    }
+
+    template<typename I, typename std::enable_if<native_detail::is_integer<I>::value, int>::type = 0>
+    native_integer operator<<(I shift) const {
+        native_integer result;
+        result.V = (shift >= (int) sizeof(storage_t) * 8) ? 0 : ((V << shift) & mask());
+        return result;
+    }
+
+    template<typename I, typename std::enable_if<native_detail::is_integer<I>::value, int>::type = 0>
+    native_integer operator>>(I shift) const {
+        // Arithmetic shift for signed values
+        native_integer result = value() >> (shift >= W ? W - 1 : (int) shift);
+        if(!S && shift >= W) {
+            result = 0;
+        }
+        return result;
+    }
+
+    template<int W2, bool S2>
+    native_integer operator<<(const native_integer<W2, S2> &shift) const {
+        return *this << (long long) shift.value();
+    }
+
+    template<int W2, bool S2>
+    native_integer operator>>(const native_integer<W2, S2> &shift) const {
+        return *this >> (long long) shift.value();
+    }
+
+    native_integer &operator++() {
+        *this = value() + 1;
+        return *this;
+    }
+
+    native_integer &operator--() {
+        *this = value() - 1;
+        return *this;
+    }
+
+    native_integer operator++(int) {
+        native_integer old = *this;
+        ++*this;
+        return old;
+    }
+
+    native_integer operator--(int) {
+        native_integer old = *this;
+        --*this;
+        return old;
+    }
+
+#define NATIVE_COMPOUND_ASSIGNMENT(op) \
+    template<typename T> native_integer &operator op##=(const T &other) { *this = (*this op other); return *this; }
+    NATIVE_COMPOUND_ASSIGNMENT(+)
+    NATIVE_COMPOUND_ASSIGNMENT(-)
+    NATIVE_COMPOUND_ASSIGNMENT(*)
+    NATIVE_COMPOUND_ASSIGNMENT(/)
+    NATIVE_COMPOUND_ASSIGNMENT(%)
+    NATIVE_COMPOUND_ASSIGNMENT(&)
+    NATIVE_COMPOUND_ASSIGNMENT(|)
+    NATIVE_COMPOUND_ASSIGNMENT(^)
+    NATIVE_COMPOUND_ASSIGNMENT(<<)
+    NATIVE_COMPOUND_ASSIGNMENT(>>)
+#undef NATIVE_COMPOUND_ASSIGNMENT
+};
+
+// Binary operators widen like ap_int: the result holds every possible value of both operands
+#define NATIVE_BINARY_OPERATOR(op, BITS)                                                                           \
+template<int W1, bool S1, int W2, bool S2>                                                                          \
+typename native_detail::result<(BITS(W1 + (S1 ? 0 : 1), W2 + (S2 ? 0 : 1))) <= 64>::type                           \
+operator op(const native_integer<W1, S1> &a, const native_integer<W2, S2> &b) {                                     \
+    typedef typename native_detail::result<(BITS(W1 + (S1 ? 0 : 1), W2 + (S2 ? 0 : 1))) <= 64>::type result_t;     \
+    return (result_t) a.value() op (result_t) b.value();                                                            \
+}                                                                                                                   \
+template<int W1, bool S1, typename I, typename std::enable_if<native_detail::is_integer<I>::value, int>::type = 0>  \
+typename native_detail::result<(BITS(W1 + (S1 ? 0 : 1), native_detail::integer_bits<I>::value)) <= 64>::type       \
+operator op(const native_integer<W1, S1> &a, I b) {                                                                 \
+    typedef typename native_detail::result<(BITS(W1 + (S1 ? 0 : 1), native_detail::integer_bits<I>::value)) <= 64>::type result_t; \
+    return (result_t) a.value() op (result_t) b;                                                                    \
+}                                                                                                                   \
+template<int W1, bool S1, typename I, typename std::enable_if<native_detail::is_integer<I>::value, int>::type = 0>  \
+typename native_detail::result<(BITS(W1 + (S1 ? 0 : 1), native_detail::integer_bits<I>::value)) <= 64>::type       \
+operator op(I b, const native_integer<W1, S1> &a) {                                                                 \
+    typedef typename native_detail::result<(BITS(W1 + (S1 ? 0 : 1), native_detail::integer_bits<I>::value)) <= 64>::type result_t; \
+    return (result_t) b op (result_t) a.value();                                                                    \
+}
+
+#define NATIVE_ADD_BITS(a, b) ((a) > (b) ? (a) + 1 : (b) + 1)
+#define NATIVE_MUL_BITS(a, b) ((a) + (b))
+#define NATIVE_MAX_BITS(a, b) ((a) > (b) ? (a) : (b))
+NATIVE_BINARY_OPERATOR(+, NATIVE_ADD_BITS)
+NATIVE_BINARY_OPERATOR(-, NATIVE_ADD_BITS)
+NATIVE_BINARY_OPERATOR(*, NATIVE_MUL_BITS)
+NATIVE_BINARY_OPERATOR(/, NATIVE_MAX_BITS)
+NATIVE_BINARY_OPERATOR(%, NATIVE_MAX_BITS)
+NATIVE_BINARY_OPERATOR(&, NATIVE_MAX_BITS)
+NATIVE_BINARY_OPERATOR(|, NATIVE_MAX_BITS)
+NATIVE_BINARY_OPERATOR(^, NATIVE_MAX_BITS)
+#undef NATIVE_BINARY_OPERATOR
+#undef NATIVE_ADD_BITS
+#undef NATIVE_MUL_BITS
+#undef NATIVE_MAX_BITS
+
+#define NATIVE_COMPARE_OPERATOR(op)                                                                                \
+template<int W1, bool S1, int W2, bool S2>                                                                          \
+bool operator op(const native_integer<W1, S1> &a, const native_integer<W2, S2> &b) {                                \
+    return (__int128) a.value() op (__int128) b.value();                                                            \
+}                                                                                                                   \
+template<int W1, bool S1, typename I, typename std::enable_if<native_detail::is_integer<I>::value, int>::type = 0>  \
+bool operator op(const native_integer<W1, S1> &a, I b) {                                                            \
+    return (__int128) a.value() op (__int128) b;                                                                    \
+}                                                                                                                   \
+template<int W1, bool S1, typename I, typename std::enable_if<native_detail::is_integer<I>::value, int>::type = 0>  \
+bool operator op(I b, const native_integer<W1, S1> &a) {                                                            \
+    return (__int128) b op (__int128) a.value();                                                                    \
+}
+NATIVE_COMPARE_OPERATOR(==)
+NATIVE_COMPARE_OPERATOR(!=)
+NATIVE_COMPARE_OPERATOR(<)
+NATIVE_COMPARE_OPERATOR(>)
+NATIVE_COMPARE_OPERATOR(<=)
+NATIVE_COMPARE_OPERATOR(>=)
+#undef NATIVE_COMPARE_OPERATOR
+
+template<int W> using native_uint = native_integer<W, false>;
+template<int W> using native_int = native_integer<W, true>;
+
+#endif //POWERPC_HLS_NATIVE_INT_HPP
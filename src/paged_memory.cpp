@@ -0,0 +1,121 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "paged_memory.hpp"
+#include <cassert>
+#include <algorithm>
+#include "fixed_point_processor.hpp"
+
+// The load and store templates take the memory by reference
+template void fixed_point::load<paged_memory &>(load_store_decode_t, registers_t &, paged_memory &);
+template void fixed_point::store<paged_memory &>(load_store_decode_t, registers_t &, paged_memory &);
+template void fixed_point::load_string<paged_memory &>(load_store_decode_t, registers_t &, paged_memory &);
+template void fixed_point::store_string<paged_memory &>(load_store_decode_t, registers_t &, paged_memory &);
+
+namespace {
+    std::atomic<uint64_t> next_id(1);
+}
+
+paged_memory::paged_memory(uint32_t page_bits) : id(next_id++) {
+    assert(page_bits >= 2 && page_bits <= 32);
+    page_word_bits = page_bits - 2;
+    page_word_mask = (1u << page_word_bits) - 1;
+    zero_page.reset(new ppc_uint<32>[page_word_mask + 1]());
+    reset_caches();
+}
+
+paged_memory::paged_memory(const paged_memory &other)
+        : page_word_bits(other.page_word_bits), page_word_mask(other.page_word_mask), pages(other.pages),
+          zero_page(other.zero_page), id(next_id++) {
+    // Neither memory may write the shared pages in place anymore. Only the pages are marked, so the original
+    // and its page cache stay untouched.
+    for(auto &entry : pages) {
+        entry.second->owner.store(0, std::memory_order_relaxed);
+    }
+    reset_caches();
+}
+
+paged_memory &paged_memory::operator=(const paged_memory &other) {
+    if(this != &other) {
+        page_word_bits = other.page_word_bits;
+        page_word_mask = other.page_word_mask;
+        pages = other.pages;
+        zero_page = other.zero_page;
+        for(auto &entry : pages) {
+            entry.second->owner.store(0, std::memory_order_relaxed);
+        }
+        reset_caches();
+    }
+    return *this;
+}
+
+size_t paged_memory::page_count() const {
+    return pages.size();
+}
+
+uint32_t paged_memory::page_size() const {
+    return 4u << page_word_bits;
+}
+
+void paged_memory::clear() {
+    pages.clear();
+    reset_caches();
+}
+
+const ppc_uint<32> *paged_memory::find_page(uint32_t page_number) const {
+    auto entry = pages.find(page_number);
+    if(entry == pages.end()) {
+        return zero_page.get();
+    }
+    return entry->second->words.get();
+}
+
+std::shared_ptr<paged_memory::page_t> paged_memory::new_page() const {
+    std::shared_ptr<page_t> page(new page_t);
+    page->owner.store(id, std::memory_order_relaxed);
+    page->words.reset(new ppc_uint<32>[page_word_mask + 1]());
+    return page;
+}
+
+paged_memory::page_t *paged_memory::private_page(uint32_t page_number) {
+    std::shared_ptr<page_t> &page = pages[page_number];
+    if(page == nullptr) {
+        page = new_page();
+    } else if(page->owner.load(std::memory_order_relaxed) != id) {
+        // Copy-on-write, the shared page stays with the other memories
+        std::shared_ptr<page_t> copy = new_page();
+        std::copy(page->words.get(), page->words.get() + page_word_mask + 1, copy->words.get());
+        page = copy;
+    }
+
+    // The read cache may still point to the shared or zero page
+    if(read_page_number == page_number) {
+        read_page = page->words.get();
+    }
+    return page.get();
+}
+
+void paged_memory::reset_caches() {
+    read_page_number = 0;
+    read_page = nullptr;
+    write_page_number = 0;
+    write_page = nullptr;
+}
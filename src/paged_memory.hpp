@@ -0,0 +1,152 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_PAGED_MEMORY_HPP
+#define POWERPC_HLS_PAGED_MEMORY_HPP
+
+#include "ppc_int.hpp"
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+// Default page size in bytes as a power of two (4 KiB), 16 gives 64 KiB pages
+#define PAGED_MEMORY_PAGE_BITS 12
+// Word indices of the 32-bit address space
+#define PAGED_MEMORY_INDEX_MASK 0x3FFFFFFF
+
+// Software simulation only!
+// Sparse memory over the whole 32-bit address space. Pages are allocated on their first write, unwritten pages
+// read zero. Copies of a paged_memory share their pages until one of them writes to a page (copy-on-write),
+// which makes snapshots and forks cheap. Copying doesn't change the original, so several threads may copy the same
+// memory at once, as long as nobody writes it meanwhile.
+// It is indexed by words like the flat memory arrays, so the load and store templates of fixed_point accept it
+// as paged_memory &. pipeline::execute, execute_single_instruction and run() execute programs on it, the block
+// cache and the JIT need a flat data memory. The last page used for reading and for writing are cached, so accesses
+// within them skip the page table. Indices wrap around at the end of the address space, so the second word of an
+// unaligned access at the last word (upper_address + 1) is word 0.
+class paged_memory {
+public:
+    // Access to a single word, which separates reads from writes
+    class reference {
+    public:
+        reference(paged_memory *memory, uint32_t index) : memory(memory), index(index) {
+        }
+
+        operator ppc_uint<32>() const {
+            return memory->read(index);
+        }
+
+        operator uint32_t() const {
+            return memory->read(index);
+        }
+
+        template<typename V>
+        reference &operator=(const V &value) {
+            memory->write(index) = value;
+            return *this;
+        }
+
+        reference &operator=(const reference &other) {
+            memory->write(index) = other.memory->read(other.index);
+            return *this;
+        }
+
+        // Range selection is only used to write parts of a word
+        auto operator()(int high, int low) -> decltype(std::declval<ppc_uint<32> &>()(high, low)) {
+            return memory->write(index)(high, low);
+        }
+
+    private:
+        paged_memory *memory;
+        uint32_t index;
+    };
+
+    explicit paged_memory(uint32_t page_bits = PAGED_MEMORY_PAGE_BITS);
+    // Copies share all pages with the original
+    paged_memory(const paged_memory &other);
+    paged_memory &operator=(const paged_memory &other);
+
+    reference operator[](uint32_t index) {
+        return reference(this, index);
+    }
+
+    ppc_uint<32> read(uint32_t index) {
+        index &= PAGED_MEMORY_INDEX_MASK;
+        uint32_t page_number = index >> page_word_bits;
+        if(read_page == nullptr || page_number != read_page_number) {
+            read_page = find_page(page_number);
+            read_page_number = page_number;
+        }
+        return read_page[index & page_word_mask];
+    }
+
+    // Without the page cache, so threads can read a shared memory at once
+    ppc_uint<32> read(uint32_t index) const {
+        index &= PAGED_MEMORY_INDEX_MASK;
+        return find_page(index >> page_word_bits)[index & page_word_mask];
+    }
+
+    ppc_uint<32> &write(uint32_t index) {
+        index &= PAGED_MEMORY_INDEX_MASK;
+        uint32_t page_number = index >> page_word_bits;
+        // A copy may have started to share the cached page since the last write
+        if(write_page == nullptr || page_number != write_page_number ||
+           write_page->owner.load(std::memory_order_relaxed) != id) {
+            write_page = private_page(page_number);
+            write_page_number = page_number;
+        }
+        return write_page->words[index & page_word_mask];
+    }
+
+    // Number of pages, which have been written
+    size_t page_count() const;
+    uint32_t page_size() const;
+    // Frees all pages, the memory reads zero afterwards
+    void clear();
+
+private:
+    typedef struct {
+        // Memory, which writes the page in place, 0 as soon as copies share the page
+        std::atomic<uint64_t> owner;
+        std::unique_ptr<ppc_uint<32>[]> words;
+    } page_t;
+
+    const ppc_uint<32> *find_page(uint32_t page_number) const;
+    page_t *private_page(uint32_t page_number);
+    std::shared_ptr<page_t> new_page() const;
+    void reset_caches();
+
+    uint32_t page_word_bits;
+    uint32_t page_word_mask;
+    std::unordered_map<uint32_t, std::shared_ptr<page_t>> pages;
+    // Read by all pages, which have never been written
+    std::shared_ptr<const ppc_uint<32>[]> zero_page;
+    // Unique for every memory and every copy
+    uint64_t id;
+
+    uint32_t read_page_number;
+    const ppc_uint<32> *read_page;
+    uint32_t write_page_number;
+    page_t *write_page;
+};
+
+#endif //POWERPC_HLS_PAGED_MEMORY_HPP
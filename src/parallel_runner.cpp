@@ -0,0 +1,104 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "parallel_runner.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "block_cache.hpp"
+#include "decode_cache.hpp"
+#include "mmio.hpp"
+
+namespace {
+    ppc_uint<32> *memory_of(simulation_instance_t &instance) {
+        return instance.data_memory.data();
+    }
+
+    paged_memory &memory_of(paged_instance_t &instance) {
+        return instance.data_memory;
+    }
+
+    template<typename I>
+    runner_summary_t run_instances(ppc_uint<32> *instruction_memory, uint32_t instruction_memory_size,
+                                   std::vector<I> &instances, const run_options_t &options, uint32_t threads,
+                                   const std::function<void(I &)> &prepare) {
+        if(threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::max<uint64_t>(1, std::min<uint64_t>(threads, instances.size()));
+
+        std::atomic<size_t> next_instance(0);
+        std::atomic<uint64_t> retired(0);
+        auto worker = [&]() {
+            block_cache blocks(instruction_memory_size);
+            decode_cache decoded;
+            run_options_t thread_options = options;
+            thread_options.blocks = &blocks;
+            thread_options.decoded = &decoded;
+
+            uint64_t thread_retired = 0;
+            for(size_t i = next_instance++; i < instances.size(); i = next_instance++) {
+                I &instance = instances[i];
+                // Devices of the previous instance on this thread must not be reached by this one
+                mmio::unmap_all();
+                if(prepare) {
+                    prepare(instance);
+                }
+                instance.result = run(instance.registers, instruction_memory, memory_of(instance), thread_options);
+                thread_retired += instance.result.retired;
+            }
+            mmio::unmap_all();
+            retired += thread_retired;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for(uint32_t i = 1; i < threads; i++) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for(std::thread &thread : pool) {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        runner_summary_t summary;
+        summary.instances = instances.size();
+        summary.threads = threads;
+        summary.retired = retired;
+        summary.seconds = elapsed.count();
+        summary.mips = summary.seconds > 0 ? summary.retired / summary.seconds / 1e6 : 0;
+        return summary;
+    }
+}
+
+runner_summary_t run_parallel(ppc_uint<32> *instruction_memory, uint32_t instruction_memory_size,
+                              std::vector<simulation_instance_t> &instances, const run_options_t &options,
+                              uint32_t threads, const std::function<void(simulation_instance_t &)> &prepare) {
+    return run_instances(instruction_memory, instruction_memory_size, instances, options, threads, prepare);
+}
+
+runner_summary_t run_parallel(ppc_uint<32> *instruction_memory, uint32_t instruction_memory_size,
+                              std::vector<paged_instance_t> &instances, const run_options_t &options,
+                              uint32_t threads, const std::function<void(paged_instance_t &)> &prepare) {
+    return run_instances(instruction_memory, instruction_memory_size, instances, options, threads, prepare);
+}
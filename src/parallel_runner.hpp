@@ -0,0 +1,70 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_PARALLEL_RUNNER_HPP
+#define POWERPC_HLS_PARALLEL_RUNNER_HPP
+
+#include "ppc_int.hpp"
+#include <functional>
+#include <vector>
+#include "registers.hpp"
+#include "paged_memory.hpp"
+#include "test_bench_utils.hpp"
+
+// One independent simulated core
+typedef struct {
+    registers_t registers; // Initial state, holds the final state after the run
+    std::vector<ppc_uint<32>> data_memory;
+    run_result_t result;
+} simulation_instance_t;
+
+// Same on the sparse memory, e.g. forked from a snapshot (see snapshot.hpp)
+typedef struct {
+    registers_t registers;
+    paged_memory data_memory;
+    run_result_t result;
+} paged_instance_t;
+
+typedef struct {
+    uint64_t instances;
+    uint32_t threads;
+    uint64_t retired; // Instructions retired by all instances
+    double seconds; // Wall clock time
+    double mips; // Aggregate million instructions per second
+} runner_summary_t;
+
+// Software simulation only!
+// Runs all instances on a pool of host threads (0 uses one per hardware thread) with the given options.
+// The instruction memory is shared and must not be written. Every thread has its own block and decode cache,
+// which serve all instances it runs. prepare is called on the executing thread before an instance starts,
+// e.g. to map its devices (see mmio). Every instance starts without mapped regions and the regions are removed after
+// the last instance of a thread, this includes the regions of the calling thread, which runs instances as well.
+runner_summary_t run_parallel(ppc_uint<32> *instruction_memory, uint32_t instruction_memory_size,
+                              std::vector<simulation_instance_t> &instances, const run_options_t &options,
+                              uint32_t threads = 0,
+                              const std::function<void(simulation_instance_t &)> &prepare = nullptr);
+// Instances on the paged memory run without the block cache, see run()
+runner_summary_t run_parallel(ppc_uint<32> *instruction_memory, uint32_t instruction_memory_size,
+                              std::vector<paged_instance_t> &instances, const run_options_t &options,
+                              uint32_t threads = 0,
+                              const std::function<void(paged_instance_t &)> &prepare = nullptr);
+
+#endif //POWERPC_HLS_PARALLEL_RUNNER_HPP
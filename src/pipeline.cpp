@@ -26,93 +26,125 @@
 #include "pipeline.hpp"
 #include "fixed_point_processor.hpp"
 #include "branch_processor.hpp"
+#include "micro_op.hpp"
+#ifndef __SYNTHESIS__
+#include "paged_memory.hpp"
+#endif
 
-ap_uint<32> pipeline::instruction_fetch(ap_uint<32> *instruction_memory, registers_t &registers) {
+ppc_uint<32> pipeline::swap_endianness(ppc_uint<32> word) {
 #pragma HLS inline
-    ap_uint<32> instruction = instruction_memory[registers.program_counter(31, 2)];
-    ap_uint<32> big_endian;
-    // Conversion for big endian access
-    big_endian(31, 24) = instruction(7, 0);
-    big_endian(23, 16) = instruction(15, 8);
-    big_endian(15, 8) = instruction(23, 16);
-    big_endian(7, 0) = instruction(31, 24);
-    return big_endian;
+    ppc_uint<32> swapped;
+    swapped(31, 24) = word(7, 0);
+    swapped(23, 16) = word(15, 8);
+    swapped(15, 8) = word(23, 16);
+    swapped(7, 0) = word(31, 24);
+    return swapped;
 }
 
-// For testing only
-ap_uint<32> pipeline::fetch_index(ap_uint<32> *instruction_memory, uint32_t index) {
-    ap_uint<32> instruction = instruction_memory[index];
-    ap_uint<32> big_endian;
+ppc_uint<32> pipeline::instruction_fetch(ppc_uint<32> *instruction_memory, registers_t &registers) {
+#pragma HLS inline
+    return fetch_index(instruction_memory, registers.program_counter(31, 2));
+}
+
+ppc_uint<32> pipeline::fetch_index(ppc_uint<32> *instruction_memory, uint32_t index) {
+#pragma HLS inline
+#ifdef HOST_ORDER_INSTRUCTIONS
+    return instruction_memory[index];
+#else
     // Conversion for big endian access
-    big_endian(31, 24) = instruction(7, 0);
-    big_endian(23, 16) = instruction(15, 8);
-    big_endian(15, 8) = instruction(23, 16);
-    big_endian(7, 0) = instruction(31, 24);
-    return big_endian;
+    return swap_endianness(instruction_memory[index]);
+#endif
 }
 
-bool pipeline::execute(decode_result_t decoded, registers_t &registers, ap_uint<32> *data_memory) {
-	bool trap_happened = false;
-	if(decoded.fixed_point_decode_result.execute != fixed_point::NONE) {
-        switch (decoded.fixed_point_decode_result.execute) {
-            case fixed_point::LOAD:
-                fixed_point::load<ap_uint<32> *>(decoded.fixed_point_decode_result.load_store_decoded, registers,
-                                                 data_memory);
-                break;
-            case fixed_point::STORE:
-                fixed_point::store<ap_uint<32> *>(decoded.fixed_point_decode_result.load_store_decoded, registers,
-                                                  data_memory);
+namespace {
+    // Executes all units except for the branch processor, T is the type of the data memory like in fixed_point
+    template<typename T>
+    bool execute_units(const micro_op_t &decoded, registers_t &registers, T data_memory) {
+#pragma HLS inline
+        bool trap_happened = false;
+        switch (decoded.opcode) {
+            case micro_op::LOAD:
+                fixed_point::load<T>(micro_op::unpack_load_store(decoded), registers, data_memory);
                 break;
-            case fixed_point::LOAD_STRING:
-                fixed_point::load_string<ap_uint<32> *>(decoded.fixed_point_decode_result.load_store_decoded, registers,
-                                                        data_memory);
+            case micro_op::STORE:
+                fixed_point::store<T>(micro_op::unpack_load_store(decoded), registers, data_memory);
                 break;
-            case fixed_point::STORE_STRING:
-                fixed_point::store_string<ap_uint<32> *>(decoded.fixed_point_decode_result.load_store_decoded,registers,
-                                                         data_memory);
+            case micro_op::LOAD_STRING:
+                fixed_point::load_string<T>(micro_op::unpack_load_store(decoded), registers, data_memory);
                 break;
-            case fixed_point::ADD_SUB:
-                fixed_point::add_sub(decoded.fixed_point_decode_result.add_sub_decoded, registers);
+            case micro_op::STORE_STRING:
+                fixed_point::store_string<T>(micro_op::unpack_load_store(decoded), registers, data_memory);
                 break;
-            case fixed_point::MUL:
-                fixed_point::multiply(decoded.fixed_point_decode_result.mul_decoded, registers);
+            case micro_op::ADD_SUB:
+                fixed_point::add_sub(micro_op::unpack_add_sub(decoded), registers);
                 break;
-            case fixed_point::DIV:
-                fixed_point::divide(decoded.fixed_point_decode_result.div_decoded, registers);
+            case micro_op::MUL:
+                fixed_point::multiply(micro_op::unpack_mul(decoded), registers);
                 break;
-            case fixed_point::COMPARE:
-                fixed_point::compare(decoded.fixed_point_decode_result.cmp_decoded, registers);
+            case micro_op::DIV:
+                fixed_point::divide(micro_op::unpack_div(decoded), registers);
                 break;
-            case fixed_point::TRAP:
-                trap_happened = fixed_point::trap(decoded.fixed_point_decode_result.trap_decoded, registers);
+            case micro_op::COMPARE:
+                fixed_point::compare(micro_op::unpack_cmp(decoded), registers);
                 break;
-            case fixed_point::LOGICAL:
-                fixed_point::logical(decoded.fixed_point_decode_result.log_decoded, registers);
+            case micro_op::TRAP:
+                trap_happened = fixed_point::trap(micro_op::unpack_trap(decoded), registers);
                 break;
-            case fixed_point::ROTATE:
-                fixed_point::rotate(decoded.fixed_point_decode_result.rotate_decoded, registers);
+            case micro_op::LOGICAL:
+                fixed_point::logical(micro_op::unpack_log(decoded), registers);
                 break;
-            case fixed_point::SYSTEM:
-                fixed_point::system(decoded.fixed_point_decode_result.system_decoded, registers);
+            case micro_op::ROTATE:
+                fixed_point::rotate(micro_op::unpack_rotate(decoded), registers);
                 break;
-            case fixed_point::NONE:
+            case micro_op::SYSTEM:
+                fixed_point::system(micro_op::unpack_system(decoded), registers);
                 break;
-        }
-    } else if(decoded.branch_decode_result.execute != branch::NONE) {
-	    switch(decoded.branch_decode_result.execute) {
-            case branch::BRANCH:
+            case micro_op::BRANCH:
                 // Branch will be executed beforehand for performance reasons
                 break;
-            case branch::SYSTEM_CALL:
-                branch::system_call(decoded.branch_decode_result.system_call_decoded, registers);
+            case micro_op::SYSTEM_CALL:
+                branch::system_call(micro_op::unpack_system_call(decoded), registers);
+                break;
+            case micro_op::CONDITION:
+                branch::condition(micro_op::unpack_condition(decoded), registers);
                 break;
-            case branch::CONDITION:
-                branch::condition(decoded.branch_decode_result.condition_decoded, registers);
+            case micro_op::FUSED_LOAD_IMMEDIATE:
+                registers.GPR[decoded.reg_c] = decoded.immediate;
                 break;
-            case branch::NONE:
+            case micro_op::FUSED_ADDRESS_LOAD:
+                fixed_point::add_sub(micro_op::unpack_fused_addis(decoded), registers);
+                fixed_point::load<T>(micro_op::unpack_fused_load(decoded), registers, data_memory);
+                break;
+            case micro_op::FUSED_ROTATE_COMPARE:
+                fixed_point::rotate(micro_op::unpack_fused_rotate(decoded), registers);
+                fixed_point::compare(micro_op::unpack_fused_rotate_compare(decoded), registers);
+                break;
+            case micro_op::FUSED_COMPARE_BRANCH:
+                // Branches will be executed beforehand for performance reasons
+                break;
+            case micro_op::NONE:
                 break;
         }
-	}
 
-    return trap_happened;
+        return trap_happened;
+    }
+}
+
+bool pipeline::execute(const micro_op_t &decoded, registers_t &registers, ppc_uint<32> *data_memory) {
+    return execute_units<ppc_uint<32> *>(decoded, registers, data_memory);
+}
+
+#ifndef __SYNTHESIS__
+bool pipeline::execute(const micro_op_t &decoded, registers_t &registers, paged_memory &data_memory) {
+    return execute_units<paged_memory &>(decoded, registers, data_memory);
+}
+#endif
+
+void pipeline::execute_branch(const micro_op_t &decoded, registers_t &registers) {
+    if(decoded.opcode == micro_op::FUSED_COMPARE_BRANCH) {
+        fixed_point::compare(micro_op::unpack_fused_branch_compare(decoded), registers);
+        branch::branch(micro_op::unpack_fused_branch(decoded), registers);
+    } else {
+        branch::branch(micro_op::unpack_branch(decoded), registers);
+    }
 }
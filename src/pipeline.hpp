@@ -26,13 +26,32 @@
 #ifndef POWERPC_HLS_PIPELINE_HPP
 #define POWERPC_HLS_PIPELINE_HPP
 
-#include <ap_int.h>
+#include "ppc_int.hpp"
 #include "instruction_decode.hpp"
 
+#ifndef __SYNTHESIS__
+class paged_memory;
+#endif
+
+// With HOST_ORDER_INSTRUCTIONS, the instruction memory holds the instructions in host byte order instead of big endian.
+// The loaders of the software simulation convert them once (see prepare_instructions), so fetching needs no swap.
+#ifdef __SYNTHESIS__
+#undef HOST_ORDER_INSTRUCTIONS
+#endif
+
 namespace pipeline {
-    ap_uint<32> instruction_fetch(ap_uint<32> *instruction_memory, registers_t &registers);
-    // For testing only
-    ap_uint<32> fetch_index(ap_uint<32> *instruction_memory, uint32_t index);
-    bool execute(decode_result_t decoded, registers_t &registers, ap_uint<32> *data_memory);
+    // Reverses the byte order of a word
+    ppc_uint<32> swap_endianness(ppc_uint<32> word);
+    ppc_uint<32> instruction_fetch(ppc_uint<32> *instruction_memory, registers_t &registers);
+    // Fetches the instruction at the given word index
+    ppc_uint<32> fetch_index(ppc_uint<32> *instruction_memory, uint32_t index);
+    bool execute(const micro_op_t &decoded, registers_t &registers, ppc_uint<32> *data_memory);
+#ifndef __SYNTHESIS__
+    // Same on the sparse memory of the software simulation
+    bool execute(const micro_op_t &decoded, registers_t &registers, paged_memory &data_memory);
+#endif
+    // Executes branches and fused compare and branch operations (see micro_op::is_branch).
+    // The program counter has to hold the address of the branch instruction.
+    void execute_branch(const micro_op_t &decoded, registers_t &registers);
 }
 #endif //POWERPC_HLS_PIPELINE_HPP
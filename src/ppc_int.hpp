@@ -0,0 +1,40 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_PPC_INT_HPP
+#define POWERPC_HLS_PPC_INT_HPP
+
+// Integer types of the datapath.
+// Synthesis always uses the arbitrary precision types, the software simulation can use native words instead
+// by defining NATIVE_INTEGER_TYPES, which avoids the overhead of ap_int construction and range selection.
+#if defined(NATIVE_INTEGER_TYPES) && !defined(__SYNTHESIS__)
+#include "native_int.hpp"
+
+template<int W> using ppc_uint = native_uint<W>;
+template<int W> using ppc_int = native_int<W>;
+#else
+#include <ap_int.h>
+
+template<int W> using ppc_uint = ap_uint<W>;
+template<int W> using ppc_int = ap_int<W>;
+#endif
+
+#endif //POWERPC_HLS_PPC_INT_HPP
@@ -28,12 +28,12 @@
 #define __PPC_TYPES__
 
 #include <stdint.h>
-#include <ap_int.h>
+#include "ppc_int.hpp"
 #include "registers.hpp"
 
 typedef struct {
-	ap_uint<32> instruction_bits;
-	void operator=(ap_uint<32> val) {
+	ppc_uint<32> instruction_bits;
+	void operator=(ppc_uint<32> val) {
 	    instruction_bits = val;
 	    I_Form = val;
 	    B_Form = val;
@@ -53,11 +53,11 @@ typedef struct {
 	}
 
 	struct {
-		ap_uint<1> LK;
-		ap_uint<1> AA;
-		ap_uint<24> LI;
-		ap_uint<6> OPCD;
-		void operator=(ap_uint<32> &val) {
+		ppc_uint<1> LK;
+		ppc_uint<1> AA;
+		ppc_uint<24> LI;
+		ppc_uint<6> OPCD;
+		void operator=(ppc_uint<32> &val) {
 		    LK = val[0];
 		    AA = val[1];
 		    LI = val(25, 2);
@@ -66,13 +66,13 @@ typedef struct {
 	} I_Form;
 
 	struct {
-		ap_uint<1> LK;
-        ap_uint<1> AA;
-        ap_uint<14> BD;
-        ap_uint<5> BI;
-        ap_uint<5> BO;
-        ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> LK;
+        ppc_uint<1> AA;
+        ppc_uint<14> BD;
+        ppc_uint<5> BI;
+        ppc_uint<5> BO;
+        ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             LK = val[0];
             AA = val[1];
             BD = val(15, 2);
@@ -83,15 +83,15 @@ typedef struct {
 	} B_Form;
 
 	struct {
-		ap_uint<1> UNUSED_5;
-		ap_uint<1> ALWAYS_ONE;
-		ap_uint<3> UNUSED_4;
-		ap_uint<7> LEV;
-		ap_uint<4> UNUSED_3;
-		ap_uint<5> UNUSED_2;
-		ap_uint<5> UNUSED_1;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> UNUSED_5;
+		ppc_uint<1> ALWAYS_ONE;
+		ppc_uint<3> UNUSED_4;
+		ppc_uint<7> LEV;
+		ppc_uint<4> UNUSED_3;
+		ppc_uint<5> UNUSED_2;
+		ppc_uint<5> UNUSED_1;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             UNUSED_5 = val[0];
             ALWAYS_ONE = val[1];
             UNUSED_4 = val(4, 2);
@@ -104,11 +104,11 @@ typedef struct {
 	} SC_Form;
 
 	struct {
-		ap_uint<16> D;
-		ap_uint<5> RA;
-		ap_uint<5> RT;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<16> D;
+		ppc_uint<5> RA;
+		ppc_uint<5> RT;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             D = val(15, 0);
             RA = val(20, 16);
             RT = val(25, 21);
@@ -117,12 +117,12 @@ typedef struct {
 	} D_Form;
 
 	struct {
-		ap_uint<2> XO;
-		ap_uint<14> DS;
-		ap_uint<5> RA;
-		ap_uint<5> RT;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<2> XO;
+		ppc_uint<14> DS;
+		ppc_uint<5> RA;
+		ppc_uint<5> RT;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             XO = val(1, 0);
             DS = val(15, 2);
             RA = val(20, 16);
@@ -132,13 +132,13 @@ typedef struct {
 	} DS_Form;
 
 	struct {
-		ap_uint<1> Rc;
-		ap_uint<10> XO;
-		ap_uint<5> RB;
-		ap_uint<5> RA;
-		ap_uint<5> RT;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> Rc;
+		ppc_uint<10> XO;
+		ppc_uint<5> RB;
+		ppc_uint<5> RA;
+		ppc_uint<5> RT;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             Rc = val[0];
             XO = val(10, 1);
             RB = val(15, 11);
@@ -149,13 +149,13 @@ typedef struct {
 	} X_Form;
 
 	struct {
-		ap_uint<1> LK;
-		ap_uint<10> XO;
-		ap_uint<5> BB;
-		ap_uint<5> BA;
-		ap_uint<5> BT;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> LK;
+		ppc_uint<10> XO;
+		ppc_uint<5> BB;
+		ppc_uint<5> BA;
+		ppc_uint<5> BT;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             LK = val[0];
             XO = val(10, 1);
             BB = val(15, 11);
@@ -166,12 +166,12 @@ typedef struct {
 	} XL_Form;
 
 	struct {
-		ap_uint<1> UNUSED_1;
-		ap_uint<10> XO;
-		ap_uint<10> spr;
-		ap_uint<5> RT;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> UNUSED_1;
+		ppc_uint<10> XO;
+		ppc_uint<10> spr;
+		ppc_uint<5> RT;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             UNUSED_1 = val[0];
             XO = val(10, 1);
             spr = val(20, 11);
@@ -181,14 +181,14 @@ typedef struct {
 	} XFX_Form;
 
 	struct {
-		ap_uint<1> Rc;
-		ap_uint<10> XO;
-		ap_uint<5> FRB;
-		ap_uint<1> UNUSED_2;
-		ap_uint<8> FLM;
-		ap_uint<1> UNUSED_1;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> Rc;
+		ppc_uint<10> XO;
+		ppc_uint<5> FRB;
+		ppc_uint<1> UNUSED_2;
+		ppc_uint<8> FLM;
+		ppc_uint<1> UNUSED_1;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             Rc = val[0];
             XO = val(10, 1);
             FRB = val(15, 11);
@@ -200,14 +200,14 @@ typedef struct {
 	} XFL_Form;
 
 	struct {
-		ap_uint<1> Rc;
-		ap_uint<1> SH_2;
-		ap_uint<9> XO;
-		ap_uint<5> SH_1;
-		ap_uint<5> RA;
-		ap_uint<5> RS;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> Rc;
+		ppc_uint<1> SH_2;
+		ppc_uint<9> XO;
+		ppc_uint<5> SH_1;
+		ppc_uint<5> RA;
+		ppc_uint<5> RS;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             Rc = val[0];
             SH_2 = val[1];
             XO = val(10, 2);
@@ -219,14 +219,14 @@ typedef struct {
 	} XS_Form;
 
 	struct {
-		ap_uint<1> Rc;
-		ap_uint<9> XO;
-		ap_uint<1> OE;
-		ap_uint<5> RB;
-		ap_uint<5> RA;
-		ap_uint<5> RT;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> Rc;
+		ppc_uint<9> XO;
+		ppc_uint<1> OE;
+		ppc_uint<5> RB;
+		ppc_uint<5> RA;
+		ppc_uint<5> RT;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             Rc = val[0];
             XO = val(9, 1);
             OE = val[10];
@@ -238,14 +238,14 @@ typedef struct {
 	} XO_Form;
 
 	struct {
-		ap_uint<1> Rc;
-		ap_uint<5> XO;
-		ap_uint<5> FRC;
-		ap_uint<5> FRB;
-		ap_uint<5> FRA;
-		ap_uint<5> FRT;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> Rc;
+		ppc_uint<5> XO;
+		ppc_uint<5> FRC;
+		ppc_uint<5> FRB;
+		ppc_uint<5> FRA;
+		ppc_uint<5> FRT;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             Rc = val[0];
             XO = val(5, 1);
             FRC = val(10, 6);
@@ -257,14 +257,14 @@ typedef struct {
 	} A_Form;
 
 	struct {
-		ap_uint<1> Rc;
-		ap_uint<5> ME;
-		ap_uint<5> MB;
-        ap_uint<5> RB;
-        ap_uint<5> RA;
-        ap_uint<5> RS;
-        ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> Rc;
+		ppc_uint<5> ME;
+		ppc_uint<5> MB;
+        ppc_uint<5> RB;
+        ppc_uint<5> RA;
+        ppc_uint<5> RS;
+        ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             Rc = val[0];
             ME = val(5, 1);
             MB = val(10, 6);
@@ -276,15 +276,15 @@ typedef struct {
 	} M_Form;
 
 	struct {
-		ap_uint<1> Rc;
-		ap_uint<1> SH_2;
-		ap_uint<3> XO;
-		ap_uint<6> MB;
-        ap_uint<5> SH_1;
-        ap_uint<5> RA;
-        ap_uint<5> RS;
-        ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> Rc;
+		ppc_uint<1> SH_2;
+		ppc_uint<3> XO;
+		ppc_uint<6> MB;
+        ppc_uint<5> SH_1;
+        ppc_uint<5> RA;
+        ppc_uint<5> RS;
+        ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             Rc = val[0];
             SH_2 = val[1];
             XO = val(4, 2);
@@ -297,14 +297,14 @@ typedef struct {
 	} MD_Form;
 
 	struct {
-		ap_uint<1> Rc;
-		ap_uint<4> XO;
-		ap_uint<6> MB;
-		ap_uint<5> RB;
-		ap_uint<5> RA;
-		ap_uint<5> RS;
-		ap_uint<6> OPCD;
-        void operator=(ap_uint<32> &val) {
+		ppc_uint<1> Rc;
+		ppc_uint<4> XO;
+		ppc_uint<6> MB;
+		ppc_uint<5> RB;
+		ppc_uint<5> RA;
+		ppc_uint<5> RS;
+		ppc_uint<6> OPCD;
+        void operator=(ppc_uint<32> &val) {
             Rc = val[0];
             XO = val(4, 1);
             MB = val(10, 5);
@@ -321,13 +321,13 @@ typedef enum {BRANCH, BRANCH_CONDITIONAL, BRANCH_CONDITIONAL_LINK, BRANCH_CONDIT
 
 typedef struct {
 	branch_op_t operation;
-	ap_uint<1> LK;
-	ap_uint<1> AA;
-	ap_uint<24> LI;
-	ap_uint<14> BD;
-	ap_uint<5> BI;
-	ap_uint<5> BO;
-	ap_uint<2> BH;
+	ppc_uint<1> LK;
+	ppc_uint<1> AA;
+	ppc_uint<24> LI;
+	ppc_uint<14> BD;
+	ppc_uint<5> BI;
+	ppc_uint<5> BO;
+	ppc_uint<2> BH;
 } branch_decode_t;
 
 typedef uint8_t system_call_decode_t;
@@ -338,9 +338,9 @@ namespace condition {
 
 typedef struct {
 	condition::condition_op_t operation;
-	ap_uint<5> CR_op1_reg_address;
-	ap_uint<5> CR_op2_reg_address;
-	ap_uint<5> CR_result_reg_address;
+	ppc_uint<5> CR_op1_reg_address;
+	ppc_uint<5> CR_op2_reg_address;
+	ppc_uint<5> CR_result_reg_address;
 } condition_decode_t;
 
 namespace branch {
@@ -358,16 +358,16 @@ typedef struct {
 
 // Types for fixed point processor
 typedef struct {
-	ap_uint<2> word_size; // in bytes-1
+	ppc_uint<2> word_size; // in bytes-1
 	bool sum1_imm; // Use immediate for first summand
-	ap_int<16> sum1_immediate;
-	ap_uint<5> sum1_reg_address;
+	ppc_int<16> sum1_immediate;
+	ppc_uint<5> sum1_reg_address;
 	bool sum2_imm; // Use immediate for second summand
-	ap_int<16> sum2_immediate;
-	ap_uint<5> sum2_reg_address;
+	ppc_int<16> sum2_immediate;
+	ppc_uint<5> sum2_reg_address;
 	bool write_ea; // write effective address
-	ap_uint<5> ea_reg_address;
-	ap_uint<5> result_reg_address;
+	ppc_uint<5> ea_reg_address;
+	ppc_uint<5> result_reg_address;
 	bool sign_extend;
 	bool little_endian;
 	bool multiple;
@@ -376,12 +376,12 @@ typedef struct {
 typedef struct {
 	bool subtract;
 	bool op1_imm; // Use immediate for first operand
-	ap_int<32> op1_immediate;
-	ap_uint<5> op1_reg_address;
+	ppc_int<32> op1_immediate;
+	ppc_uint<5> op1_reg_address;
 	bool op2_imm; // Use immediate for first operand
-	ap_int<32> op2_immediate;
-	ap_uint<5> op2_reg_address;
-	ap_uint<5> result_reg_address;
+	ppc_int<32> op2_immediate;
+	ppc_uint<5> op2_reg_address;
+	ppc_uint<5> result_reg_address;
 	bool alter_CA;
 	bool alter_CR0;
 	bool alter_OV;
@@ -389,11 +389,11 @@ typedef struct {
 } add_sub_decode_t;
 
 typedef struct {
-	ap_uint<5> op1_reg_address;
+	ppc_uint<5> op1_reg_address;
 	bool op2_imm; // Use immediate for first operand
-	ap_int<32> op2_immediate;
-	ap_uint<5> op2_reg_address;
-	ap_uint<5> result_reg_address;
+	ppc_int<32> op2_immediate;
+	ppc_uint<5> op2_reg_address;
+	ppc_uint<5> result_reg_address;
 	bool mul_signed;
 	bool mul_higher;
 	bool alter_CR0;
@@ -401,29 +401,29 @@ typedef struct {
 } mul_decode_t;
 
 typedef struct {
-    ap_uint<5> dividend_reg_address;
-    ap_uint<5> divisor_reg_address;
-    ap_uint<5> result_reg_address;
+    ppc_uint<5> dividend_reg_address;
+    ppc_uint<5> divisor_reg_address;
+    ppc_uint<5> result_reg_address;
 	bool div_signed;
 	bool alter_CR0;
 	bool alter_OV;
 } div_decode_t;
 
 typedef struct {
-    ap_uint<5> op1_reg_address;
+    ppc_uint<5> op1_reg_address;
 	bool op2_imm; // Use immediate for second operand
-	ap_int<32> op2_immediate;
-    ap_uint<5> op2_reg_address;
+	ppc_int<32> op2_immediate;
+    ppc_uint<5> op2_reg_address;
 	bool cmp_signed;
-	ap_uint<3> BF;
+	ppc_uint<3> BF;
 } cmp_decode_t;
 
 typedef struct {
-    ap_uint<5> op1_reg_address;
+    ppc_uint<5> op1_reg_address;
 	bool op2_imm; // Use immediate for second operand
-	ap_int<32> op2_immediate;
-    ap_uint<5> op2_reg_address;
-    ap_uint<5> TO;
+	ppc_int<32> op2_immediate;
+    ppc_uint<5> op2_reg_address;
+    ppc_uint<5> TO;
 } trap_decode_t;
 
 namespace logical {
@@ -438,22 +438,22 @@ namespace logical {
 
 typedef struct {
 	logical::logical_op_t operation;
-    ap_uint<5> op1_reg_address;
+    ppc_uint<5> op1_reg_address;
 	bool op2_imm; // Use immediate for second operand
-	ap_uint<32> op2_immediate;
-    ap_uint<5> op2_reg_address;
-    ap_uint<5> result_reg_address;
+	ppc_uint<32> op2_immediate;
+    ppc_uint<5> op2_reg_address;
+    ppc_uint<5> result_reg_address;
 	bool alter_CR0;
 } log_decode_t;
 
 typedef struct {
 	bool shift_imm;
-    ap_uint<5> shift_immediate;
-    ap_uint<5> shift_reg_address;
-    ap_uint<5> source_reg_address;
-    ap_uint<5> target_reg_address;
-    ap_uint<5> MB;
-    ap_uint<5> ME;
+    ppc_uint<5> shift_immediate;
+    ppc_uint<5> shift_reg_address;
+    ppc_uint<5> source_reg_address;
+    ppc_uint<5> target_reg_address;
+    ppc_uint<5> MB;
+    ppc_uint<5> ME;
 	bool mask_insert;
 	// Shift specific variables
 	bool shift;
@@ -469,9 +469,9 @@ namespace system_ppc {
 
 typedef struct {
 	system_ppc::system_op_t operation;
-    ap_uint<5> RS_RT; // RS or RT reg address
-    ap_uint<10> SPR; // Special purpose register address
-    ap_uint<8> FXM; // Field mask
+    ppc_uint<5> RS_RT; // RS or RT reg address
+    ppc_uint<10> SPR; // Special purpose register address
+    ppc_uint<8> FXM; // Field mask
 } system_decode_t;
 
 namespace fixed_point {
@@ -495,16 +495,16 @@ typedef struct {
 
 // Types for floating point processor
 typedef struct {
-    ap_uint<3> word_size; // in bytes-1
+    ppc_uint<3> word_size; // in bytes-1
 	bool sum1_imm; // Use immediate for first summand
-    ap_int<16> sum1_immediate;
-    ap_uint<5> sum1_reg_address;
+    ppc_int<16> sum1_immediate;
+    ppc_uint<5> sum1_reg_address;
 	bool sum2_imm; // Use immediate for second summand
-    ap_int<16> sum2_immediate;
-    ap_uint<5> sum2_reg_address;
+    ppc_int<16> sum2_immediate;
+    ppc_uint<5> sum2_reg_address;
 	bool write_ea; // write effective address
-    ap_uint<5> ea_reg_address;
-    ap_uint<5> result_reg_address;
+    ppc_uint<5> ea_reg_address;
+    ppc_uint<5> result_reg_address;
 	bool sign_extend; // Sign extend means, store as integer word for floating point
 	bool little_endian; // Unused for floating point
 	bool multiple; // Unused for floating point
@@ -514,8 +514,8 @@ typedef enum {MOVE, NEGATE, ABSOLUTE, NEGATIVE_ABSOLUTE} float_move_op_t;
 
 typedef struct {
 	float_move_op_t operation;
-    ap_uint<5> source_reg_address;
-    ap_uint<5> target_reg_address;
+    ppc_uint<5> source_reg_address;
+    ppc_uint<5> target_reg_address;
 	bool alter_CR1;
 } float_move_decode_t;
 
@@ -525,18 +525,18 @@ namespace floating_point {
 
 typedef struct {
 	floating_point::float_arithmetic_op_t operation;
-    ap_uint<5> op1_reg_address;
-    ap_uint<5> op2_reg_address;
-    ap_uint<5> result_reg_address;
+    ppc_uint<5> op1_reg_address;
+    ppc_uint<5> op2_reg_address;
+    ppc_uint<5> result_reg_address;
 	bool single_precision;
 	bool alter_CR1;
 } float_arithmetic_decode_t;
 
 typedef struct {
-    ap_uint<5> mul1_reg_address;
-    ap_uint<5> mul2_reg_address;
-    ap_uint<5> add_reg_address;
-    ap_uint<5> result_reg_address;
+    ppc_uint<5> mul1_reg_address;
+    ppc_uint<5> mul2_reg_address;
+    ppc_uint<5> add_reg_address;
+    ppc_uint<5> result_reg_address;
 	bool single_precision;
 	bool negate_add;
 	bool negate_result;
@@ -544,8 +544,8 @@ typedef struct {
 } float_madd_decode_t;
 
 typedef struct {
-    ap_uint<5> source_reg_address;
-    ap_uint<5> target_reg_address;
+    ppc_uint<5> source_reg_address;
+    ppc_uint<5> target_reg_address;
 	bool round_to_single;
 	bool convert_to_integer;
 	bool round_toward_zero;
@@ -553,18 +553,18 @@ typedef struct {
 } float_convert_decode_t;
 
 typedef struct {
-    ap_uint<5> FRA;
-    ap_uint<5> FRB;
-    ap_uint<3> BF;
+    ppc_uint<5> FRA;
+    ppc_uint<5> FRB;
+    ppc_uint<3> BF;
 	bool unordered;
 } float_compare_decode_t;
 
 typedef struct {
-    ap_uint<5> FRT_FRB; // FRT or FRB
-    ap_uint<5> BF_BT; // BF or BT
-    ap_uint<3> BFA;
-    ap_uint<4> U;
-    ap_uint<8> FLM;
+    ppc_uint<5> FRT_FRB; // FRT or FRB
+    ppc_uint<5> BF_BT; // BF or BT
+    ppc_uint<3> BFA;
+    ppc_uint<4> U;
+    ppc_uint<8> FLM;
 	bool move_to_FPR;
 	bool move_to_CR;
 	bool move_to_FPSCR;
@@ -592,10 +592,61 @@ typedef struct {
 	float_status_decode_t float_status_decoded;
 } floating_point_decode_result_t;
 
+// Compact decode result, which is passed from decode to execute.
+// Only one unit is active for any instruction, hence all units share the same operand fields.
+// The meaning of the fields depends on the opcode, see micro_op.hpp for the mapping to the unit structs.
+namespace micro_op {
+    typedef enum {
+        NONE,
+        // Branch processor
+        BRANCH, SYSTEM_CALL, CONDITION,
+        // Fixed point processor
+        LOAD, STORE, LOAD_STRING, STORE_STRING, ADD_SUB, MUL, DIV, COMPARE, TRAP, LOGICAL, ROTATE, SYSTEM,
+        // Fused pairs of instructions, see macro_op_fusion.hpp
+        FUSED_LOAD_IMMEDIATE, FUSED_ADDRESS_LOAD, FUSED_ROTATE_COMPARE, FUSED_COMPARE_BRANCH
+    } opcode_t;
+
+    // Flags for load and store operations
+    const uint16_t SUM1_IMM = 1 << 0;
+    const uint16_t SUM2_IMM = 1 << 1;
+    const uint16_t WRITE_EA = 1 << 2;
+    const uint16_t SIGN_EXTEND = 1 << 3;
+    const uint16_t BYTE_REVERSED = 1 << 4;
+    const uint16_t MULTIPLE = 1 << 5;
+
+    // Flags for arithmetic, logical and rotate operations
+    const uint16_t OP1_IMM = 1 << 0;
+    const uint16_t OP2_IMM = 1 << 1;
+    const uint16_t ALTER_CR0 = 1 << 2;
+    const uint16_t ALTER_OV = 1 << 3;
+    const uint16_t ALTER_CA = 1 << 4;
+    const uint16_t ADD_CA = 1 << 5;
+    const uint16_t SUBTRACT = 1 << 6;
+    const uint16_t SIGNED = 1 << 7;
+    const uint16_t HIGHER = 1 << 8;
+    const uint16_t MASK_INSERT = 1 << 9;
+    const uint16_t SHIFT = 1 << 10;
+    const uint16_t LEFT = 1 << 11;
+    const uint16_t SHIFT_SIGN_EXTEND = 1 << 12;
+
+    // Flags for branch operations
+    const uint16_t LK = 1 << 0;
+    const uint16_t AA = 1 << 1;
+}
+
 typedef struct {
-	branch_decode_result_t branch_decode_result;
-	fixed_point_decode_result_t fixed_point_decode_result;
-	floating_point_decode_result_t floating_point_decode_result;
-} decode_result_t;
+    uint8_t opcode; // micro_op::opcode_t
+    uint8_t operation; // Unit specific operation, e.g. logical::logical_op_t
+    uint16_t flags;
+    uint8_t reg_a; // First source register
+    uint8_t reg_b; // Second source register
+    uint8_t reg_c; // Target register
+    uint8_t reg_d; // Effective address target register
+    uint8_t field_a;
+    uint8_t field_b;
+    uint8_t field_c;
+    uint8_t field_d;
+    uint32_t immediate;
+} micro_op_t;
 
 #endif
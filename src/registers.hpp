@@ -24,77 +24,180 @@
 #define __REGISTERS__
 
 #include <stdint.h>
-#include <ap_int.h>
-
-union condition_field {
-	struct condition_fixed_point {
-		uint8_t SO:1; // Bit 3
-		uint8_t EQ:1; // Bit 2
-		uint8_t GT:1; // Bit 1
-		uint8_t LT:1; // Bit 0
+#include "ppc_int.hpp"
+
+// Lazy flag evaluation is only supported by the software simulation
+#ifdef __SYNTHESIS__
+#undef LAZY_FLAGS
+#endif
+
+// Bits of a single CR field, a field is stored in 4 bits with LT as the most significant bit
+#define CR_LT 0x8
+#define CR_GT 0x4
+#define CR_EQ 0x2
+#define CR_SO 0x1
+
+// CR is in big endian notation: field 0 is stored in bits 31 to 28, BI 0 is bit 31
+constexpr uint32_t condition_field_shift(uint32_t field) {
+    return 28 - 4*field;
+}
+
+constexpr uint32_t condition_bit_shift(uint32_t BI) {
+    return 31 - BI;
+}
+
+// View of a single bit inside of the packed condition register
+class condition_bit {
+public:
+    condition_bit(uint32_t &word, uint32_t shift) : word(word), shift(shift) {
+    }
+
+    operator bool() const {
+        return (word >> shift) & 1;
+    }
+
+    condition_bit &operator=(const condition_bit &other) {
+        return *this = bool(other);
+    }
+
+    template<typename T>
+    condition_bit &operator=(const T &value) {
+        word = (word & ~(1u << shift)) | ((uint32_t) static_cast<bool>(value) << shift);
+        return *this;
+    }
+
+private:
+    uint32_t &word;
+    uint32_t shift;
+};
+
+// View of a single field inside of the packed condition register
+class condition_field {
+public:
+    condition_field(uint32_t &word, uint32_t field) :
+            condition_fixed_point{bit(word, field, 0), bit(word, field, 1), bit(word, field, 2), bit(word, field, 3)},
+            condition_floating_point{bit(word, field, 0), bit(word, field, 1), bit(word, field, 2), bit(word, field, 3)},
+            condition_floating_point_compare{bit(word, field, 0), bit(word, field, 1), bit(word, field, 2), bit(word, field, 3)} {
+    }
+
+	struct {
+		condition_bit LT; // Bit 0
+		condition_bit GT; // Bit 1
+		condition_bit EQ; // Bit 2
+		condition_bit SO; // Bit 3
 	} condition_fixed_point;
 
 	// Special type for CR1
-	struct condition_floating_point {
-		uint8_t OX:1; 	// Bit 7
-		uint8_t VX:1; 	// Bit 6
-		uint8_t FEX:1;	// Bit 5
-		uint8_t FX:1; 	// Bit 4
+	struct {
+		condition_bit FX; 	// Bit 4
+		condition_bit FEX;	// Bit 5
+		condition_bit VX; 	// Bit 6
+		condition_bit OX; 	// Bit 7
 	} condition_floating_point;
 
-	struct condition_floating_point_compare {
-		uint8_t FU:1; // Bit 3
-		uint8_t FE:1; // Bit 2
-		uint8_t FG:1; // Bit 1
-		uint8_t FL:1; // Bit 0
+	struct {
+		condition_bit FL; // Bit 0
+		condition_bit FG; // Bit 1
+		condition_bit FE; // Bit 2
+		condition_bit FU; // Bit 3
 	} condition_floating_point_compare;
+
+private:
+    // Bit inside of the field in big endian notation
+    static condition_bit bit(uint32_t &word, uint32_t field, uint32_t index) {
+        return condition_bit(word, condition_field_shift(field) + 3 - index);
+    }
 };
 
-// CR is in big endian notation, hence the order is reversed with 7-i
+// The condition register is stored packed in a single word.
+// With LAZY_FLAGS, CR0 of record form instructions is only computed when the CR is read.
 struct condition_reg {
 public:
     condition_reg& operator=(uint32_t value) {
-        ap_uint<32> temp = value;
-        for(int32_t i = 0; i < 8; i++) {
-#pragma HLS unroll
-            CR[i].condition_fixed_point.SO = temp[i*4+0];
-            CR[i].condition_fixed_point.EQ = temp[i*4+1];
-            CR[i].condition_fixed_point.GT = temp[i*4+2];
-            CR[i].condition_fixed_point.LT = temp[i*4+3];
-        }
+#ifdef LAZY_FLAGS
+        CR0_pending = false;
+#endif
+        CR = value;
         return *this;
     }
 
-    ap_uint<32> getCR() {
-        ap_uint<32> temp;
-        for(int32_t i = 0; i < 8; i++) {
-#pragma HLS unroll
-            temp[i*4+0] = CR[i].condition_fixed_point.SO;
-            temp[i*4+1] = CR[i].condition_fixed_point.EQ;
-            temp[i*4+2] = CR[i].condition_fixed_point.GT;
-            temp[i*4+3] = CR[i].condition_fixed_point.LT;
+    ppc_uint<32> getCR() {
+        resolve();
+        return CR;
+    }
+
+    // Bit in big endian notation, as used by BI
+    bool bit(uint32_t BI) {
+        resolve();
+        return (CR >> condition_bit_shift(BI)) & 1;
+    }
+
+    // Field in big endian notation, returns a combination of CR_LT, CR_GT, CR_EQ and CR_SO
+    uint32_t field(uint32_t i) {
+        resolve();
+        return (CR >> condition_field_shift(i)) & 0xF;
+    }
+
+    void set_field(uint32_t i, uint32_t value) {
+#ifdef LAZY_FLAGS
+        if(i == 0) {
+            CR0_pending = false;
+        }
+#endif
+        CR = (CR & ~(0xFu << condition_field_shift(i))) | ((value & 0xF) << condition_field_shift(i));
+    }
+
+    condition_field operator[](uint32_t i) {
+        resolve();
+        return condition_field(CR, i);
+    }
+
+#ifdef LAZY_FLAGS
+    // Records the result of a record form instruction and the summary overflow to copy into CR0
+    void defer_CR0(int32_t result, bool SO) {
+        CR0_pending = true;
+        CR0_result = result;
+        CR0_SO = SO;
+    }
+
+    void resolve() {
+        if(CR0_pending) {
+            CR0_pending = false;
+            uint32_t value = CR0_SO ? CR_SO : 0;
+            if(CR0_result == 0) {
+                value |= CR_EQ;
+            } else if(CR0_result < 0) {
+                value |= CR_LT;
+            } else {
+                value |= CR_GT;
+            }
+            CR = (CR & 0x0FFFFFFF) | (value << condition_field_shift(0));
         }
-        return temp;
     }
 
-    condition_field& operator[](uint32_t i) {
-        return CR[7-i];
+    bool CR0_pending = false;
+    int32_t CR0_result;
+    bool CR0_SO;
+#else
+    void resolve() {
+#pragma HLS inline
     }
+#endif
 
-	condition_field CR[8];
+	uint32_t CR;
 };
 
 struct fixed_point_exception_reg {
 	struct {
-		ap_uint<7> string_bytes; // For load/store string
-		ap_uint<22> RESERVED_2; // Reserved
-		ap_uint<1> CA; 			// Carry bit
-		ap_uint<1> OV; 			// Overflow bit
-		ap_uint<1> SO; 			// Summary overflow bit
-		//ap_uint<32> RESERVED_1; 	// Reserved
+		ppc_uint<7> string_bytes; // For load/store string
+		ppc_uint<22> RESERVED_2; // Reserved
+		ppc_uint<1> CA; 			// Carry bit
+		ppc_uint<1> OV; 			// Overflow bit
+		ppc_uint<1> SO; 			// Summary overflow bit
+		//ppc_uint<32> RESERVED_1; 	// Reserved
 	} exception_fields;
 	fixed_point_exception_reg& operator=(uint32_t XER) {
-	    ap_uint<32> val = XER;
+	    ppc_uint<32> val = XER;
         exception_fields.string_bytes = val(6, 0);
         exception_fields.RESERVED_2 = val(28, 7);
         exception_fields.CA = val[29];
@@ -102,8 +205,8 @@ struct fixed_point_exception_reg {
         exception_fields.SO = val[31];
 	    return *this;
 	}
-	ap_uint<32> getXER() {
-        ap_uint<32> val;
+	ppc_uint<32> getXER() {
+        ppc_uint<32> val;
         val(6, 0) = exception_fields.string_bytes;
         val(28, 7) = exception_fields.RESERVED_2;
         val[29] = exception_fields.CA;
@@ -114,13 +217,13 @@ struct fixed_point_exception_reg {
 };
 
 typedef struct {
-	ap_uint<32> GPR[32]; // General purpose registers
-	ap_uint<64> FPR[32]; // Floating point registers
+	ppc_uint<32> GPR[32]; // General purpose registers
+	ppc_uint<64> FPR[32]; // Floating point registers
 	condition_reg condition_reg; // Condition register
-	ap_uint<32> link_register; // Link register
+	ppc_uint<32> link_register; // Link register
 	fixed_point_exception_reg fixed_exception_reg; // Fixed point exception register
-	ap_uint<32> count_register; // Count register
-	ap_uint<32> program_counter; // Program counter register
+	ppc_uint<32> count_register; // Count register
+	ppc_uint<32> program_counter; // Program counter register
 } registers_t;
 
 #endif
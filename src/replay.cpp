@@ -0,0 +1,376 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "replay.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "mmio.hpp"
+
+namespace {
+    const char MAGIC[8] = {'P', 'P', 'C', 'R', 'P', 'L', 'A', 'Y'};
+    const uint8_t VERSION = 1;
+
+    typedef enum {OFF, RECORD, REPLAY} replay_mode_t;
+
+    thread_local replay_mode_t mode = OFF;
+    thread_local replay::log_t *recorded = nullptr;
+    thread_local const replay::log_t *replayed = nullptr;
+    thread_local uint64_t cursor = 0;
+    thread_local uint64_t next_input = 0; // Index of the first INPUT event at or after the cursor
+    thread_local uint64_t retired = 0;
+    thread_local bool mismatch = false;
+
+    void find_next_input() {
+        next_input = cursor;
+        while(next_input < replayed->events.size() && replayed->events[next_input].kind != replay::INPUT) {
+            next_input++;
+        }
+    }
+
+    // Returns the next event if it matches, otherwise flags the divergence and keeps the cursor
+    const replay::event_t *consume(replay::event_kind_t kind, uint32_t address, uint32_t size) {
+        if(cursor < replayed->events.size()) {
+            const replay::event_t &event = replayed->events[cursor];
+            if(event.kind == kind && event.address == address && event.size == size) {
+                cursor++;
+                return &event;
+            }
+        }
+        mismatch = true;
+        return nullptr;
+    }
+
+    uint32_t placeholder_read(uint32_t address, uint32_t size) {
+        const replay::event_t *event = consume(replay::MMIO_READ, address, size);
+        return event != nullptr ? event->value : 0;
+    }
+
+    void placeholder_write(uint32_t address, uint32_t size, uint32_t value) {
+        const replay::event_t *event = consume(replay::MMIO_WRITE, address, size);
+        if(event != nullptr && event->value != value) {
+            mismatch = true;
+        }
+    }
+
+    // The file stores all numbers little endian
+    void put(FILE *file, uint64_t value, uint32_t bytes) {
+        for(uint32_t i = 0; i < bytes; i++) {
+            fputc((int) ((value >> (i*8)) & 0xFF), file);
+        }
+    }
+
+    bool get(FILE *file, uint64_t &value, uint32_t bytes) {
+        value = 0;
+        for(uint32_t i = 0; i < bytes; i++) {
+            int c = fgetc(file);
+            if(c == EOF) {
+                return false;
+            }
+            value |= (uint64_t) c << (i*8);
+        }
+        return true;
+    }
+
+    void put_registers(FILE *file, registers_t registers) {
+        for(uint32_t i = 0; i < 32; i++) {
+            put(file, (uint32_t) registers.GPR[i], 4);
+        }
+        for(uint32_t i = 0; i < 32; i++) {
+            put(file, (uint64_t) registers.FPR[i], 8);
+        }
+        put(file, (uint32_t) registers.condition_reg.getCR(), 4);
+        put(file, (uint32_t) registers.fixed_exception_reg.getXER(), 4);
+        put(file, (uint32_t) registers.link_register, 4);
+        put(file, (uint32_t) registers.count_register, 4);
+        put(file, (uint32_t) registers.program_counter, 4);
+    }
+
+    bool get_registers(FILE *file, registers_t &registers) {
+        uint64_t value;
+        for(uint32_t i = 0; i < 32; i++) {
+            if(!get(file, value, 4)) {
+                return false;
+            }
+            registers.GPR[i] = value;
+        }
+        for(uint32_t i = 0; i < 32; i++) {
+            if(!get(file, value, 8)) {
+                return false;
+            }
+            registers.FPR[i] = value;
+        }
+        if(!get(file, value, 4)) {
+            return false;
+        }
+        registers.condition_reg = (uint32_t) value;
+        if(!get(file, value, 4)) {
+            return false;
+        }
+        registers.fixed_exception_reg = (uint32_t) value;
+        if(!get(file, value, 4)) {
+            return false;
+        }
+        registers.link_register = value;
+        if(!get(file, value, 4)) {
+            return false;
+        }
+        registers.count_register = value;
+        if(!get(file, value, 4)) {
+            return false;
+        }
+        registers.program_counter = value;
+        return true;
+    }
+}
+
+// "PPCRPLAY", version byte, then the regions, events and checkpoints, each preceded by their 8 byte count:
+//   region      start and size as 4 byte words
+//   event       kind byte, 8 byte position, address, size byte, value
+//   checkpoint  8 byte position and event index, GPR 0 to 31, FPR 0 to 31 as 8 byte words, CR, XER, LR, CTR, PC,
+//               the 4 byte word count of the data memory and the words
+bool replay::log_t::save(const char *file_name) const {
+    FILE *file = fopen(file_name, "wb");
+    if(file == nullptr) {
+        return false;
+    }
+    fwrite(MAGIC, 1, sizeof(MAGIC), file);
+    put(file, VERSION, 1);
+
+    put(file, regions.size(), 8);
+    for(const region_t &region : regions) {
+        put(file, region.start, 4);
+        put(file, region.size, 4);
+    }
+
+    put(file, events.size(), 8);
+    for(const event_t &event : events) {
+        put(file, event.kind, 1);
+        put(file, event.position, 8);
+        put(file, event.address, 4);
+        put(file, event.size, 1);
+        put(file, event.value, 4);
+    }
+
+    put(file, checkpoints.size(), 8);
+    for(const checkpoint_t &checkpoint : checkpoints) {
+        put(file, checkpoint.position, 8);
+        put(file, checkpoint.event, 8);
+        put_registers(file, checkpoint.registers);
+        put(file, checkpoint.data_memory.size(), 4);
+        for(const ppc_uint<32> &word : checkpoint.data_memory) {
+            put(file, (uint32_t) word, 4);
+        }
+    }
+
+    bool ok = !ferror(file);
+    return fclose(file) == 0 && ok;
+}
+
+bool replay::log_t::load(const char *file_name) {
+    FILE *file = fopen(file_name, "rb");
+    if(file == nullptr) {
+        return false;
+    }
+    regions.clear();
+    events.clear();
+    checkpoints.clear();
+
+    char magic[sizeof(MAGIC)];
+    uint64_t value, count;
+    bool ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 &&
+              get(file, value, 1) && value == VERSION;
+
+    ok = ok && get(file, count, 8);
+    for(uint64_t i = 0; ok && i < count; i++) {
+        uint64_t start, size;
+        ok = get(file, start, 4) && get(file, size, 4);
+        if(!ok) {
+            break;
+        }
+        regions.push_back({(uint32_t) start, (uint32_t) size});
+    }
+
+    ok = ok && get(file, count, 8);
+    for(uint64_t i = 0; ok && i < count; i++) {
+        uint64_t kind, position, address, size;
+        ok = get(file, kind, 1) && kind <= INPUT && get(file, position, 8) && get(file, address, 4) &&
+             get(file, size, 1) && get(file, value, 4);
+        if(!ok) {
+            break;
+        }
+        events.push_back({(event_kind_t) kind, position, (uint32_t) address, (uint32_t) size, (uint32_t) value});
+    }
+
+    ok = ok && get(file, count, 8);
+    for(uint64_t i = 0; ok && i < count; i++) {
+        checkpoint_t checkpoint;
+        uint64_t words;
+        ok = get(file, checkpoint.position, 8) && get(file, checkpoint.event, 8) &&
+             get_registers(file, checkpoint.registers) && get(file, words, 4);
+        for(uint64_t j = 0; ok && j < words; j++) {
+            ok = get(file, value, 4);
+            if(!ok) {
+                break;
+            }
+            checkpoint.data_memory.push_back((uint32_t) value);
+        }
+        if(!ok) {
+            break;
+        }
+        checkpoints.push_back(checkpoint);
+    }
+
+    fclose(file);
+    return ok;
+}
+
+void replay::start_recording(log_t &log) {
+    stop();
+    mode = RECORD;
+    recorded = &log;
+    log.regions.clear();
+    for(const mmio::region_t &region : mmio::mapped_regions()) {
+        log.regions.push_back({region.start, region.size});
+    }
+    log.events.clear();
+    log.checkpoints.clear();
+    retired = 0;
+}
+
+void replay::start_replay(const log_t &log) {
+    stop();
+    mode = REPLAY;
+    replayed = &log;
+    mmio::unmap_all();
+    for(const region_t &region : log.regions) {
+        mmio::map(region.start, region.size, placeholder_read, placeholder_write);
+    }
+    cursor = 0;
+    find_next_input();
+    retired = 0;
+    mismatch = false;
+}
+
+void replay::stop() {
+    if(mode == REPLAY) {
+        mmio::unmap_all();
+    }
+    mode = OFF;
+    recorded = nullptr;
+    replayed = nullptr;
+}
+
+bool replay::recording() {
+    return mode == RECORD;
+}
+
+bool replay::replaying() {
+    return mode == REPLAY;
+}
+
+void replay::device_read(uint32_t address, uint32_t size, uint32_t value) {
+    if(mode == RECORD) {
+        recorded->events.push_back({MMIO_READ, 0, address, size, value});
+    }
+}
+
+void replay::device_write(uint32_t address, uint32_t size, uint32_t value) {
+    if(mode == RECORD) {
+        recorded->events.push_back({MMIO_WRITE, 0, address, size, value});
+    }
+}
+
+uint32_t replay::input(uint32_t channel, uint32_t value) {
+    if(mode == RECORD) {
+        recorded->events.push_back({INPUT, retired, channel, 4, value});
+    } else if(mode == REPLAY) {
+        const event_t *event = consume(INPUT, channel, 4);
+        if(event == nullptr || event->position != retired) {
+            mismatch = true;
+        }
+        if(event != nullptr) {
+            value = event->value;
+            find_next_input();
+        }
+    }
+    return value;
+}
+
+bool replay::input_pending(uint32_t &channel) {
+    if(mode != REPLAY || next_input >= replayed->events.size() || replayed->events[next_input].position > retired) {
+        return false;
+    }
+    channel = replayed->events[next_input].address;
+    return true;
+}
+
+run_result_t replay::run(registers_t &registers, ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory,
+                         const run_options_t &options) {
+    run_options_t limited = options;
+    if(mode == REPLAY && next_input < replayed->events.size()) {
+        uint64_t remaining = replayed->events[next_input].position - std::min(retired, replayed->events[next_input].position);
+        if(remaining < limited.max_instructions) {
+            limited.max_instructions = remaining;
+        }
+    }
+
+    run_result_t result = {0, STOP_BUDGET};
+    if(limited.max_instructions > 0) {
+        result = ::run(registers, instruction_memory, data_memory, limited);
+    }
+    retired += result.retired;
+    return result;
+}
+
+uint64_t replay::position() {
+    return retired;
+}
+
+uint64_t replay::checkpoint(registers_t &registers, const ppc_uint<32> *data_memory, uint32_t size) {
+    if(mode != RECORD) {
+        return 0;
+    }
+    checkpoint_t checkpoint;
+    checkpoint.position = retired;
+    checkpoint.event = recorded->events.size();
+    checkpoint.registers = registers;
+    checkpoint.data_memory.assign(data_memory, data_memory + size);
+    recorded->checkpoints.push_back(checkpoint);
+    return recorded->checkpoints.size() - 1;
+}
+
+void replay::restore(uint64_t index, registers_t &registers, ppc_uint<32> *data_memory) {
+    if(mode != REPLAY || index >= replayed->checkpoints.size()) {
+        return;
+    }
+    const checkpoint_t &checkpoint = replayed->checkpoints[index];
+    registers = checkpoint.registers;
+    std::copy(checkpoint.data_memory.begin(), checkpoint.data_memory.end(), data_memory);
+    cursor = checkpoint.event;
+    find_next_input();
+    retired = checkpoint.position;
+    mismatch = false;
+}
+
+bool replay::diverged() {
+    return mismatch;
+}
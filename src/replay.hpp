@@ -0,0 +1,106 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_REPLAY_HPP
+#define POWERPC_HLS_REPLAY_HPP
+
+#include <stdint.h>
+#include <vector>
+#include "ppc_int.hpp"
+#include "registers.hpp"
+#include "test_bench_utils.hpp"
+
+// Software simulation only!
+// Deterministic record and replay. While recording, every input from outside of the simulation is logged: the
+// values read from devices (see mmio), the values the harness injects through input() and, to detect divergence,
+// the values written to devices. A replay maps placeholder devices over the recorded regions, which return the
+// logged reads, so the run is reproduced exactly without the live device models.
+// Checkpoints store the registers, the data memory and the position in the log, so a replay can start at any of
+// them instead of at the beginning.
+// Like the device table, the state is per host thread.
+namespace replay {
+    typedef enum {MMIO_READ, MMIO_WRITE, INPUT} event_kind_t;
+
+    typedef struct {
+        event_kind_t kind;
+        uint64_t position; // Instructions retired before an INPUT, not tracked for device accesses
+        uint32_t address; // Device address or input channel
+        uint32_t size; // Access size in bytes
+        uint32_t value;
+    } event_t;
+
+    typedef struct {
+        uint64_t position; // Instructions retired before the checkpoint
+        uint64_t event; // Index of the next event
+        registers_t registers;
+        std::vector<ppc_uint<32>> data_memory;
+    } checkpoint_t;
+
+    typedef struct {
+        uint32_t start;
+        uint32_t size;
+    } region_t;
+
+    struct log_t {
+        std::vector<region_t> regions; // Devices mapped when the recording started
+        std::vector<event_t> events;
+        std::vector<checkpoint_t> checkpoints;
+
+        bool save(const char *file_name) const;
+        bool load(const char *file_name);
+    };
+
+    // Devices have to be mapped before the recording starts, the log must outlive the recording
+    void start_recording(log_t &log);
+    // Unmaps all devices and maps the placeholders of the log. Starts at the beginning of the log.
+    void start_replay(const log_t &log);
+    // Ends recording or replay, a replay unmaps its placeholders
+    void stop();
+    bool recording();
+    bool replaying();
+
+    // Called by mmio for every device access
+    void device_read(uint32_t address, uint32_t size, uint32_t value);
+    void device_write(uint32_t address, uint32_t size, uint32_t value);
+
+    // Value from outside of the simulation, e.g. a sensor value, which the harness writes into the data memory.
+    // Recording logs and returns value, replay returns the logged value instead.
+    uint32_t input(uint32_t channel, uint32_t value);
+    // Replay: true if the next logged input was injected at the current position, channel receives its channel
+    bool input_pending(uint32_t &channel);
+
+    // Same as ::run, but counts the retired instructions. A replay stops before the position of the next input,
+    // so the harness can inject it at the same point as in the recording.
+    run_result_t run(registers_t &registers, ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory,
+                     const run_options_t &options);
+    // Instructions retired by run since the start of the recording or replay
+    uint64_t position();
+
+    // Recording: adds a checkpoint of the data memory words 0 to size-1 to the log and returns its index
+    uint64_t checkpoint(registers_t &registers, const ppc_uint<32> *data_memory, uint32_t size);
+    // Replay: restores the checkpoint with the given index and continues the replay from there
+    void restore(uint64_t index, registers_t &registers, ppc_uint<32> *data_memory);
+
+    // Replay: true once a device access or input did not match the log, e.g. because a different program runs
+    bool diverged();
+}
+
+#endif //POWERPC_HLS_REPLAY_HPP
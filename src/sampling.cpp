@@ -0,0 +1,389 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "sampling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "decode_cache.hpp"
+#include "instruction_decode.hpp"
+#include "micro_op.hpp"
+#include "pipeline.hpp"
+
+namespace {
+    // Dimensions of the basic block vectors, the instructions are hashed into them by their address
+    const uint32_t PROFILE_DIMENSIONS = 32;
+    // Program counters sampled per interval while profiling
+    const uint32_t PROFILE_SAMPLES = 256;
+    const uint32_t CLUSTER_ITERATIONS = 20;
+
+    // Cycles of an in-order core with single cycle execution, besides the following latencies
+    const uint32_t MUL_CYCLES = 4;
+    const uint32_t DIV_CYCLES = 19;
+    const uint32_t LOAD_CYCLES = 2;
+    const uint32_t TAKEN_BRANCH_PENALTY = 2;
+
+    typedef std::vector<double> vector_t;
+
+    void account(const micro_op_t &decoded, uint32_t program_counter, uint32_t next_program_counter,
+                 sampling::statistics_t &statistics) {
+        uint32_t cycles = 1;
+        uint32_t words = 0;
+        switch(decoded.opcode) {
+            case micro_op::MUL:
+                cycles = MUL_CYCLES;
+                break;
+            case micro_op::DIV:
+                cycles = DIV_CYCLES;
+                break;
+            case micro_op::LOAD:
+            case micro_op::STORE:
+                // lmw and stmw transfer one word per cycle
+                words = decoded.flags & micro_op::MULTIPLE ? 32 - decoded.reg_c : 1;
+                cycles = decoded.opcode == micro_op::LOAD ? LOAD_CYCLES + words - 1 : words;
+                break;
+            case micro_op::LOAD_STRING:
+            case micro_op::STORE_STRING:
+                // The length is only known while executing, strings are rare enough to count them as one word
+                words = 1;
+                cycles = LOAD_CYCLES;
+                break;
+            default:
+                break;
+        }
+        bool taken = micro_op::is_branch(decoded) && next_program_counter != program_counter + 4;
+        if(taken) {
+            cycles += TAKEN_BRANCH_PENALTY;
+        }
+
+        statistics.instructions++;
+        statistics.cycles += cycles;
+        statistics.opcodes[decoded.opcode]++;
+        statistics.memory_accesses += words;
+        statistics.taken_branches += taken;
+    }
+
+    // Breakpoints don't stop the first instruction of a run, so they are checked before every part of a sampled run
+    bool at_breakpoint(const run_options_t &options, uint32_t program_counter) {
+        return std::find(options.breakpoints.begin(), options.breakpoints.end(), program_counter) !=
+               options.breakpoints.end();
+    }
+
+    run_result_t fast_forward(registers_t &registers, ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory,
+                              const run_options_t &options, uint64_t instructions) {
+        run_options_t part = options;
+        part.max_instructions = instructions;
+        return run(registers, instruction_memory, data_memory, part);
+    }
+
+    double distance(const vector_t &a, const vector_t &b) {
+        double sum = 0;
+        for(uint32_t i = 0; i < a.size(); i++) {
+            sum += (a[i] - b[i]) * (a[i] - b[i]);
+        }
+        return sum;
+    }
+
+    // k-means over the basic block vectors, the centroids start at the intervals farthest from the chosen ones.
+    // Returns the cluster of every interval.
+    std::vector<uint32_t> cluster(const std::vector<vector_t> &vectors, uint32_t k) {
+        std::vector<vector_t> centroids = {vectors[0]};
+        std::vector<double> nearest(vectors.size());
+        while(centroids.size() < k) {
+            uint32_t farthest = 0;
+            for(uint32_t i = 0; i < vectors.size(); i++) {
+                nearest[i] = distance(vectors[i], centroids[0]);
+                for(const vector_t &centroid : centroids) {
+                    nearest[i] = std::min(nearest[i], distance(vectors[i], centroid));
+                }
+                if(nearest[i] > nearest[farthest]) {
+                    farthest = i;
+                }
+            }
+            if(nearest[farthest] == 0) {
+                break;
+            }
+            centroids.push_back(vectors[farthest]);
+        }
+
+        std::vector<uint32_t> assignment(vectors.size(), 0);
+        for(uint32_t iteration = 0; iteration < CLUSTER_ITERATIONS; iteration++) {
+            for(uint32_t i = 0; i < vectors.size(); i++) {
+                for(uint32_t c = 0; c < centroids.size(); c++) {
+                    if(distance(vectors[i], centroids[c]) < distance(vectors[i], centroids[assignment[i]])) {
+                        assignment[i] = c;
+                    }
+                }
+            }
+            std::vector<uint32_t> members(centroids.size(), 0);
+            for(vector_t &centroid : centroids) {
+                std::fill(centroid.begin(), centroid.end(), 0);
+            }
+            for(uint32_t i = 0; i < vectors.size(); i++) {
+                members[assignment[i]]++;
+                for(uint32_t d = 0; d < PROFILE_DIMENSIONS; d++) {
+                    centroids[assignment[i]][d] += vectors[i][d];
+                }
+            }
+            for(uint32_t c = 0; c < centroids.size(); c++) {
+                for(uint32_t d = 0; d < PROFILE_DIMENSIONS && members[c] > 0; d++) {
+                    centroids[c][d] /= members[c];
+                }
+            }
+        }
+        return assignment;
+    }
+
+    // Intervals of the whole run with their basic block vectors, the vectors are estimated from the program
+    // counters between short runs of the fast mode
+    run_result_t profile(registers_t &registers, ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory,
+                         const sampling::sampling_options_t &options, std::vector<vector_t> &vectors) {
+        const run_options_t &run_options = options.run;
+        uint64_t step = std::max<uint64_t>(options.interval / PROFILE_SAMPLES, 1);
+        run_result_t result = {0, STOP_BUDGET};
+        while(result.retired < run_options.max_instructions) {
+            vector_t vector(PROFILE_DIMENSIONS, 0);
+            uint64_t end = std::min(result.retired + options.interval, run_options.max_instructions);
+            uint32_t samples = 0;
+            while(result.retired < end) {
+                if(result.retired > 0 && at_breakpoint(run_options, registers.program_counter)) {
+                    result.reason = STOP_BREAKPOINT;
+                    break;
+                }
+                uint32_t hash = ((uint32_t) registers.program_counter >> 2) * 2654435761u;
+                vector[hash >> 27]++;
+                samples++;
+                run_result_t part = fast_forward(registers, instruction_memory, data_memory, run_options,
+                                                 std::min(step, end - result.retired));
+                result.retired += part.retired;
+                result.reason = part.reason;
+                if(part.reason != STOP_BUDGET) {
+                    break;
+                }
+            }
+            if(samples > 0) {
+                for(double &value : vector) {
+                    value /= samples;
+                }
+                vectors.push_back(vector);
+            }
+            if(result.reason != STOP_BUDGET) {
+                break;
+            }
+        }
+        return result;
+    }
+}
+
+run_result_t sampling::measure(registers_t &registers, ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory,
+                               const run_options_t &options, statistics_t &statistics) {
+    run_options_t step = options;
+    step.max_instructions = 1;
+    step.blocks = nullptr;
+
+    run_result_t result = {0, STOP_BUDGET};
+    while(result.retired < options.max_instructions) {
+        uint32_t program_counter = registers.program_counter;
+        if(result.retired > 0 && at_breakpoint(options, program_counter)) {
+            result.reason = STOP_BREAKPOINT;
+            break;
+        }
+        micro_op_t decoded = options.decoded != nullptr ?
+                             options.decoded->lookup(instruction_memory, program_counter) :
+                             pipeline::decode(pipeline::fetch_index(instruction_memory, program_counter >> 2));
+        run_result_t part = run(registers, instruction_memory, data_memory, step);
+        if(part.retired > 0) {
+            account(decoded, program_counter, registers.program_counter, statistics);
+        }
+        result.retired += part.retired;
+        result.reason = part.reason;
+        if(part.reason != STOP_BUDGET) {
+            break;
+        }
+    }
+    return result;
+}
+
+sampling::sampling_result_t sampling::run_sampled(registers_t &registers, ppc_uint<32> *instruction_memory,
+                                                  ppc_uint<32> *data_memory, const sampling_options_t &options) {
+    const run_options_t &run_options = options.run;
+    uint64_t window = std::min(options.window, options.interval);
+    sampling_result_t result = {};
+    result.result = {0, STOP_BUDGET};
+    // Start of the intervals to measure, sorted
+    std::vector<uint64_t> starts;
+    std::vector<double> weights;
+
+    registers_t initial_registers = registers;
+    std::vector<ppc_uint<32>> initial_memory;
+    if(options.policy == CLUSTERED) {
+        if(options.data_memory_size == 0) {
+            std::cout << "Clustered sampling needs the size of the data memory!" << std::endl;
+            return result;
+        }
+        initial_memory.assign(data_memory, data_memory + options.data_memory_size);
+        std::vector<vector_t> vectors;
+        result.result = profile(registers, instruction_memory, data_memory, options, vectors);
+        if(vectors.empty()) {
+            return result;
+        }
+
+        // The representative of a cluster is the interval closest to its mean
+        std::vector<uint32_t> assignment = cluster(vectors, std::max<uint32_t>(options.clusters, 1));
+        uint32_t clusters = *std::max_element(assignment.begin(), assignment.end()) + 1;
+        std::vector<vector_t> means(clusters, vector_t(PROFILE_DIMENSIONS, 0));
+        std::vector<uint32_t> members(clusters, 0);
+        for(uint32_t i = 0; i < vectors.size(); i++) {
+            members[assignment[i]]++;
+            for(uint32_t d = 0; d < PROFILE_DIMENSIONS; d++) {
+                means[assignment[i]][d] += vectors[i][d];
+            }
+        }
+        std::vector<int64_t> representative(clusters, -1);
+        for(uint32_t i = 0; i < vectors.size(); i++) {
+            uint32_t c = assignment[i];
+            vector_t mean = means[c];
+            for(double &value : mean) {
+                value /= members[c];
+            }
+            if(representative[c] < 0 || distance(vectors[i], mean) < distance(vectors[representative[c]], mean)) {
+                representative[c] = i;
+            }
+        }
+        std::vector<std::pair<uint64_t, double>> chosen;
+        for(uint32_t c = 0; c < clusters; c++) {
+            if(representative[c] >= 0) {
+                chosen.push_back({representative[c] * options.interval, (double) members[c] / vectors.size()});
+            }
+        }
+        std::sort(chosen.begin(), chosen.end());
+        for(const std::pair<uint64_t, double> &interval : chosen) {
+            starts.push_back(interval.first);
+            weights.push_back(interval.second);
+        }
+
+        // Measure the representatives in a second run and continue with the final state of the first one.
+        // The first run already found the end, so the second one needs no stop conditions.
+        run_options_t second = run_options;
+        second.breakpoints.clear();
+        second.has_exit_address = false;
+        second.stop_on_trap = false;
+        second.stop_on_system_call = false;
+        registers_t final_registers = registers;
+        std::vector<ppc_uint<32>> final_memory(data_memory, data_memory + options.data_memory_size);
+        registers = initial_registers;
+        std::copy(initial_memory.begin(), initial_memory.end(), data_memory);
+        uint64_t position = 0;
+        for(uint32_t i = 0; i < starts.size(); i++) {
+            if(starts[i] > position) {
+                position += fast_forward(registers, instruction_memory, data_memory, second,
+                                         starts[i] - position).retired;
+            }
+            sample_t sample = {position, weights[i], {}};
+            run_options_t part = second;
+            part.max_instructions = std::min(window, result.result.retired - position);
+            position += measure(registers, instruction_memory, data_memory, part, sample.statistics).retired;
+            if(sample.statistics.instructions > 0) {
+                result.samples.push_back(sample);
+            }
+        }
+        registers = final_registers;
+        std::copy(final_memory.begin(), final_memory.end(), data_memory);
+    } else {
+        run_result_t &total = result.result;
+        while(total.retired < run_options.max_instructions && total.reason == STOP_BUDGET) {
+            uint64_t skip = std::min(options.interval - window, run_options.max_instructions - total.retired);
+            if(skip > 0) {
+                if(total.retired > 0 && at_breakpoint(run_options, registers.program_counter)) {
+                    total.reason = STOP_BREAKPOINT;
+                    break;
+                }
+                run_result_t part = fast_forward(registers, instruction_memory, data_memory, run_options, skip);
+                total.retired += part.retired;
+                total.reason = part.reason;
+            }
+            if(total.reason != STOP_BUDGET || total.retired == run_options.max_instructions) {
+                break;
+            }
+            if(total.retired > 0 && at_breakpoint(run_options, registers.program_counter)) {
+                total.reason = STOP_BREAKPOINT;
+                break;
+            }
+
+            sample_t sample = {total.retired, 0, {}};
+            run_options_t part = run_options;
+            part.max_instructions = std::min(window, run_options.max_instructions - total.retired);
+            run_result_t measured = measure(registers, instruction_memory, data_memory, part, sample.statistics);
+            total.retired += measured.retired;
+            total.reason = measured.reason;
+            if(sample.statistics.instructions > 0) {
+                result.samples.push_back(sample);
+            }
+        }
+
+        // Every measured instruction has the same weight
+        uint64_t measured = 0;
+        for(const sample_t &sample : result.samples) {
+            measured += sample.statistics.instructions;
+        }
+        for(sample_t &sample : result.samples) {
+            sample.weight = (double) sample.statistics.instructions / measured;
+        }
+    }
+
+    // Weighted rates per instruction, scaled to the whole run
+    double total = result.result.retired;
+    double cycles = 0, memory_accesses = 0, taken_branches = 0;
+    std::vector<double> opcodes(OPCODE_COUNT, 0);
+    for(const sample_t &sample : result.samples) {
+        double scale = sample.weight / sample.statistics.instructions;
+        cycles += scale * sample.statistics.cycles;
+        memory_accesses += scale * sample.statistics.memory_accesses;
+        taken_branches += scale * sample.statistics.taken_branches;
+        for(uint32_t i = 0; i < OPCODE_COUNT; i++) {
+            opcodes[i] += scale * sample.statistics.opcodes[i];
+        }
+    }
+    result.estimate.instructions = result.result.retired;
+    result.estimate.cycles = std::llround(cycles * total);
+    result.estimate.memory_accesses = std::llround(memory_accesses * total);
+    result.estimate.taken_branches = std::llround(taken_branches * total);
+    for(uint32_t i = 0; i < OPCODE_COUNT; i++) {
+        result.estimate.opcodes[i] = std::llround(opcodes[i] * total);
+    }
+    result.cpi = cycles;
+
+    result.cpi_error = 0;
+    if(options.policy == PERIODIC && result.samples.size() > 1) {
+        double mean = 0, variance = 0;
+        for(const sample_t &sample : result.samples) {
+            mean += (double) sample.statistics.cycles / sample.statistics.instructions;
+        }
+        mean /= result.samples.size();
+        for(const sample_t &sample : result.samples) {
+            double cpi = (double) sample.statistics.cycles / sample.statistics.instructions;
+            variance += (cpi - mean) * (cpi - mean);
+        }
+        variance /= result.samples.size() - 1;
+        result.cpi_error = std::sqrt(variance / result.samples.size());
+    }
+    return result;
+}
@@ -0,0 +1,89 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_SAMPLING_HPP
+#define POWERPC_HLS_SAMPLING_HPP
+
+#include "ppc_int.hpp"
+#include <vector>
+#include "ppc_types.h"
+#include "registers.hpp"
+#include "test_bench_utils.hpp"
+
+// Software simulation only!
+// Sampled simulation. Most of a run executes in the fast functional mode (see run with a block cache), only short
+// windows execute instruction by instruction in the detailed mode, which collects the instruction mix and an
+// estimate of the cycles of a simple in-order core. The metrics of the whole run are extrapolated from the windows.
+namespace sampling {
+    const uint32_t OPCODE_COUNT = micro_op::FUSED_COMPARE_BRANCH + 1;
+
+    typedef struct {
+        uint64_t instructions;
+        uint64_t cycles; // Estimate, see measure
+        uint64_t opcodes[OPCODE_COUNT]; // Instructions per micro_op::opcode_t
+        uint64_t memory_accesses; // Words loaded or stored
+        uint64_t taken_branches;
+    } statistics_t;
+
+    // PERIODIC measures a window at the end of every interval.
+    // CLUSTERED first profiles the run and groups the intervals by their basic block vectors, then measures one
+    // representative interval per group and weights it by the size of its group.
+    typedef enum {PERIODIC, CLUSTERED} policy_t;
+
+    typedef struct {
+        policy_t policy = PERIODIC;
+        uint64_t interval = 1000000; // Instructions per interval
+        uint64_t window = 10000; // Instructions measured per sample, at most one interval
+        uint32_t clusters = 8; // CLUSTERED: maximal number of representative intervals
+        // CLUSTERED runs the program twice, so it restores the data memory words 0 to data_memory_size-1 in between.
+        // It is required by CLUSTERED, which does not run at all without it.
+        // Devices are not restored: they see every access twice, once while profiling and once while measuring, and
+        // their reads may return different values in the second run. Record the first run with replay, or use
+        // PERIODIC, if that matters.
+        uint32_t data_memory_size = 0;
+        // Stop conditions of the whole run and the caches, max_instructions is the budget of the whole run.
+        // The block cache is used by the fast mode, the decode cache by the detailed mode.
+        run_options_t run;
+    } sampling_options_t;
+
+    typedef struct {
+        uint64_t start; // Retired instructions before the window
+        double weight; // Share of the run, which the sample represents
+        statistics_t statistics;
+    } sample_t;
+
+    typedef struct {
+        run_result_t result; // Of the whole run
+        std::vector<sample_t> samples;
+        statistics_t estimate; // Extrapolated to result.retired instructions
+        double cpi; // Estimated cycles per instruction
+        double cpi_error; // PERIODIC: standard error of the CPI over the samples
+    } sampling_result_t;
+
+    // Detailed mode: executes like run without a block cache and adds the executed instructions to statistics
+    run_result_t measure(registers_t &registers, ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory,
+                         const run_options_t &options, statistics_t &statistics);
+
+    sampling_result_t run_sampled(registers_t &registers, ppc_uint<32> *instruction_memory,
+                                  ppc_uint<32> *data_memory, const sampling_options_t &options);
+}
+
+#endif //POWERPC_HLS_SAMPLING_HPP
@@ -0,0 +1,45 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_SNAPSHOT_HPP
+#define POWERPC_HLS_SNAPSHOT_HPP
+
+#include "registers.hpp"
+#include "paged_memory.hpp"
+
+// Software simulation only!
+// Complete machine state. Copies are cheap, because the memory pages are shared copy-on-write, so a snapshot can be
+// restored many times or forked into independent runs, e.g. after a long initialisation.
+typedef struct {
+    registers_t registers;
+    paged_memory memory;
+} machine_state_t;
+
+inline machine_state_t take_snapshot(const registers_t &registers, const paged_memory &memory) {
+    return machine_state_t{registers, memory};
+}
+
+inline void restore_snapshot(const machine_state_t &snapshot, registers_t &registers, paged_memory &memory) {
+    registers = snapshot.registers;
+    memory = snapshot.memory;
+}
+
+#endif //POWERPC_HLS_SNAPSHOT_HPP
@@ -23,12 +23,15 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 #include "instruction_decode.hpp"
 #include "pipeline.hpp"
 #include "branch_processor.hpp"
+#include "micro_op.hpp"
+#include "trace.hpp"
 
-int32_t read_byte_code(const char *file_name, ap_uint<32> *instruction_memory, uint32_t memory_size) {
+int32_t read_byte_code(const char *file_name, ppc_uint<32> *instruction_memory, uint32_t memory_size) {
 	std::ifstream byte_code(file_name, std::ios::binary);
 	if(byte_code.is_open()) {
 		std::ios::pos_type begin = byte_code.tellg();
@@ -51,6 +54,7 @@ int32_t read_byte_code(const char *file_name, ap_uint<32> *instruction_memory, u
 		byte_code.seekg(0, std::ios::beg);
 		byte_code.read((char *)instruction_memory, size);
 		byte_code.close();
+		prepare_instructions(instruction_memory, size/4);
 
 		return size/4;
 	} else {
@@ -59,7 +63,15 @@ int32_t read_byte_code(const char *file_name, ap_uint<32> *instruction_memory, u
 	}
 }
 
-int32_t read_data(const char *file_name, ap_uint<32> *data_memory, uint32_t memory_size) {
+void prepare_instructions(ppc_uint<32> *instruction_memory, uint32_t size) {
+#ifdef HOST_ORDER_INSTRUCTIONS
+	for(uint32_t i = 0; i < size; i++) {
+		instruction_memory[i] = pipeline::swap_endianness(instruction_memory[i]);
+	}
+#endif
+}
+
+int32_t read_data(const char *file_name, ppc_uint<32> *data_memory, uint32_t memory_size) {
     std::ifstream byte_code(file_name, std::ios::binary);
     if(byte_code.is_open()) {
         std::ios::pos_type begin = byte_code.tellg();
@@ -83,7 +95,7 @@ int32_t read_data(const char *file_name, ap_uint<32> *data_memory, uint32_t memo
         byte_code.close();
 
         for(uint32_t i = 0; i < temp_size/4; i++) {
-            ap_uint<32> big;
+            ppc_uint<32> big;
             big(31, 24) = temp[i*4+3];
             big(23, 16) = temp[i*4+2];
             big(15, 8) = temp[i*4+1];
@@ -98,23 +110,148 @@ int32_t read_data(const char *file_name, ap_uint<32> *data_memory, uint32_t memo
     }
 }
 
-bool execute_single_instruction(ap_uint<32> instruction, registers_t &registers, ap_uint<32> *data_memory) {
-    decode_result_t decoded = pipeline::decode(instruction);
-    bool trap = false;
-    if(decoded.branch_decode_result.execute == branch::BRANCH) {
-        // Extracting branch from the "pipeline" reduces the minimal execution time.
-        branch::branch(decoded.branch_decode_result.branch_decoded, registers);
-    } else {
-        trap = pipeline::execute(decoded, registers, data_memory);
+namespace {
+    // Executes an instruction and records it into the trace of this thread
+    template<typename T>
+    bool execute_traced(const micro_op_t &decoded, uint32_t instruction, registers_t &registers, T data_memory) {
+        uint32_t program_counter = registers.program_counter;
+        trace::footprint_t footprint = trace::footprint(decoded, registers);
+        bool trap = execute_decoded_instruction(decoded, registers, data_memory);
+        trace::record(program_counter, instruction, registers, footprint, data_memory, trap);
+        return trap;
+    }
+}
+
+bool execute_single_instruction(ppc_uint<32> instruction, registers_t &registers, ppc_uint<32> *data_memory) {
+    if(trace::active()) {
+        return execute_traced(pipeline::decode(instruction), instruction, registers, data_memory);
+    }
+    return execute_decoded_instruction(pipeline::decode(instruction), registers, data_memory);
+}
+
+bool execute_single_instruction(ppc_uint<32> instruction, registers_t &registers, paged_memory &data_memory) {
+    if(trace::active()) {
+        return execute_traced<paged_memory &>(pipeline::decode(instruction), instruction, registers, data_memory);
+    }
+    return execute_decoded_instruction(pipeline::decode(instruction), registers, data_memory);
+}
+
+namespace {
+    template<typename T>
+    bool execute_decoded(const micro_op_t &decoded, registers_t &registers, T data_memory) {
+        bool trap = false;
+        if(micro_op::is_branch(decoded)) {
+            // Extracting branch from the "pipeline" reduces the minimal execution time.
+            pipeline::execute_branch(decoded, registers);
+        } else {
+            trap = pipeline::execute(decoded, registers, data_memory);
+        }
+        registers.program_counter += 4;
+        return trap;
+    }
+}
+
+bool execute_decoded_instruction(const micro_op_t &decoded, registers_t &registers, ppc_uint<32> *data_memory) {
+    return execute_decoded<ppc_uint<32> *>(decoded, registers, data_memory);
+}
+
+bool execute_decoded_instruction(const micro_op_t &decoded, registers_t &registers, paged_memory &data_memory) {
+    return execute_decoded<paged_memory &>(decoded, registers, data_memory);
+}
+
+bool execute_cached_instruction(decode_cache &cache, ppc_uint<32> *instruction_memory, registers_t &registers,
+                                ppc_uint<32> *data_memory) {
+    if(trace::active()) {
+        uint32_t program_counter = registers.program_counter;
+        return execute_traced(cache.lookup(instruction_memory, program_counter),
+                              pipeline::fetch_index(instruction_memory, program_counter >> 2), registers, data_memory);
     }
-    registers.program_counter += 4;
-    return trap;
+    return execute_decoded_instruction(cache.lookup(instruction_memory, registers.program_counter), registers,
+                                       data_memory);
 }
 
-void execute_program(ap_uint<32> *instruction_memory, uint32_t size, registers_t &registers, ap_uint<32> *data_memory, trap_handler_t trap_handler) {
+void execute_program(ppc_uint<32> *instruction_memory, uint32_t size, registers_t &registers, ppc_uint<32> *data_memory, trap_handler_t trap_handler) {
     for(uint32_t i = 0; i < size; i++) {
 		if(execute_single_instruction(pipeline::fetch_index(instruction_memory, i), registers, data_memory)) {
 		    trap_handler(i);
 		}
 	}
 }
+
+namespace {
+    // Executes one instruction at a time, T is the type of the data memory like in fixed_point
+    template<typename T>
+    run_result_t run_instructions(registers_t &registers, ppc_uint<32> *instruction_memory, T data_memory,
+                                  const run_options_t &options) {
+        run_result_t result;
+        result.retired = 0;
+        result.reason = STOP_BUDGET;
+
+        bool first = true;
+        while(result.retired < options.max_instructions) {
+            uint32_t program_counter = registers.program_counter;
+            if(options.has_exit_address && program_counter == options.exit_address) {
+                result.reason = STOP_EXIT;
+                break;
+            }
+            // Breakpoints don't stop the first instruction, so a run can continue from a breakpoint
+            if(!first && !options.breakpoints.empty() &&
+               std::find(options.breakpoints.begin(), options.breakpoints.end(), program_counter) != options.breakpoints.end()) {
+                result.reason = STOP_BREAKPOINT;
+                break;
+            }
+            first = false;
+
+            micro_op_t decoded;
+            if(options.decoded != nullptr) {
+                decoded = options.decoded->lookup(instruction_memory, program_counter);
+            } else {
+                decoded = pipeline::decode(pipeline::fetch_index(instruction_memory, program_counter >> 2));
+            }
+            bool trap_happened;
+            if(trace::active()) {
+                trap_happened = execute_traced<T>(decoded, pipeline::fetch_index(instruction_memory, program_counter >> 2),
+                                                  registers, data_memory);
+            } else {
+                trap_happened = execute_decoded<T>(decoded, registers, data_memory);
+            }
+            result.retired++;
+
+            if(trap_happened && options.stop_on_trap) {
+                result.reason = STOP_TRAP;
+                break;
+            }
+            if(decoded.opcode == micro_op::SYSTEM_CALL && options.stop_on_system_call) {
+                result.reason = STOP_SYSTEM_CALL;
+                break;
+            }
+        }
+        return result;
+    }
+}
+
+run_result_t run(registers_t &registers, ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory,
+                 const run_options_t &options) {
+    if(options.blocks != nullptr && options.breakpoints.empty() && !options.has_exit_address &&
+       !options.stop_on_system_call && !trace::active()) {
+        run_result_t result;
+        result.retired = 0;
+        result.reason = STOP_BUDGET;
+        while(result.retired < options.max_instructions) {
+            bool trap_happened = false;
+            result.retired += options.blocks->execute(instruction_memory, registers, data_memory,
+                                                      options.max_instructions - result.retired, trap_happened);
+            if(trap_happened && options.stop_on_trap) {
+                result.reason = STOP_TRAP;
+                break;
+            }
+        }
+        return result;
+    }
+    return run_instructions<ppc_uint<32> *>(registers, instruction_memory, data_memory, options);
+}
+
+run_result_t run(registers_t &registers, ppc_uint<32> *instruction_memory, paged_memory &data_memory,
+                 const run_options_t &options) {
+    return run_instructions<paged_memory &>(registers, instruction_memory, data_memory, options);
+}
@@ -24,16 +24,61 @@
 #define __test_bench_utils__
 
 #include "registers.hpp"
-#include <ap_int.h>
+#include "decode_cache.hpp"
+#include "block_cache.hpp"
+#include "paged_memory.hpp"
+#include "ppc_int.hpp"
 #include <functional>
+#include <vector>
 
-int32_t read_byte_code(const char *file_name, ap_uint<32> *instruction_memory, uint32_t memory_size);
+// Loads a big endian program image and prepares it for fetching
+int32_t read_byte_code(const char *file_name, ppc_uint<32> *instruction_memory, uint32_t memory_size);
 
-int32_t read_data(const char *file_name, ap_uint<32> *data_memory, uint32_t memory_size);
+// Converts big endian instructions, which were copied into the instruction memory, to the order expected by the fetch
+void prepare_instructions(ppc_uint<32> *instruction_memory, uint32_t size);
 
-bool execute_single_instruction(ap_uint<32> instruction, registers_t &registers, ap_uint<32> *data_memory);
+int32_t read_data(const char *file_name, ppc_uint<32> *data_memory, uint32_t memory_size);
+
+bool execute_single_instruction(ppc_uint<32> instruction, registers_t &registers, ppc_uint<32> *data_memory);
+bool execute_single_instruction(ppc_uint<32> instruction, registers_t &registers, paged_memory &data_memory);
+
+bool execute_decoded_instruction(const micro_op_t &decoded, registers_t &registers, ppc_uint<32> *data_memory);
+bool execute_decoded_instruction(const micro_op_t &decoded, registers_t &registers, paged_memory &data_memory);
+
+// Same as execute_single_instruction, but fetches and decodes through the decode cache
+bool execute_cached_instruction(decode_cache &cache, ppc_uint<32> *instruction_memory, registers_t &registers,
+                                ppc_uint<32> *data_memory);
 
 typedef std::function<void(uint32_t)> trap_handler_t;
-void execute_program(ap_uint<32> *instruction_memory, uint32_t size, registers_t &registers, ap_uint<32> *data_memory, trap_handler_t trap_handler);
+// Executes the instructions 0 to size-1 in order, regardless of the program counter.
+// Used by the instruction tests, which check the program counter after branches instead of following them.
+void execute_program(ppc_uint<32> *instruction_memory, uint32_t size, registers_t &registers, ppc_uint<32> *data_memory, trap_handler_t trap_handler);
+
+typedef enum {STOP_BUDGET, STOP_TRAP, STOP_SYSTEM_CALL, STOP_BREAKPOINT, STOP_EXIT} stop_reason_t;
+
+typedef struct {
+    uint64_t max_instructions = 0; // Instruction budget
+    bool stop_on_trap = true;
+    bool stop_on_system_call = false; // Stops after the sc instruction
+    std::vector<uint32_t> breakpoints; // Stops before the instruction at one of these addresses, except the first one
+    bool has_exit_address = false;
+    uint32_t exit_address = 0; // Stops when the program counter reaches this address
+    // Optional caches, whole blocks are only executed without address based stop conditions and without a trace
+    block_cache *blocks = nullptr;
+    decode_cache *decoded = nullptr;
+} run_options_t;
+
+typedef struct {
+    uint64_t retired; // Number of retired instructions, including a trapping one
+    stop_reason_t reason;
+} run_result_t;
+
+// Executes instructions starting at the program counter and following it, until one of the stop conditions holds
+run_result_t run(registers_t &registers, ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory,
+                 const run_options_t &options);
+// Same on a sparse data memory. The block cache only executes on a flat data memory, so blocks are ignored and the
+// instructions are executed one at a time, through the decode cache if there is one.
+run_result_t run(registers_t &registers, ppc_uint<32> *instruction_memory, paged_memory &data_memory,
+                 const run_options_t &options);
 
 #endif
@@ -3,29 +3,41 @@
 #include "instruction_decode.hpp"
 #include "branch_processor.hpp"
 #include "pipeline.hpp"
-#include <ap_int.h>
+#include "micro_op.hpp"
+#include "macro_op_fusion.hpp"
+#include "ppc_int.hpp"
 
 static registers_t registers;
 
-void process(ap_uint<32> *instruction_memory, ap_uint<32> *data_memory) {
-    ap_uint<32> current_instruction = pipeline::instruction_fetch(instruction_memory, registers);
-	decode_result_t decoded = pipeline::decode(current_instruction);
-	if(decoded.branch_decode_result.execute == branch::BRANCH) {
+void process(ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory) {
+    ppc_uint<32> current_instruction = pipeline::instruction_fetch(instruction_memory, registers);
+	micro_op_t decoded = pipeline::decode(current_instruction);
+#if defined(MACRO_OP_FUSION) && !defined(__SYNTHESIS__)
+	// Software simulation only: execute the following instruction in the same step, if both can be fused.
+	// In hardware the second fetch and decode would lengthen every step, also for instructions, which are not fused.
+	ppc_uint<32> next_instruction = pipeline::fetch_index(instruction_memory, registers.program_counter(31, 2) + 1);
+	micro_op_t fused;
+	if(pipeline::fuse(decoded, pipeline::decode(next_instruction), fused)) {
+		decoded = fused;
+		// The program counter points to the second instruction, which might be a branch
+		registers.program_counter += 4;
+	}
+#endif
+	if(micro_op::is_branch(decoded)) {
 		// Extracting branch from the "pipeline" reduces the minimal execution time.
-		branch::branch(decoded.branch_decode_result.branch_decoded, registers);
+		pipeline::execute_branch(decoded, registers);
 	} else {
 		pipeline::execute(decoded, registers, data_memory);
 	}
 	registers.program_counter += 4;
 }
 
-void PowerPC(ap_uint<32> *instruction_memory, ap_uint<32> *data_memory) {
+void PowerPC(ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory) {
 #pragma HLS interface ap_ctrl_none port=return
 #pragma HLS interface m_axi port=instruction_memory
 #pragma HLS interface m_axi port=data_memory
 #pragma HLS ARRAY_PARTITION variable=registers.GPR complete dim=1
 #pragma HLS ARRAY_PARTITION variable=registers.FPR complete dim=1
-#pragma HLS ARRAY_PARTITION variable=registers.condition_reg.CR complete dim=1
 
 	registers.program_counter = 0;
 
@@ -0,0 +1,230 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "threaded_dispatch.hpp"
+#include "fixed_point_processor.hpp"
+#include "branch_processor.hpp"
+#include "micro_op.hpp"
+
+namespace {
+    bool execute_load(const micro_op_t &op, registers_t &registers, ppc_uint<32> *data_memory) {
+        fixed_point::load<ppc_uint<32> *>(micro_op::unpack_load_store(op), registers, data_memory);
+        return false;
+    }
+
+    bool execute_store(const micro_op_t &op, registers_t &registers, ppc_uint<32> *data_memory) {
+        fixed_point::store<ppc_uint<32> *>(micro_op::unpack_load_store(op), registers, data_memory);
+        return false;
+    }
+
+    bool execute_load_string(const micro_op_t &op, registers_t &registers, ppc_uint<32> *data_memory) {
+        fixed_point::load_string<ppc_uint<32> *>(micro_op::unpack_load_store(op), registers, data_memory);
+        return false;
+    }
+
+    bool execute_store_string(const micro_op_t &op, registers_t &registers, ppc_uint<32> *data_memory) {
+        fixed_point::store_string<ppc_uint<32> *>(micro_op::unpack_load_store(op), registers, data_memory);
+        return false;
+    }
+
+    bool execute_add_sub(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        fixed_point::add_sub(micro_op::unpack_add_sub(op), registers);
+        return false;
+    }
+
+    // add, addi and addis without carry, overflow or condition updates
+    bool execute_add_simple(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        ppc_uint<32> op1 = 0;
+        if(!(op.flags & micro_op::OP1_IMM)) {
+            op1 = registers.GPR[op.reg_a];
+        }
+        ppc_uint<32> op2;
+        if(op.flags & micro_op::OP2_IMM) {
+            op2 = op.immediate;
+        } else {
+            op2 = registers.GPR[op.reg_b];
+        }
+        registers.GPR[op.reg_c] = op1 + op2;
+        return false;
+    }
+
+    bool execute_multiply(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        fixed_point::multiply(micro_op::unpack_mul(op), registers);
+        return false;
+    }
+
+    bool execute_divide(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        fixed_point::divide(micro_op::unpack_div(op), registers);
+        return false;
+    }
+
+    bool execute_compare(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        fixed_point::compare(micro_op::unpack_cmp(op), registers);
+        return false;
+    }
+
+    bool execute_trap(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        return fixed_point::trap(micro_op::unpack_trap(op), registers);
+    }
+
+    bool execute_logical(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        fixed_point::logical(micro_op::unpack_log(op), registers);
+        return false;
+    }
+
+    inline ppc_uint<32> logical_op2(const micro_op_t &op, registers_t &registers) {
+        if(op.flags & micro_op::OP2_IMM) {
+            return op.immediate;
+        }
+        return registers.GPR[op.reg_b];
+    }
+
+    // and, or and xor without condition updates, this includes mr, ori, oris, xori and xoris
+    bool execute_logical_and(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        registers.GPR[op.reg_c] = registers.GPR[op.reg_a] & logical_op2(op, registers);
+        return false;
+    }
+
+    bool execute_logical_or(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        registers.GPR[op.reg_c] = registers.GPR[op.reg_a] | logical_op2(op, registers);
+        return false;
+    }
+
+    bool execute_logical_xor(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        registers.GPR[op.reg_c] = registers.GPR[op.reg_a] ^ logical_op2(op, registers);
+        return false;
+    }
+
+    bool execute_rotate(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        fixed_point::rotate(micro_op::unpack_rotate(op), registers);
+        return false;
+    }
+
+    bool execute_system(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        fixed_point::system(micro_op::unpack_system(op), registers);
+        return false;
+    }
+
+    bool execute_branch(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        branch::branch(micro_op::unpack_branch(op), registers);
+        registers.program_counter += 4;
+        return false;
+    }
+
+    bool execute_system_call(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        branch::system_call(micro_op::unpack_system_call(op), registers);
+        return false;
+    }
+
+    bool execute_condition(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        branch::condition(micro_op::unpack_condition(op), registers);
+        return false;
+    }
+
+    bool execute_fused_load_immediate(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        registers.GPR[op.reg_c] = op.immediate;
+        return false;
+    }
+
+    bool execute_fused_address_load(const micro_op_t &op, registers_t &registers, ppc_uint<32> *data_memory) {
+        fixed_point::add_sub(micro_op::unpack_fused_addis(op), registers);
+        fixed_point::load<ppc_uint<32> *>(micro_op::unpack_fused_load(op), registers, data_memory);
+        return false;
+    }
+
+    bool execute_fused_rotate_compare(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        fixed_point::rotate(micro_op::unpack_fused_rotate(op), registers);
+        fixed_point::compare(micro_op::unpack_fused_rotate_compare(op), registers);
+        return false;
+    }
+
+    bool execute_fused_compare_branch(const micro_op_t &op, registers_t &registers, ppc_uint<32> *) {
+        fixed_point::compare(micro_op::unpack_fused_branch_compare(op), registers);
+        branch::branch(micro_op::unpack_fused_branch(op), registers);
+        registers.program_counter += 4;
+        return false;
+    }
+
+    bool execute_none(const micro_op_t &, registers_t &, ppc_uint<32> *) {
+        return false;
+    }
+}
+
+threaded::handler_t threaded::select_handler(const micro_op_t &op) {
+    switch(op.opcode) {
+        case micro_op::LOAD:
+            return execute_load;
+        case micro_op::STORE:
+            return execute_store;
+        case micro_op::LOAD_STRING:
+            return execute_load_string;
+        case micro_op::STORE_STRING:
+            return execute_store_string;
+        case micro_op::ADD_SUB:
+            if(!(op.flags & (micro_op::ALTER_CR0 | micro_op::ALTER_OV | micro_op::ALTER_CA |
+                             micro_op::ADD_CA | micro_op::SUBTRACT))) {
+                return execute_add_simple;
+            }
+            return execute_add_sub;
+        case micro_op::MUL:
+            return execute_multiply;
+        case micro_op::DIV:
+            return execute_divide;
+        case micro_op::COMPARE:
+            return execute_compare;
+        case micro_op::TRAP:
+            return execute_trap;
+        case micro_op::LOGICAL:
+            if(!(op.flags & micro_op::ALTER_CR0)) {
+                switch(op.operation) {
+                    case logical::AND:
+                        return execute_logical_and;
+                    case logical::OR:
+                        return execute_logical_or;
+                    case logical::XOR:
+                        return execute_logical_xor;
+                    default:
+                        break;
+                }
+            }
+            return execute_logical;
+        case micro_op::ROTATE:
+            return execute_rotate;
+        case micro_op::SYSTEM:
+            return execute_system;
+        case micro_op::BRANCH:
+            return execute_branch;
+        case micro_op::SYSTEM_CALL:
+            return execute_system_call;
+        case micro_op::CONDITION:
+            return execute_condition;
+        case micro_op::FUSED_LOAD_IMMEDIATE:
+            return execute_fused_load_immediate;
+        case micro_op::FUSED_ADDRESS_LOAD:
+            return execute_fused_address_load;
+        case micro_op::FUSED_ROTATE_COMPARE:
+            return execute_fused_rotate_compare;
+        case micro_op::FUSED_COMPARE_BRANCH:
+            return execute_fused_compare_branch;
+        default:
+            return execute_none;
+    }
+}
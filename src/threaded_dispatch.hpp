@@ -0,0 +1,53 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_THREADED_DISPATCH_HPP
+#define POWERPC_HLS_THREADED_DISPATCH_HPP
+
+#include "ppc_int.hpp"
+#include "ppc_types.h"
+
+// Software simulation only!
+// Every translated instruction carries the address of its handler, so dispatching it is a single indirect call
+// instead of the switch in pipeline::execute followed by the switch inside of the unit.
+namespace threaded {
+    // Returns true, if a trap happened
+    typedef bool (*handler_t)(const micro_op_t &op, registers_t &registers, ppc_uint<32> *data_memory);
+
+    typedef struct {
+        handler_t handler;
+        micro_op_t op;
+    } threaded_op_t;
+
+    // Selects the handler for a decoded instruction, common simple forms get a specialised handler.
+    // Branch handlers need the program counter set to the address of the branch and advance it by themselves,
+    // all other handlers leave the program counter untouched.
+    handler_t select_handler(const micro_op_t &op);
+
+    inline threaded_op_t thread(const micro_op_t &op) {
+        threaded_op_t threaded_op;
+        threaded_op.handler = select_handler(op);
+        threaded_op.op = op;
+        return threaded_op;
+    }
+}
+
+#endif //POWERPC_HLS_THREADED_DISPATCH_HPP
@@ -0,0 +1,518 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "micro_op.hpp"
+#include "mmio.hpp"
+
+namespace {
+    const char MAGIC[8] = {'P', 'P', 'C', 'T', 'R', 'A', 'C', 'E'};
+    const uint8_t VERSION = 1;
+
+    // Minimum number of bytes, which the background thread writes at once while the trace is running
+    const size_t TRACE_WRITE_CHUNK = 1 << 20;
+
+    // Flags, PC, instruction, 32 GPRs, CR, XER, SPRs and up to 33 memory words of a stmw
+    const uint32_t MAX_RECORD_SIZE = 1 + 5 + 4 + 1 + 32*6 + 5 + 5 + 11 + 10 + 33*5;
+
+    inline void put_varint(uint8_t *&out, uint32_t value) {
+        while(value >= 0x80) {
+            *out++ = (uint8_t) (value | 0x80);
+            value >>= 7;
+        }
+        *out++ = (uint8_t) value;
+    }
+
+    inline void put_signed(uint8_t *&out, int32_t value) {
+        put_varint(out, ((uint32_t) value << 1) ^ (uint32_t) (value >> 31));
+    }
+
+    inline void put_word(uint8_t *&out, uint32_t value) {
+        for(uint32_t i = 0; i < 4; i++) {
+            *out++ = (uint8_t) (value >> (i*8));
+        }
+    }
+
+    void read_state(registers_t &registers, trace::state_t &state) {
+        state.PC = registers.program_counter;
+        for(uint32_t i = 0; i < 32; i++) {
+            state.GPR[i] = registers.GPR[i];
+        }
+        state.CR = registers.condition_reg.getCR();
+        state.XER = registers.fixed_exception_reg.getXER();
+        state.LR = registers.link_register;
+        state.CTR = registers.count_register;
+    }
+}
+
+// Encodes the records of one thread and passes them to the background thread through a single producer,
+// single consumer ring buffer
+class trace::writer {
+public:
+    writer(FILE *file, registers_t &registers, uint32_t buffer_size)
+            : buffer(buffer_size), write_chunk(std::min<size_t>(TRACE_WRITE_CHUNK, buffer_size/2)), head(0), tail(0),
+              cached_tail(0), stopping(false), file(file), slot_address(TRACE_INSTRUCTION_SLOTS, 0xFFFFFFFF),
+              slot_instruction(TRACE_INSTRUCTION_SLOTS, 0) {
+        read_state(registers, state);
+        next_program_counter = state.PC;
+        memory_address = 0;
+
+        uint8_t header[sizeof(MAGIC) + 1 + 37*4];
+        uint8_t *out = header;
+        memcpy(out, MAGIC, sizeof(MAGIC));
+        out += sizeof(MAGIC);
+        *out++ = VERSION;
+        put_word(out, state.PC);
+        for(uint32_t i = 0; i < 32; i++) {
+            put_word(out, state.GPR[i]);
+        }
+        put_word(out, state.CR);
+        put_word(out, state.XER);
+        put_word(out, state.LR);
+        put_word(out, state.CTR);
+        push(header, out - header);
+
+        thread = std::thread(&writer::drain, this);
+    }
+
+    ~writer() {
+        stopping.store(true, std::memory_order_release);
+        thread.join();
+        fclose(file);
+    }
+
+    // T is the type of the data memory like in fixed_point
+    template<typename T>
+    void record(uint32_t program_counter, uint32_t instruction, registers_t &registers, footprint_t footprint,
+                T data_memory, bool trap) {
+        uint8_t record[MAX_RECORD_SIZE];
+        uint8_t flags = 0;
+        uint8_t *out = record + 1;
+
+        if(program_counter != next_program_counter) {
+            flags |= TRACE_PC;
+            put_signed(out, (int32_t) (program_counter - next_program_counter));
+        }
+        next_program_counter = program_counter + 4;
+
+        uint32_t slot = (program_counter >> 2) & (TRACE_INSTRUCTION_SLOTS - 1);
+        if(slot_address[slot] != program_counter || slot_instruction[slot] != instruction) {
+            flags |= TRACE_INSTRUCTION;
+            for(int32_t i = 3; i >= 0; i--) {
+                *out++ = (uint8_t) (instruction >> (i*8));
+            }
+            slot_address[slot] = program_counter;
+            slot_instruction[slot] = instruction;
+        }
+
+        // Only the registers of the footprint can differ from the shadow
+        uint8_t *count = out++;
+        uint8_t changed = 0;
+        for(uint32_t candidates = footprint.GPRs; candidates != 0; candidates &= candidates - 1) {
+            uint32_t i = __builtin_ctz(candidates);
+            uint32_t value = registers.GPR[i];
+            if(value != state.GPR[i]) {
+                *out++ = (uint8_t) i;
+                put_signed(out, (int32_t) (value - state.GPR[i]));
+                state.GPR[i] = value;
+                changed++;
+            }
+        }
+        if(changed != 0) {
+            flags |= TRACE_GPR;
+            *count = changed;
+        } else {
+            out--;
+        }
+
+        uint32_t CR = registers.condition_reg.getCR();
+        if(CR != state.CR) {
+            flags |= TRACE_CR;
+            put_varint(out, CR ^ state.CR);
+            state.CR = CR;
+        }
+        uint32_t XER = registers.fixed_exception_reg.getXER();
+        if(XER != state.XER) {
+            flags |= TRACE_XER;
+            put_varint(out, XER ^ state.XER);
+            state.XER = XER;
+        }
+
+        uint32_t LR = registers.link_register;
+        uint32_t CTR = registers.count_register;
+        if(LR != state.LR || CTR != state.CTR) {
+            flags |= TRACE_SPR;
+            *out++ = (LR != state.LR ? 1 : 0) | (CTR != state.CTR ? 2 : 0);
+            if(LR != state.LR) {
+                put_signed(out, (int32_t) (LR - state.LR));
+                state.LR = LR;
+            }
+            if(CTR != state.CTR) {
+                put_signed(out, (int32_t) (CTR - state.CTR));
+                state.CTR = CTR;
+            }
+        }
+
+        if(footprint.store_words != 0) {
+            flags |= TRACE_MEMORY;
+            put_varint(out, footprint.store_words);
+            put_signed(out, (int32_t) (footprint.store_address - memory_address) >> 2);
+            for(uint32_t i = 0; i < footprint.store_words; i++) {
+                put_varint(out, __builtin_bswap32((uint32_t) data_memory[(footprint.store_address >> 2) + i]));
+            }
+            memory_address = footprint.store_address + footprint.store_words*4;
+        }
+
+        if(trap) {
+            flags |= TRACE_TRAP;
+        }
+
+        record[0] = flags;
+        push(record, out - record);
+    }
+
+private:
+    void push(const uint8_t *data, size_t size) {
+        size_t position = head.load(std::memory_order_relaxed);
+        while(position + size - cached_tail > buffer.size()) {
+            // The writer thread is behind, wait for free space
+            cached_tail = tail.load(std::memory_order_acquire);
+            if(position + size - cached_tail > buffer.size()) {
+                std::this_thread::yield();
+            }
+        }
+        size_t offset = position & (buffer.size() - 1);
+        size_t first = std::min<size_t>(size, buffer.size() - offset);
+        memcpy(&buffer[offset], data, first);
+        memcpy(&buffer[0], data + first, size - first);
+        head.store(position + size, std::memory_order_release);
+    }
+
+    // Runs on the background thread until the trace is stopped and all records are written
+    void drain() {
+        size_t position = tail.load(std::memory_order_relaxed);
+        while(true) {
+            size_t end = head.load(std::memory_order_acquire);
+            // Write large chunks, so the thread mostly sleeps and takes few system calls
+            if(end - position < write_chunk) {
+                if(!stopping.load(std::memory_order_acquire)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                end = head.load(std::memory_order_acquire);
+                if(end == position) {
+                    break;
+                }
+            }
+            size_t offset = position & (buffer.size() - 1);
+            size_t size = std::min<size_t>(end - position, buffer.size() - offset);
+            fwrite(&buffer[offset], 1, size, file);
+            position += size;
+            tail.store(position, std::memory_order_release);
+        }
+        fflush(file);
+    }
+
+    std::vector<uint8_t> buffer;
+    size_t write_chunk; // Smaller buffers are written in halves, so the simulation never waits for a full buffer
+    alignas(64) std::atomic<size_t> head; // Written by the simulation
+    alignas(64) std::atomic<size_t> tail; // Written by the background thread
+    alignas(64) size_t cached_tail;
+    std::atomic<bool> stopping;
+    FILE *file;
+    std::thread thread;
+
+    // Encoder state, the reader keeps the same state while decoding
+    state_t state;
+    uint32_t next_program_counter;
+    uint32_t memory_address;
+    std::vector<uint32_t> slot_address;
+    std::vector<uint32_t> slot_instruction;
+};
+
+thread_local trace::writer *trace::current = nullptr;
+
+bool trace::start(const char *file_name, registers_t &registers, uint32_t buffer_size) {
+    stop();
+    FILE *file = fopen(file_name, "wb");
+    if(file == nullptr) {
+        return false;
+    }
+    current = new writer(file, registers, buffer_size);
+    return true;
+}
+
+void trace::stop() {
+    delete current;
+    current = nullptr;
+}
+
+trace::footprint_t trace::footprint(const micro_op_t &decoded, registers_t &registers) {
+    footprint_t footprint = {0, 0, 0};
+    uint32_t ea_target = (decoded.flags & micro_op::WRITE_EA) ? 1u << decoded.reg_d : 0;
+    switch(decoded.opcode) {
+        case micro_op::ADD_SUB:
+        case micro_op::MUL:
+        case micro_op::DIV:
+        case micro_op::LOGICAL:
+        case micro_op::ROTATE:
+            footprint.GPRs = 1u << decoded.reg_c;
+            return footprint;
+        case micro_op::COMPARE:
+        case micro_op::TRAP:
+        case micro_op::BRANCH:
+        case micro_op::CONDITION:
+            return footprint;
+        case micro_op::LOAD:
+            footprint.GPRs = ((decoded.flags & micro_op::MULTIPLE) ? 0xFFFFFFFF << decoded.reg_c : 1u << decoded.reg_c) |
+                             ea_target;
+            return footprint;
+        case micro_op::STORE:
+            footprint.GPRs = ea_target;
+            break;
+        case micro_op::STORE_STRING:
+            break;
+        default:
+            // String loads wrap around the register file, everything else is checked completely
+            footprint.GPRs = 0xFFFFFFFF;
+            return footprint;
+    }
+
+    uint32_t sum1 = (decoded.flags & micro_op::SUM1_IMM) ? 0 : (uint32_t) registers.GPR[decoded.reg_a];
+    uint32_t sum2 = (decoded.flags & micro_op::SUM2_IMM) ? decoded.immediate : (uint32_t) registers.GPR[decoded.reg_b];
+    uint32_t bytes;
+    if(decoded.opcode == micro_op::STORE_STRING) {
+        if(decoded.flags & micro_op::SUM2_IMM) {
+            // stswi, NB = 0 stores 32 bytes
+            bytes = decoded.reg_b == 0 ? 32 : decoded.reg_b;
+        } else {
+            bytes = registers.fixed_exception_reg.exception_fields.string_bytes;
+        }
+    } else if(decoded.flags & micro_op::MULTIPLE) {
+        bytes = 4*(32 - decoded.reg_c);
+    } else {
+        bytes = decoded.field_a + 1;
+    }
+
+    uint32_t address = sum1 + sum2;
+    if(bytes != 0 && !mmio::overlaps(address, bytes)) {
+        footprint.store_address = address & ~3u;
+        footprint.store_words = ((address + bytes - 1) >> 2) - (address >> 2) + 1;
+    }
+    return footprint;
+}
+
+void trace::record(uint32_t program_counter, uint32_t instruction, registers_t &registers, footprint_t footprint,
+                   ppc_uint<32> *data_memory, bool trap) {
+    current->record<ppc_uint<32> *>(program_counter, instruction, registers, footprint, data_memory, trap);
+}
+
+void trace::record(uint32_t program_counter, uint32_t instruction, registers_t &registers, footprint_t footprint,
+                   paged_memory &data_memory, bool trap) {
+    current->record<paged_memory &>(program_counter, instruction, registers, footprint, data_memory, trap);
+}
+
+trace::reader::~reader() {
+    if(file != nullptr) {
+        fclose(file);
+    }
+}
+
+bool trace::reader::open(const char *file_name) {
+    file = fopen(file_name, "rb");
+    if(file == nullptr) {
+        return false;
+    }
+
+    char magic[sizeof(MAGIC)];
+    uint8_t version;
+    if(fread(magic, 1, sizeof(MAGIC), file) != sizeof(MAGIC) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+       !read_byte(version) || version != VERSION) {
+        return false;
+    }
+
+    uint32_t words[37];
+    for(uint32_t &word : words) {
+        uint8_t bytes[4];
+        if(fread(bytes, 1, 4, file) != 4) {
+            return false;
+        }
+        word = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+    }
+    initial.PC = words[0];
+    memcpy(initial.GPR, &words[1], sizeof(initial.GPR));
+    initial.CR = words[33];
+    initial.XER = words[34];
+    initial.LR = words[35];
+    initial.CTR = words[36];
+
+    state = initial;
+    next_program_counter = initial.PC;
+    memory_address = 0;
+    slot_address.assign(TRACE_INSTRUCTION_SLOTS, 0xFFFFFFFF);
+    slot_instruction.assign(TRACE_INSTRUCTION_SLOTS, 0);
+    return true;
+}
+
+bool trace::reader::next(record_t &record) {
+    uint8_t flags;
+    if(file == nullptr || !read_byte(flags)) {
+        return false;
+    }
+
+    record.program_counter = next_program_counter;
+    if(flags & TRACE_PC) {
+        int32_t difference;
+        if(!read_signed(difference)) {
+            return false;
+        }
+        record.program_counter += difference;
+    }
+    next_program_counter = record.program_counter + 4;
+
+    uint32_t slot = (record.program_counter >> 2) & (TRACE_INSTRUCTION_SLOTS - 1);
+    if(flags & TRACE_INSTRUCTION) {
+        uint32_t instruction = 0;
+        for(uint32_t i = 0; i < 4; i++) {
+            uint8_t byte;
+            if(!read_byte(byte)) {
+                return false;
+            }
+            instruction = (instruction << 8) | byte;
+        }
+        slot_address[slot] = record.program_counter;
+        slot_instruction[slot] = instruction;
+    }
+    record.instruction = slot_instruction[slot];
+
+    record.changed_GPRs = 0;
+    if(flags & TRACE_GPR) {
+        uint8_t count;
+        if(!read_byte(count)) {
+            return false;
+        }
+        for(uint32_t i = 0; i < count; i++) {
+            uint8_t index;
+            int32_t difference;
+            if(!read_byte(index) || index >= 32 || !read_signed(difference)) {
+                return false;
+            }
+            state.GPR[index] += difference;
+            record.changed_GPRs |= 1u << index;
+        }
+    }
+
+    uint32_t difference;
+    if(flags & TRACE_CR) {
+        if(!read_varint(difference)) {
+            return false;
+        }
+        state.CR ^= difference;
+    }
+    if(flags & TRACE_XER) {
+        if(!read_varint(difference)) {
+            return false;
+        }
+        state.XER ^= difference;
+    }
+
+    if(flags & TRACE_SPR) {
+        uint8_t changed;
+        int32_t delta;
+        if(!read_byte(changed)) {
+            return false;
+        }
+        if(changed & 1) {
+            if(!read_signed(delta)) {
+                return false;
+            }
+            state.LR += delta;
+        }
+        if(changed & 2) {
+            if(!read_signed(delta)) {
+                return false;
+            }
+            state.CTR += delta;
+        }
+    }
+
+    record.memory_address = 0;
+    record.memory_words.clear();
+    if(flags & TRACE_MEMORY) {
+        uint32_t words;
+        int32_t delta;
+        if(!read_varint(words) || !read_signed(delta)) {
+            return false;
+        }
+        record.memory_address = memory_address + delta*4;
+        for(uint32_t i = 0; i < words; i++) {
+            uint32_t word;
+            if(!read_varint(word)) {
+                return false;
+            }
+            record.memory_words.push_back(word);
+        }
+        memory_address = record.memory_address + words*4;
+    }
+
+    record.trap = flags & TRACE_TRAP;
+    state.PC = record.program_counter;
+    record.state = state;
+    return true;
+}
+
+bool trace::reader::read_byte(uint8_t &value) {
+    int c = getc(file);
+    if(c == EOF) {
+        return false;
+    }
+    value = (uint8_t) c;
+    return true;
+}
+
+bool trace::reader::read_varint(uint32_t &value) {
+    value = 0;
+    for(uint32_t shift = 0; shift < 35; shift += 7) {
+        uint8_t byte;
+        if(!read_byte(byte)) {
+            return false;
+        }
+        value |= (uint32_t) (byte & 0x7F) << shift;
+        if(!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool trace::reader::read_signed(int32_t &value) {
+    uint32_t zigzag;
+    if(!read_varint(zigzag)) {
+        return false;
+    }
+    value = (int32_t) ((zigzag >> 1) ^ -(zigzag & 1));
+    return true;
+}
@@ -0,0 +1,144 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_TRACE_HPP
+#define POWERPC_HLS_TRACE_HPP
+
+#include <stdint.h>
+#include <cstdio>
+#include <vector>
+#include "ppc_int.hpp"
+#include "ppc_types.h"
+#include "paged_memory.hpp"
+
+// Software simulation only!
+// Compact binary execution trace. While a trace is active on a thread, execute_single_instruction,
+// execute_cached_instruction and run() record every instruction of this thread (run() single steps while tracing).
+// Records are delta encoded against the previous state and passed through a lock-free ring buffer to a background
+// thread, which writes them to the file.
+//
+// File format, all varints are unsigned LEB128, signed deltas are zigzag encoded:
+//   "PPCTRACE", version byte, initial state as 37 little endian words: PC, GPR 0 to 31, CR, XER, LR, CTR
+//   One record per instruction: flags byte, followed by the fields of the set flags in this order
+//     TRACE_PC           Address differs from the previous address + 4: signed varint of the difference
+//     TRACE_INSTRUCTION  Instruction word differs from the last one seen at this address (see TRACE_INSTRUCTION_SLOTS):
+//                        big endian word
+//     TRACE_GPR          Number of changed registers, then per register its index and the signed varint of new - old
+//     TRACE_CR           Varint of new CR ^ old CR
+//     TRACE_XER          Varint of new XER ^ old XER
+//     TRACE_SPR          Byte with bit 0 for LR and bit 1 for CTR, then the signed varint of new - old per register
+//     TRACE_MEMORY       Varint word count, signed varint of the first word address - last memory address, then
+//                        the varint of every word in big endian order, as seen by lwz
+//     TRACE_TRAP         The instruction trapped
+// Memory effects are the words written by stores. Stores to mmio devices are not part of the trace.
+namespace trace {
+    const uint8_t TRACE_PC = 1 << 0;
+    const uint8_t TRACE_INSTRUCTION = 1 << 1;
+    const uint8_t TRACE_GPR = 1 << 2;
+    const uint8_t TRACE_CR = 1 << 3;
+    const uint8_t TRACE_XER = 1 << 4;
+    const uint8_t TRACE_SPR = 1 << 5;
+    const uint8_t TRACE_MEMORY = 1 << 6;
+    const uint8_t TRACE_TRAP = 1 << 7;
+
+    // Number of addresses, whose last instruction word is known to writer and reader, has to be a power of two
+    const uint32_t TRACE_INSTRUCTION_SLOTS = 4096;
+
+    // Default number of bytes between the simulation and the writer thread, has to be a power of two
+    const uint32_t TRACE_BUFFER_SIZE = 1 << 24;
+
+    // Shadow of the traced registers
+    typedef struct {
+        uint32_t PC;
+        uint32_t GPR[32];
+        uint32_t CR;
+        uint32_t XER;
+        uint32_t LR;
+        uint32_t CTR;
+    } state_t;
+
+    // Registers and memory words, which an instruction can write
+    typedef struct {
+        uint32_t GPRs; // Bit i is set if GPR i can be written
+        uint32_t store_address; // Word aligned
+        uint32_t store_words;
+    } footprint_t;
+
+    class writer;
+    extern thread_local writer *current;
+
+    // Starts tracing this thread into the file with the current state of the registers,
+    // returns false if the file can't be created.
+    // The buffer size has to be a power of two, which holds at least one record (see MAX_RECORD_SIZE in trace.cpp).
+    bool start(const char *file_name, registers_t &registers, uint32_t buffer_size = TRACE_BUFFER_SIZE);
+    // Writes the remaining records and closes the file
+    void stop();
+
+    inline bool active() {
+        return current != nullptr;
+    }
+
+    // Footprint of the decoded instruction, has to be called before executing it
+    footprint_t footprint(const micro_op_t &decoded, registers_t &registers);
+
+    // Records an executed instruction. program_counter is its address, registers hold the state after it.
+    void record(uint32_t program_counter, uint32_t instruction, registers_t &registers, footprint_t footprint,
+                ppc_uint<32> *data_memory, bool trap);
+    void record(uint32_t program_counter, uint32_t instruction, registers_t &registers, footprint_t footprint,
+                paged_memory &data_memory, bool trap);
+
+    typedef struct {
+        uint32_t program_counter;
+        uint32_t instruction;
+        bool trap;
+        uint32_t changed_GPRs; // Bit i is set if GPR i was written with a new value
+        state_t state; // State after the instruction, the PC holds the address of the instruction
+        uint32_t memory_address;
+        std::vector<uint32_t> memory_words;
+    } record_t;
+
+    class reader {
+    public:
+        ~reader();
+
+        bool open(const char *file_name);
+        const state_t &initial_state() const {
+            return initial;
+        }
+        // Returns false at the end of the trace
+        bool next(record_t &record);
+
+    private:
+        bool read_byte(uint8_t &value);
+        bool read_varint(uint32_t &value);
+        bool read_signed(int32_t &value);
+
+        FILE *file = nullptr;
+        state_t initial;
+        state_t state;
+        uint32_t next_program_counter;
+        uint32_t memory_address;
+        std::vector<uint32_t> slot_address;
+        std::vector<uint32_t> slot_instruction;
+    };
+}
+
+#endif //POWERPC_HLS_TRACE_HPP
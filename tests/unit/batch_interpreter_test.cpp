@@ -0,0 +1,95 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+
+#include <catch.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "batch_interpreter.hpp"
+#include "corpus.hpp"
+
+namespace {
+    // Runs every lane on its own with single stepping and all lanes together with run_batched, which has to reach
+    // the same stop reason, registers and memory in every lane
+    void check_lanes(const corpus::program_t &program, const std::vector<registers_t> &lanes) {
+        static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+        static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+        registers_t initial;
+        corpus::load(program, i_mem, d_mem, initial);
+        std::vector<ppc_uint<32>> initial_memory(d_mem, d_mem + CORPUS_D_MEM_SIZE);
+
+        std::vector<simulation_instance_t> instances(lanes.size());
+        std::vector<registers_t> expected(lanes);
+        std::vector<std::vector<ppc_uint<32>>> expected_memory(lanes.size(), initial_memory);
+        std::vector<run_result_t> references(lanes.size());
+        uint64_t max_instructions = 0;
+        for(size_t l = 0; l < lanes.size(); l++) {
+            instances[l].registers = lanes[l];
+            instances[l].data_memory = initial_memory;
+            references[l] = corpus::single_step(program, i_mem, expected[l], expected_memory[l].data());
+            max_instructions = std::max(max_instructions, references[l].retired);
+        }
+
+        INFO("Program " + program.name);
+        // Lanes leaving the program continue with the branch to itself behind it, only the budget stops them there
+        for(const run_result_t &reference : references) {
+            REQUIRE((reference.reason == STOP_TRAP || reference.retired == max_instructions));
+        }
+
+        run_options_t options;
+        options.max_instructions = max_instructions;
+        runner_summary_t summary = run_batched(i_mem, instances, options);
+
+        uint64_t total = 0;
+        for(size_t l = 0; l < lanes.size(); l++) {
+            INFO("Lane " + std::to_string(l));
+            REQUIRE(instances[l].result.retired == references[l].retired);
+            REQUIRE(instances[l].result.reason == references[l].reason);
+            REQUIRE(corpus::same_registers(instances[l].registers, expected[l]));
+            REQUIRE(corpus::same_memory(instances[l].data_memory.data(), expected_memory[l].data(),
+                                        CORPUS_D_MEM_SIZE));
+            total += references[l].retired;
+        }
+        REQUIRE(summary.instances == lanes.size());
+        REQUIRE(summary.retired == total);
+    }
+}
+
+// A full group and a partly filled one behind two full groups
+TEST_CASE("Batch interpreter matches single stepping on the corpus", "[batch interpreter]") {
+    for(uint32_t count : {BATCH_LANES, 2*BATCH_LANES + 3}) {
+        for(const corpus::program_t &program : corpus::programs()) {
+            check_lanes(program, std::vector<registers_t>(count, program.registers));
+        }
+    }
+}
+
+// The lanes iterate a different number of times, so they take different branch paths and rejoin behind the loop
+TEST_CASE("Batch interpreter lanes on different paths", "[batch interpreter]") {
+    corpus::program_t program = corpus::assemble("diverging loop", "li 4, 1\n"
+                                                                   "loop: mullw 4, 4, 3\naddi 3, 3, -1\n"
+                                                                   "cmpwi 3, 0\nbgt loop\n"
+                                                                   "stw 4, 8(0)\nli 5, 0\ntweqi 5, 0");
+    std::vector<registers_t> lanes(2*BATCH_LANES + 3, program.registers);
+    for(size_t l = 0; l < lanes.size(); l++) {
+        lanes[l].GPR[3] = l % 7;
+    }
+    check_lanes(program, lanes);
+}
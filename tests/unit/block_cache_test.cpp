@@ -0,0 +1,126 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include <catch.hpp>
+#include "block_cache.hpp"
+#include "pipeline.hpp"
+#include "corpus.hpp"
+
+// The JIT is disabled, so these tests cover the translated blocks and the threaded handlers
+TEST_CASE("Block cache matches single stepping on the corpus", "[block cache]") {
+    block_cache blocks(CORPUS_I_MEM_SIZE, 0);
+    for(const corpus::program_t &program : corpus::programs()) {
+        corpus::check_blocks(program, blocks, 2);
+    }
+}
+
+TEST_CASE("Block cache branches", "[block cache]") {
+    block_cache blocks(CORPUS_I_MEM_SIZE, 0);
+
+    SECTION("Counted loop") {
+        corpus::check_blocks(corpus::assemble("counted loop",
+                "li 3, 0\nli 4, 100\nmtctr 4\n"
+                "loop: addi 3, 3, 2\nbdnz loop\n"
+                "addi 3, 3, 1"), blocks);
+    }
+
+    SECTION("Taken and not taken conditional branches") {
+        corpus::check_blocks(corpus::assemble("conditional branches",
+                "li 3, 0\nli 5, 0\n"
+                "loop: addi 3, 3, 1\nandi. 4, 3, 1\nbeq even\n"
+                "addi 5, 5, 3\nb next\n"
+                "even: addi 5, 5, 7\n"
+                "next: cmpwi 3, 50\nblt loop\n"
+                "mflr 6\nbl call\nb end\n"
+                "call: addi 5, 5, 1\nblr\n"
+                "end: mtlr 6"), blocks);
+    }
+}
+
+TEST_CASE("Block cache invalidation", "[block cache]") {
+    block_cache blocks(CORPUS_I_MEM_SIZE, 0);
+    corpus::program_t program = corpus::assemble("loop", "li 3, 0\nli 4, 10\nmtctr 4\n"
+                                                         "loop: addi 3, 3, 2\nbdnz loop");
+    corpus::program_t patched = corpus::assemble("patched loop", "li 3, 0\nli 4, 10\nmtctr 4\n"
+                                                                 "loop: addi 3, 3, 5\nbdnz loop");
+    static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+    registers_t registers;
+    run_options_t options;
+    options.max_instructions = 23;
+    options.blocks = &blocks;
+
+    corpus::load(program, i_mem, d_mem, registers);
+    run(registers, i_mem, d_mem, options);
+    REQUIRE((uint32_t) registers.GPR[3] == 20);
+
+    // Patch the loop body in place, like a store into the instruction memory, and announce it to the cache
+    i_mem[3] = pipeline::swap_endianness(patched.code[3]);
+    prepare_instructions(i_mem + 3, 1);
+    blocks.invalidate_range(12, 4);
+    registers = program.registers;
+    run(registers, i_mem, d_mem, options);
+    REQUIRE((uint32_t) registers.GPR[3] == 50);
+
+    corpus::check_blocks(patched, blocks);
+}
+
+TEST_CASE("Block cache traps", "[block cache]") {
+    block_cache blocks(CORPUS_I_MEM_SIZE, 0);
+    corpus::check_blocks(corpus::assemble("trap in block", "li 3, 1\nli 4, 2\ntweqi 3, 1\nli 5, 3"), blocks);
+    corpus::check_blocks(corpus::assemble("trap in loop", "li 3, 0\n"
+                                                          "loop: addi 3, 3, 1\ntwgei 3, 7\nb loop"), blocks);
+}
+
+TEST_CASE("Block cache idle loops", "[block cache]") {
+    // The loop at address 4 compares without changing any state, until an interrupt would change r3
+    corpus::program_t program = corpus::assemble("idle loop", "li 3, 5\n"
+                                                              "loop: cmpwi 3, 0\nbne loop");
+    static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+    static ppc_uint<32> expected_memory[CORPUS_D_MEM_SIZE];
+    block_cache blocks(CORPUS_I_MEM_SIZE, 0);
+
+    // Budgets, which end behind the compare and behind the branch
+    for(uint64_t budget : {10001, 10002}) {
+        registers_t expected, registers;
+        corpus::load(program, i_mem, expected_memory, expected);
+        run_result_t reference = corpus::single_step(program, i_mem, expected, expected_memory, budget);
+        REQUIRE(reference.retired == budget);
+
+        blocks.invalidate_all();
+        corpus::load(program, i_mem, d_mem, registers);
+        run_options_t options;
+        options.max_instructions = budget;
+        options.blocks = &blocks;
+        run_result_t result = run(registers, i_mem, d_mem, options);
+        REQUIRE(result.retired == budget);
+        REQUIRE(corpus::same_registers(registers, expected));
+
+        // Executing a trillion instructions one by one would not finish, the fast-forward ends in the same state
+        blocks.invalidate_all();
+        corpus::load(program, i_mem, d_mem, registers);
+        options.max_instructions = budget + 1000000000000;
+        result = run(registers, i_mem, d_mem, options);
+        REQUIRE(result.retired == options.max_instructions);
+        REQUIRE(corpus::same_registers(registers, expected));
+    }
+}
@@ -0,0 +1,228 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include "corpus.hpp"
+#include <catch.hpp>
+#include <json.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "assembler.hpp"
+#include "pipeline.hpp"
+
+namespace {
+    // "Before" registers, CR and XER are given as a number or as single bits
+    registers_t initial_registers(nlohmann::json before) {
+        registers_t registers = {};
+        registers.condition_reg = 0;
+        registers.fixed_exception_reg = 0;
+
+        auto GPR = before["GPR"];
+        if(!GPR.is_null()) {
+            for(uint32_t i = 0; i < 32; i++) {
+                if(!GPR[std::to_string(i)].is_null()) {
+                    registers.GPR[i] = GPR[std::to_string(i)].get<int32_t>();
+                }
+            }
+        }
+
+        auto CR = before["CR"];
+        if(CR.is_object()) {
+            for(uint32_t i = 0; i < 8; i++) {
+                auto CR_i = CR["CR" + std::to_string(i)];
+                if(CR_i.is_object()) {
+                    uint32_t field = 0;
+                    field |= CR_i["LT"].is_boolean() && CR_i["LT"].get<bool>() ? CR_LT : 0;
+                    field |= CR_i["GT"].is_boolean() && CR_i["GT"].get<bool>() ? CR_GT : 0;
+                    field |= CR_i["EQ"].is_boolean() && CR_i["EQ"].get<bool>() ? CR_EQ : 0;
+                    field |= CR_i["SO"].is_boolean() && CR_i["SO"].get<bool>() ? CR_SO : 0;
+                    registers.condition_reg.set_field(i, field);
+                }
+            }
+        } else if(!CR.is_null()) {
+            registers.condition_reg = CR.get<uint32_t>();
+        }
+
+        auto XER = before["XER"];
+        if(XER.is_object()) {
+            if(XER["SO"].is_boolean()) {
+                registers.fixed_exception_reg.exception_fields.SO = XER["SO"].get<bool>();
+            }
+            if(XER["OV"].is_boolean()) {
+                registers.fixed_exception_reg.exception_fields.OV = XER["OV"].get<bool>();
+            }
+            if(XER["CA"].is_boolean()) {
+                registers.fixed_exception_reg.exception_fields.CA = XER["CA"].get<bool>();
+            }
+            if(XER["String_Bytes"].is_number()) {
+                registers.fixed_exception_reg.exception_fields.string_bytes = XER["String_Bytes"].get<uint8_t>();
+            }
+        } else if(!XER.is_null()) {
+            registers.fixed_exception_reg = XER.get<uint32_t>();
+        }
+
+        if(!before["LR"].is_null()) {
+            registers.link_register = before["LR"].get<uint32_t>();
+        }
+        if(!before["CTR"].is_null()) {
+            registers.count_register = before["CTR"].get<uint32_t>();
+        }
+        if(!before["PC"].is_null()) {
+            registers.program_counter = before["PC"].get<uint32_t>();
+        }
+        return registers;
+    }
+
+    corpus::program_t read_program(const std::filesystem::path &file) {
+        std::ifstream input(file);
+        nlohmann::json config;
+        input >> config;
+
+        corpus::program_t program;
+        program.name = file.string();
+        std::string error;
+        if(!assembler::assemble(config["Assembly"].get<std::string>(), program.code, error)) {
+            throw std::runtime_error("Error while assembling the code of file " + program.name + ": " + error);
+        }
+
+        auto before = config["Before"];
+        program.registers = initial_registers(before);
+        // The data is given per word in register order, the memory holds the first byte in the lowest bits
+        auto data = before["Data"];
+        if(!data.is_null()) {
+            for(uint32_t i = 0; i < CORPUS_D_MEM_SIZE; i++) {
+                if(!data[std::to_string(i*4)].is_null()) {
+                    program.data.push_back({i, __builtin_bswap32(data[std::to_string(i*4)].get<int32_t>())});
+                }
+            }
+        }
+        return program;
+    }
+}
+
+const std::vector<corpus::program_t> &corpus::programs() {
+    static std::vector<program_t> programs;
+    if(programs.empty()) {
+        std::vector<std::filesystem::path> files;
+        for(const auto &entry : std::filesystem::recursive_directory_iterator(CORPUS_PATH)) {
+            if(entry.path().extension() == ".json") {
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        for(const auto &file : files) {
+            programs.push_back(read_program(file));
+        }
+    }
+    return programs;
+}
+
+corpus::program_t corpus::assemble(const std::string &name, const std::string &source) {
+    program_t program;
+    program.name = name;
+    std::string error;
+    if(!assembler::assemble(source, program.code, error)) {
+        throw std::runtime_error("Error while assembling " + name + ": " + error);
+    }
+    program.registers = initial_registers(nlohmann::json::object());
+    return program;
+}
+
+void corpus::load(const program_t &program, ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory,
+                  registers_t &registers) {
+    // The instruction memory holds big endian words like a loaded binary
+    for(uint32_t i = 0; i < CORPUS_I_MEM_SIZE; i++) {
+        instruction_memory[i] = pipeline::swap_endianness(i < program.code.size() ? program.code[i] : 0x48000000);
+    }
+    prepare_instructions(instruction_memory, CORPUS_I_MEM_SIZE);
+
+    for(uint32_t i = 0; i < CORPUS_D_MEM_SIZE; i++) {
+        data_memory[i] = 0;
+    }
+    for(const auto &word : program.data) {
+        data_memory[word.first] = word.second;
+    }
+    registers = program.registers;
+}
+
+run_result_t corpus::single_step(const program_t &program, ppc_uint<32> *instruction_memory, registers_t &registers,
+                                 ppc_uint<32> *data_memory, uint64_t max_instructions) {
+    run_options_t options;
+    options.max_instructions = 1;
+    run_result_t result = {0, STOP_BUDGET};
+    while(result.retired < max_instructions && (uint32_t) registers.program_counter < 4*program.code.size()) {
+        run_result_t step = run(registers, instruction_memory, data_memory, options);
+        result.retired += step.retired;
+        if(step.reason == STOP_TRAP) {
+            result.reason = STOP_TRAP;
+            break;
+        }
+    }
+    return result;
+}
+
+bool corpus::same_registers(registers_t &a, registers_t &b) {
+    for(uint32_t i = 0; i < 32; i++) {
+        if(a.GPR[i] != b.GPR[i] || a.FPR[i] != b.FPR[i]) {
+            return false;
+        }
+    }
+    return a.condition_reg.getCR() == b.condition_reg.getCR() &&
+           a.fixed_exception_reg.getXER() == b.fixed_exception_reg.getXER() &&
+           a.link_register == b.link_register && a.count_register == b.count_register &&
+           a.program_counter == b.program_counter;
+}
+
+bool corpus::same_memory(const ppc_uint<32> *a, const ppc_uint<32> *b, uint32_t size) {
+    for(uint32_t i = 0; i < size; i++) {
+        if(a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void corpus::check_blocks(const program_t &program, block_cache &blocks, uint32_t runs) {
+    static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+    static ppc_uint<32> expected_memory[CORPUS_D_MEM_SIZE];
+    registers_t expected, registers;
+
+    load(program, i_mem, expected_memory, expected);
+    run_result_t reference = single_step(program, i_mem, expected, expected_memory);
+
+    INFO("Program " + program.name);
+    blocks.invalidate_all();
+    for(uint32_t i = 0; i < runs; i++) {
+        load(program, i_mem, d_mem, registers);
+        run_options_t options;
+        options.max_instructions = reference.retired;
+        options.blocks = &blocks;
+        run_result_t result = run(registers, i_mem, d_mem, options);
+
+        INFO("Run " + std::to_string(i));
+        REQUIRE(result.retired == reference.retired);
+        REQUIRE(result.reason == reference.reason);
+        REQUIRE(same_registers(registers, expected));
+        REQUIRE(same_memory(d_mem, expected_memory, CORPUS_D_MEM_SIZE));
+    }
+}
@@ -0,0 +1,72 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef POWERPC_HLS_CORPUS_HPP
+#define POWERPC_HLS_CORPUS_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "registers.hpp"
+#include "test_bench_utils.hpp"
+
+// Memory sizes in words, the same as for the instruction tests
+#define CORPUS_I_MEM_SIZE 1024
+#define CORPUS_D_MEM_SIZE 1024
+
+// Programs of the JSON instruction tests, used to compare the execution engines with single stepping.
+// The instruction tests execute the instructions in order, while the engines follow the program counter, so only the
+// registers and memory of the "Before" field are used and the reference is computed by single stepping.
+namespace corpus {
+    typedef struct {
+        std::string name;
+        std::vector<uint32_t> code; // Host order instructions
+        registers_t registers;
+        std::vector<std::pair<uint32_t, uint32_t>> data; // Word index and memory word
+    } program_t;
+
+    // Reads and assembles all programs below CORPUS_PATH once
+    const std::vector<program_t> &programs();
+
+    // Program with all registers and the data memory cleared
+    program_t assemble(const std::string &name, const std::string &source);
+
+    // Writes the program and its initial state. All instructions behind the program branch to themselves.
+    void load(const program_t &program, ppc_uint<32> *instruction_memory, ppc_uint<32> *data_memory,
+              registers_t &registers);
+
+    // Executes one instruction at a time until the program counter leaves the program, a trap occurs or
+    // max_instructions are retired
+    run_result_t single_step(const program_t &program, ppc_uint<32> *instruction_memory, registers_t &registers,
+                             ppc_uint<32> *data_memory, uint64_t max_instructions = 10000);
+
+    // Compares all architectural registers, including the program counter
+    bool same_registers(registers_t &a, registers_t &b);
+
+    bool same_memory(const ppc_uint<32> *a, const ppc_uint<32> *b, uint32_t size);
+
+    // Runs the program runs times through the block cache, each time from its initial state and with the number of
+    // instructions of the single step run, and requires the same stop reason, registers and memory. The cache keeps
+    // its blocks between the runs, so later runs execute blocks, which have been linked or compiled before.
+    void check_blocks(const program_t &program, block_cache &blocks, uint32_t runs = 1);
+}
+
+#endif //POWERPC_HLS_CORPUS_HPP
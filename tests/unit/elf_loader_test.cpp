@@ -0,0 +1,98 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+
+#include <catch.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "elf_loader.hpp"
+#include "corpus.hpp"
+
+namespace {
+    std::vector<char> read_file(const std::string &file_name) {
+        std::ifstream file(file_name, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void write_file(const std::string &file_name, const std::vector<char> &bytes) {
+        std::ofstream file(file_name, std::ios::binary);
+        file.write(bytes.data(), bytes.size());
+    }
+}
+
+TEST_CASE("ELF files load like their flat binaries", "[elf loader]") {
+    std::string name = GENERATE("led", "led_short");
+    std::string path = std::string(BINARIES_PATH) + "/" + name;
+    static ppc_uint<32> elf_i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> bin_i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+    std::fill(elf_i_mem, elf_i_mem + CORPUS_I_MEM_SIZE, 0);
+    std::fill(bin_i_mem, bin_i_mem + CORPUS_I_MEM_SIZE, 0);
+
+    INFO("Program " + name);
+    uint32_t entry_point = 1;
+    int32_t size = read_elf((path + ".elf").c_str(), elf_i_mem, CORPUS_I_MEM_SIZE, d_mem, CORPUS_D_MEM_SIZE,
+                            entry_point);
+    REQUIRE(size == read_byte_code((path + ".bin").c_str(), bin_i_mem, CORPUS_I_MEM_SIZE));
+    REQUIRE(size > 0);
+    REQUIRE(entry_point == 0);
+    REQUIRE(corpus::same_memory(elf_i_mem, bin_i_mem, CORPUS_I_MEM_SIZE));
+}
+
+TEST_CASE("ELF loader errors", "[elf loader]") {
+    std::string path = std::string(BINARIES_PATH) + "/led.elf";
+    std::vector<char> elf = read_file(path);
+    std::string file_name = (std::filesystem::temp_directory_path() / "powerpc_hls_elf_loader_test.elf").string();
+    static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+    uint32_t entry_point = 0;
+    REQUIRE(elf.size() > 52);
+
+    SECTION("Entry point") {
+        // The entry point is a big endian word at offset 24 of the header
+        elf[24] = 0x12;
+        elf[27] = 0x34;
+        write_file(file_name, elf);
+        REQUIRE(read_elf(file_name.c_str(), i_mem, CORPUS_I_MEM_SIZE, d_mem, CORPUS_D_MEM_SIZE, entry_point) > 0);
+        REQUIRE(entry_point == 0x12000034);
+    }
+
+    SECTION("Truncated header") {
+        elf.resize(40);
+        write_file(file_name, elf);
+        REQUIRE(read_elf(file_name.c_str(), i_mem, CORPUS_I_MEM_SIZE, d_mem, CORPUS_D_MEM_SIZE, entry_point) == -1);
+    }
+
+    SECTION("Missing file") {
+        std::filesystem::remove(file_name);
+        REQUIRE(read_elf(file_name.c_str(), i_mem, CORPUS_I_MEM_SIZE, d_mem, CORPUS_D_MEM_SIZE, entry_point) == -1);
+    }
+
+    SECTION("Instruction memory too small") {
+        int32_t size = read_elf(path.c_str(), i_mem, CORPUS_I_MEM_SIZE, d_mem, CORPUS_D_MEM_SIZE, entry_point);
+        REQUIRE(size > 1);
+        REQUIRE(read_elf(path.c_str(), i_mem, size - 1, d_mem, CORPUS_D_MEM_SIZE, entry_point) == -1);
+        REQUIRE(read_elf(path.c_str(), i_mem, size, d_mem, CORPUS_D_MEM_SIZE, entry_point) == size);
+    }
+    std::filesystem::remove(file_name);
+}
@@ -0,0 +1,83 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include <catch.hpp>
+#include <vector>
+#include "block_cache.hpp"
+#include "jit_x86.hpp"
+#include "pipeline.hpp"
+#include "corpus.hpp"
+
+// Blocks are compiled on their first execution, so the later runs execute compiled code
+TEST_CASE("JIT matches single stepping on the corpus", "[jit]") {
+    block_cache blocks(CORPUS_I_MEM_SIZE, 1);
+    for(const corpus::program_t &program : corpus::programs()) {
+        corpus::check_blocks(program, blocks, 3);
+    }
+}
+
+TEST_CASE("JIT loops and traps", "[jit]") {
+    block_cache blocks(CORPUS_I_MEM_SIZE, 1);
+    corpus::check_blocks(corpus::assemble("nested loops",
+            "li 3, 0\nli 4, 0\n"
+            "outer: li 5, 20\nmtctr 5\n"
+            "inner: add 3, 3, 5\nrlwinm 6, 3, 3, 0, 28\nxor 3, 3, 6\nbdnz inner\n"
+            "addi 4, 4, 1\ncmpwi 4, 30\nblt outer"), blocks, 3);
+    corpus::check_blocks(corpus::assemble("trap in loop", "li 3, 0\n"
+                                                          "loop: addi 3, 3, 1\ntwgei 3, 7\nb loop"), blocks, 3);
+}
+
+TEST_CASE("JIT code memory is reused", "[jit]") {
+    x86_jit jit;
+    corpus::program_t program = corpus::assemble("add", "addi 3, 3, 5\nmulli 4, 3, 3");
+    std::vector<threaded::threaded_op_t> ops;
+    for(uint32_t instruction : program.code) {
+        ops.push_back(threaded::thread(pipeline::decode(instruction)));
+    }
+
+    x86_jit::compiled_block_t first = jit.compile(0, ops, false);
+    if(first == nullptr) {
+        // The host is not supported
+        REQUIRE(jit.code_size() == 0);
+        return;
+    }
+    x86_jit::compiled_block_t second = jit.compile(0, ops, false);
+    size_t size = jit.code_size();
+
+    // Released blocks leave a gap, which is filled again
+    for(uint32_t i = 0; i < 1000; i++) {
+        jit.release(first);
+        first = jit.compile(0, ops, false);
+        REQUIRE(first != nullptr);
+        REQUIRE(jit.code_size() == size);
+    }
+
+    registers_t registers = program.registers;
+    REQUIRE(first(&registers, nullptr) == 0);
+    REQUIRE(second(&registers, nullptr) == 0);
+    REQUIRE((uint32_t) registers.GPR[3] == 10);
+    REQUIRE((uint32_t) registers.GPR[4] == 30);
+
+    // The end of the code memory shrinks once the last block is released
+    jit.release(second);
+    jit.release(first);
+    REQUIRE(jit.code_size() == 0);
+}
@@ -0,0 +1,88 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include <catch.hpp>
+#include <vector>
+#include "block_cache.hpp"
+#include "macro_op_fusion.hpp"
+#include "micro_op.hpp"
+#include "pipeline.hpp"
+#include "corpus.hpp"
+
+namespace {
+    // Contains every fused pair, the compare and branch pairs are taken and not taken
+    const char *PROGRAM =
+            "lis 3, 0x1234\nori 3, 3, 0x5678\n"
+            "li 4, 0x10\nori 4, 4, 1\n"
+            "addis 5, 0, 0\nlwz 6, 16(5)\n"
+            "rlwinm 7, 3, 4, 28, 31\ncmpwi 7, 1\n"
+            "cmpw 3, 4\nbgt greater\n"
+            "li 8, 1\n"
+            "greater: li 9, 2\n"
+            "cmplwi 7, 0\nbeq end\n"
+            "li 10, 3\n"
+            "end: rlwinm. 11, 4, 0, 24, 31\ncmplwi 11, 0x11";
+}
+
+TEST_CASE("Fused pairs", "[macro op fusion]") {
+    corpus::program_t program = corpus::assemble("fused pairs", PROGRAM);
+
+    // Pairs of instructions, which are fused
+    const uint32_t pairs[] = {0, 2, 4, 6, 8, 12};
+    for(uint32_t i : pairs) {
+        micro_op_t fused;
+        INFO("Instruction " + std::to_string(i));
+        REQUIRE(pipeline::fuse(pipeline::decode(program.code[i]), pipeline::decode(program.code[i + 1]), fused));
+        REQUIRE(micro_op::length(fused) == 2);
+    }
+
+    SECTION("Blocks match single stepping") {
+        block_cache blocks(CORPUS_I_MEM_SIZE, 0);
+        corpus::check_blocks(program, blocks, 2);
+    }
+
+    SECTION("Compiled blocks match single stepping") {
+        block_cache blocks(CORPUS_I_MEM_SIZE, 1);
+        corpus::check_blocks(program, blocks, 3);
+    }
+
+    SECTION("The budget ends inside of a fused pair") {
+        static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+        static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+        static ppc_uint<32> expected_memory[CORPUS_D_MEM_SIZE];
+        block_cache blocks(CORPUS_I_MEM_SIZE, 0);
+        for(uint64_t budget = 1; budget <= program.code.size(); budget++) {
+            registers_t expected, registers;
+            corpus::load(program, i_mem, expected_memory, expected);
+            corpus::single_step(program, i_mem, expected, expected_memory, budget);
+            corpus::load(program, i_mem, d_mem, registers);
+            run_options_t options;
+            options.max_instructions = budget;
+            options.blocks = &blocks;
+            run_result_t result = run(registers, i_mem, d_mem, options);
+
+            INFO("Budget " + std::to_string(budget));
+            REQUIRE(result.retired == budget);
+            REQUIRE(corpus::same_registers(registers, expected));
+            REQUIRE(corpus::same_memory(d_mem, expected_memory, CORPUS_D_MEM_SIZE));
+        }
+    }
+}
@@ -0,0 +1,89 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include <catch.hpp>
+#include <string>
+#include <vector>
+#include "mmio.hpp"
+#include "assembler.hpp"
+#include "test_bench_utils.hpp"
+
+namespace {
+    void execute(const std::string &source, registers_t &registers, ppc_uint<32> *data_memory) {
+        std::vector<uint32_t> code;
+        std::string error;
+        REQUIRE(assembler::assemble(source, code, error));
+        for(uint32_t instruction : code) {
+            execute_single_instruction(instruction, registers, data_memory);
+        }
+    }
+}
+
+TEST_CASE("Device regions", "[mmio]") {
+    ppc_uint<32> d_mem[256] = {};
+    registers_t registers = {};
+    uint32_t device[3] = {0x11111111, 0x22222222, 0x33333333};
+    auto read = [&device](uint32_t address, uint32_t) {
+        return device[(address & 0xFF) >> 4];
+    };
+    auto write = [&device](uint32_t address, uint32_t, uint32_t value) {
+        device[(address & 0xFF) >> 4] = value;
+    };
+
+    mmio::unmap_all();
+    REQUIRE(mmio::map(0x100, 0x20, read, write));
+    REQUIRE(mmio::map(0x200, 0x10, read, write));
+
+    SECTION("Overlapping regions are rejected") {
+        REQUIRE_FALSE(mmio::map(0x110, 0x20, read, write));
+        REQUIRE_FALSE(mmio::map(0xF0, 0x11, read, write));
+        REQUIRE_FALSE(mmio::map(0x300, 0, read, write));
+        REQUIRE(mmio::mapped_regions().size() == 2);
+        REQUIRE(mmio::map(0x120, 0x10, read, write));
+    }
+
+    SECTION("RAM between regions is not mapped") {
+        d_mem[0x180/4] = 0x78563412;
+        registers.GPR[1] = 0x180;
+        execute("lwz 3, 0(1)\nli 4, 0x55\nstb 4, 4(1)", registers, d_mem);
+        REQUIRE((uint32_t) registers.GPR[3] == 0x12345678);
+        REQUIRE((uint32_t) d_mem[0x184/4] == 0x55);
+        REQUIRE(!mmio::mapped(0x180));
+        REQUIRE(mmio::mapped(0x204));
+    }
+
+    SECTION("Multiple word accesses are split between RAM and devices") {
+        d_mem[0xF8/4] = 0x04030201;
+        registers.GPR[1] = 0xF8;
+        execute("lmw 28, 0(1)", registers, d_mem);
+        REQUIRE((uint32_t) registers.GPR[28] == 0x01020304);
+        REQUIRE((uint32_t) registers.GPR[30] == 0x11111111);
+        REQUIRE((uint32_t) registers.GPR[31] == 0x11111111);
+
+        registers.GPR[1] = 0xFC;
+        registers.GPR[29] = 0xCAFE;
+        registers.GPR[31] = 0xBEEF;
+        execute("stmw 29, 0(1)", registers, d_mem);
+        REQUIRE((uint32_t) d_mem[0xFC/4] == 0xFECA0000);
+        REQUIRE(device[0] == 0xBEEF);
+    }
+    mmio::unmap_all();
+}
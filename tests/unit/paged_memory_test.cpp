@@ -0,0 +1,240 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include <catch.hpp>
+#include <string>
+#include <vector>
+#include "paged_memory.hpp"
+#include "snapshot.hpp"
+#include "assembler.hpp"
+#include "decode_cache.hpp"
+#include "test_bench_utils.hpp"
+#include "parallel_runner.hpp"
+#include "corpus.hpp"
+
+namespace {
+    // Executes the instructions in order through the per-instruction path of the test bench
+    void execute(const std::string &source, registers_t &registers, paged_memory &memory) {
+        std::vector<uint32_t> code;
+        std::string error;
+        REQUIRE(assembler::assemble(source, code, error));
+        for(uint32_t instruction : code) {
+            execute_single_instruction(instruction, registers, memory);
+        }
+    }
+}
+
+TEST_CASE("Paged memory", "[paged memory]") {
+    registers_t registers = {};
+    paged_memory memory;
+
+    SECTION("Forks copy pages on their first write") {
+        execute("li 1, 0x1000\nli 3, 0x1234\nstw 3, 0(1)", registers, memory);
+        paged_memory fork = memory;
+        execute("li 3, 0x5678\nstw 3, 0(1)\nstw 3, 0x1000(1)", registers, fork);
+
+        execute("lwz 4, 0(1)", registers, memory);
+        REQUIRE((uint32_t) registers.GPR[4] == 0x1234);
+        execute("lwz 4, 0(1)\nlwz 5, 0x1000(1)", registers, fork);
+        REQUIRE((uint32_t) registers.GPR[4] == 0x5678);
+        REQUIRE((uint32_t) registers.GPR[5] == 0x5678);
+        REQUIRE(memory.page_count() == 1);
+        REQUIRE(fork.page_count() == 2);
+
+        // Unwritten pages read zero
+        execute("lwz 4, 0x2000(1)", registers, memory);
+        REQUIRE((uint32_t) registers.GPR[4] == 0);
+    }
+
+    SECTION("Unaligned accesses wrap around at the end of the address space") {
+        memory[PAGED_MEMORY_INDEX_MASK] = 0xBBAA0000;
+        memory[0] = 0x0000DDCC;
+        execute("li 1, -2\nlwz 3, 0(1)", registers, memory);
+        REQUIRE((uint32_t) registers.GPR[3] == 0xAABBCCDD);
+
+        execute("li 3, 0x1122\nsth 3, 1(1)", registers, memory);
+        REQUIRE((uint32_t) memory.read(PAGED_MEMORY_INDEX_MASK) == 0x11AA0000);
+        REQUIRE((uint32_t) memory.read(0) == 0x0000DD22);
+        REQUIRE(memory.page_count() == 2);
+    }
+
+    SECTION("Page size") {
+        REQUIRE(memory.page_size() == 4096);
+        REQUIRE(paged_memory(16).page_size() == 65536);
+    }
+}
+
+// run() follows the program counter on the paged memory like on a flat one
+TEST_CASE("Programs on the paged memory", "[paged memory]") {
+    static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+
+    SECTION("Corpus") {
+        decode_cache decoded;
+        for(const corpus::program_t &program : corpus::programs()) {
+            registers_t expected, registers;
+            corpus::load(program, i_mem, d_mem, registers);
+            paged_memory memory;
+            for(uint32_t i = 0; i < CORPUS_D_MEM_SIZE; i++) {
+                if((uint32_t) d_mem[i] != 0) {
+                    memory[i] = d_mem[i];
+                }
+            }
+            expected = registers;
+            run_result_t reference = corpus::single_step(program, i_mem, expected, d_mem);
+
+            INFO("Program " + program.name);
+            run_options_t options;
+            options.max_instructions = reference.retired;
+            options.decoded = &decoded;
+            decoded.invalidate_all();
+            run_result_t result = run(registers, i_mem, memory, options);
+            REQUIRE(result.retired == reference.retired);
+            REQUIRE(result.reason == reference.reason);
+            REQUIRE(corpus::same_registers(registers, expected));
+            bool same_memory = true;
+            for(uint32_t i = 0; i < CORPUS_D_MEM_SIZE; i++) {
+                same_memory &= (uint32_t) memory.read(i) == (uint32_t) d_mem[i];
+            }
+            REQUIRE(same_memory);
+        }
+    }
+
+    SECTION("Stack at the top of the address space") {
+        // The stack grows down from address 0, the data lies at 0x10000000 like in a linker layout
+        corpus::program_t program = corpus::assemble("stack", "li 1, 0\nlis 5, 0x1000\nli 3, 41\n"
+                                                              "stwu 1, -16(1)\nstw 3, 8(1)\nbl function\n"
+                                                              "lwz 6, 0(5)\nlwz 1, 0(1)\ntweqi 0, 0\n"
+                                                              "function: lwz 4, 8(1)\naddi 4, 4, 1\nstw 4, 0(5)\nblr");
+        registers_t registers;
+        corpus::load(program, i_mem, d_mem, registers);
+        paged_memory memory;
+        run_options_t options;
+        options.max_instructions = 100;
+        run_result_t result = run(registers, i_mem, memory, options);
+
+        REQUIRE(result.reason == STOP_TRAP);
+        REQUIRE((uint32_t) registers.GPR[1] == 0);
+        REQUIRE((uint32_t) registers.GPR[6] == 42);
+        // The back chain and the saved word below the top of the memory, the result in the data page
+        REQUIRE((uint32_t) memory.read(0xFFFFFFF0 >> 2) == 0);
+        REQUIRE((uint32_t) memory.read(0xFFFFFFF8 >> 2) == 0x29000000);
+        REQUIRE((uint32_t) memory.read(0x10000000 >> 2) == 0x2A000000);
+        REQUIRE(memory.page_count() == 2);
+    }
+}
+
+TEST_CASE("Snapshots", "[paged memory]") {
+    registers_t registers = {};
+    paged_memory memory;
+    execute("li 1, 0x1000\nli 3, 7\nstw 3, 0(1)\nli 4, 9", registers, memory);
+
+    registers_t saved_registers = registers;
+    machine_state_t snapshot = take_snapshot(registers, memory);
+
+    const char *program = "addi 3, 3, 1\nstw 3, 0(1)\nstw 3, 4(1)\nli 4, 100";
+    execute(program, registers, memory);
+    REQUIRE((uint32_t) memory.read(0x1000/4) == 0x08000000);
+    REQUIRE((uint32_t) memory.read(0x1004/4) == 0x08000000);
+    registers_t first_run = registers;
+
+    // The run did not change the snapshot
+    REQUIRE(corpus::same_registers(snapshot.registers, saved_registers));
+    REQUIRE((uint32_t) snapshot.memory.read(0x1000/4) == 0x07000000);
+    REQUIRE((uint32_t) snapshot.memory.read(0x1004/4) == 0);
+
+    restore_snapshot(snapshot, registers, memory);
+    REQUIRE(corpus::same_registers(registers, saved_registers));
+    REQUIRE((uint32_t) memory.read(0x1000/4) == 0x07000000);
+    REQUIRE((uint32_t) memory.read(0x1004/4) == 0);
+
+    // Running again from the restored state gives the same result and still leaves the snapshot untouched
+    execute(program, registers, memory);
+    REQUIRE(corpus::same_registers(registers, first_run));
+    memory[0x2000/4] = 0x12345678;
+    REQUIRE((uint32_t) snapshot.memory.read(0x1000/4) == 0x07000000);
+    REQUIRE((uint32_t) snapshot.memory.read(0x2000/4) == 0);
+    REQUIRE(snapshot.memory.page_count() == 1);
+}
+
+// Many runs continue from one snapshot taken after a common initialisation, serially and on several threads, which
+// copy the snapshot at the same time
+TEST_CASE("Forks of a snapshot", "[paged memory]") {
+    // The initialisation fills a table at 0x10000000 and stops with a trap, every fork adds its seed in r3 to the
+    // table entries and sums them up
+    corpus::program_t program = corpus::assemble("boot", "lis 5, 0x1000\nli 6, 0\nli 7, 64\nmtctr 7\nmr 9, 5\n"
+                                                         "fill: mulli 8, 6, 3\nstw 8, 0(9)\naddi 9, 9, 4\naddi 6, 6, 1\n"
+                                                         "bdnz fill\ntweqi 0, 0\n"
+                                                         "li 4, 0\nli 7, 64\nmtctr 7\nmr 9, 5\n"
+                                                         "sum: lwz 8, 0(9)\nadd 8, 8, 3\nstw 8, 0(9)\nadd 4, 4, 8\n"
+                                                         "addi 9, 9, 4\nbdnz sum\nstwu 4, -16(1)\ntweqi 0, 0");
+    static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+    registers_t registers;
+    corpus::load(program, i_mem, d_mem, registers);
+    paged_memory memory;
+    run_options_t options;
+    options.max_instructions = 10000;
+    REQUIRE(run(registers, i_mem, memory, options).reason == STOP_TRAP);
+    const machine_state_t snapshot = take_snapshot(registers, memory);
+
+    const uint32_t forks = 24;
+    auto seed = [](size_t fork) {
+        return (uint32_t) (fork*1000 + 1);
+    };
+    std::vector<registers_t> expected(forks);
+    std::vector<paged_memory> expected_memory(forks);
+    for(size_t i = 0; i < forks; i++) {
+        restore_snapshot(snapshot, expected[i], expected_memory[i]);
+        expected[i].GPR[3] = seed(i);
+        REQUIRE(run(expected[i], i_mem, expected_memory[i], options).reason == STOP_TRAP);
+    }
+
+    std::vector<paged_instance_t> instances(forks);
+    run_parallel(i_mem, CORPUS_I_MEM_SIZE, instances, options, 4, [&](paged_instance_t &instance) {
+        restore_snapshot(snapshot, instance.registers, instance.data_memory);
+        instance.registers.GPR[3] = seed(&instance - instances.data());
+    });
+
+    // Sum of 3*i + seed over the 64 entries
+    for(size_t i = 0; i < forks; i++) {
+        INFO("Fork " + std::to_string(i));
+        REQUIRE(instances[i].result.reason == STOP_TRAP);
+        REQUIRE(corpus::same_registers(instances[i].registers, expected[i]));
+        REQUIRE((uint32_t) instances[i].registers.GPR[4] == 3*63*64/2 + 64*seed(i));
+        bool same_memory = true;
+        for(uint32_t word = 0; word < 64; word++) {
+            same_memory &= (uint32_t) instances[i].data_memory.read((0x10000000 >> 2) + word) ==
+                           (uint32_t) expected_memory[i].read((0x10000000 >> 2) + word);
+        }
+        same_memory &= (uint32_t) instances[i].data_memory.read(0xFFFFFFF0 >> 2) ==
+                       (uint32_t) expected_memory[i].read(0xFFFFFFF0 >> 2);
+        REQUIRE(same_memory);
+        REQUIRE(instances[i].data_memory.page_count() == 2);
+    }
+
+    // The snapshot still holds the table of the initialisation
+    for(uint32_t word = 0; word < 64; word++) {
+        REQUIRE((uint32_t) snapshot.memory.read((0x10000000 >> 2) + word) ==
+                (uint32_t) memory.read((0x10000000 >> 2) + word));
+    }
+    REQUIRE(snapshot.memory.page_count() == 1);
+}
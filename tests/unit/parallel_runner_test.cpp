@@ -0,0 +1,138 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+
+#include <catch.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "mmio.hpp"
+#include "parallel_runner.hpp"
+#include "corpus.hpp"
+
+namespace {
+    const uint32_t DEVICE_ADDRESS = 0x100;
+
+    // Runs copies of the program on a few threads and compares every instance with a serial run without caches
+    void check_parallel(const corpus::program_t &program, const std::vector<registers_t> &initial,
+                        uint64_t max_instructions) {
+        static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+        static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+        registers_t registers;
+        corpus::load(program, i_mem, d_mem, registers);
+        std::vector<ppc_uint<32>> initial_memory(d_mem, d_mem + CORPUS_D_MEM_SIZE);
+
+        run_options_t options;
+        options.max_instructions = max_instructions;
+        std::vector<simulation_instance_t> instances(initial.size());
+        for(size_t i = 0; i < initial.size(); i++) {
+            instances[i].registers = initial[i];
+            instances[i].data_memory = initial_memory;
+        }
+        runner_summary_t summary = run_parallel(i_mem, CORPUS_I_MEM_SIZE, instances, options, 3);
+
+        INFO("Program " + program.name);
+        REQUIRE(summary.instances == initial.size());
+        REQUIRE(summary.threads == std::min<size_t>(3, initial.size()));
+        uint64_t total = 0;
+        for(size_t i = 0; i < initial.size(); i++) {
+            registers_t expected = initial[i];
+            std::vector<ppc_uint<32>> expected_memory = initial_memory;
+            run_result_t reference = run(expected, i_mem, expected_memory.data(), options);
+
+            INFO("Instance " + std::to_string(i));
+            REQUIRE(instances[i].result.retired == reference.retired);
+            REQUIRE(instances[i].result.reason == reference.reason);
+            REQUIRE(corpus::same_registers(instances[i].registers, expected));
+            REQUIRE(corpus::same_memory(instances[i].data_memory.data(), expected_memory.data(), CORPUS_D_MEM_SIZE));
+            total += reference.retired;
+        }
+        REQUIRE(summary.retired == total);
+    }
+}
+
+// The budget ends where single stepping leaves the program, branches to registers may leave the instruction memory
+TEST_CASE("Parallel runner matches serial runs on the corpus", "[parallel runner]") {
+    static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+    for(const corpus::program_t &program : corpus::programs()) {
+        registers_t registers;
+        corpus::load(program, i_mem, d_mem, registers);
+        run_result_t reference = corpus::single_step(program, i_mem, registers, d_mem);
+        check_parallel(program, std::vector<registers_t>(5, program.registers), reference.retired);
+    }
+}
+
+TEST_CASE("Parallel runner instances with different inputs", "[parallel runner]") {
+    corpus::program_t program = corpus::assemble("diverging loop", "li 4, 1\n"
+                                                                   "loop: mullw 4, 4, 3\naddi 3, 3, -1\n"
+                                                                   "cmpwi 3, 0\nbgt loop\n"
+                                                                   "stw 4, 8(0)\nli 5, 0\ntweqi 5, 0");
+    std::vector<registers_t> initial(17, program.registers);
+    for(size_t i = 0; i < initial.size(); i++) {
+        initial[i].GPR[3] = i % 7;
+    }
+    check_parallel(program, initial, 1000);
+}
+
+// Every instance maps its own device at the same address, more instances than threads reuse the threads
+TEST_CASE("Parallel runner device isolation", "[parallel runner]") {
+    corpus::program_t program = corpus::assemble("device", "lwz 4, 0x100(0)\naddi 4, 4, 1\nstw 4, 0x104(0)\n"
+                                                           "tweqi 0, 0");
+    static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+    registers_t registers;
+    corpus::load(program, i_mem, d_mem, registers);
+
+    const size_t count = 16;
+    std::vector<simulation_instance_t> instances(count);
+    for(simulation_instance_t &instance : instances) {
+        instance.registers = program.registers;
+        instance.data_memory.assign(d_mem, d_mem + CORPUS_D_MEM_SIZE);
+    }
+    // Written by the thread of each instance
+    std::vector<uint32_t> written(count, 0);
+    std::vector<char> mapped(count, false);
+    auto prepare = [&](simulation_instance_t &instance) {
+        size_t index = &instance - instances.data();
+        mapped[index] = mmio::map(DEVICE_ADDRESS, 8,
+                                  [index](uint32_t, uint32_t) { return (uint32_t) (index*100); },
+                                  [index, &written](uint32_t address, uint32_t, uint32_t value) {
+                                      if(address == DEVICE_ADDRESS + 4) {
+                                          written[index] = value;
+                                      }
+                                  });
+    };
+
+    // The calling thread runs instances as well, its own regions are replaced
+    mmio::unmap_all();
+    REQUIRE(mmio::map(DEVICE_ADDRESS, 8, nullptr, nullptr));
+    run_options_t options;
+    options.max_instructions = 100;
+    run_parallel(i_mem, CORPUS_I_MEM_SIZE, instances, options, 4, prepare);
+    REQUIRE(mmio::mapped_regions().empty());
+
+    for(size_t i = 0; i < count; i++) {
+        INFO("Instance " + std::to_string(i));
+        REQUIRE(mapped[i]);
+        REQUIRE(instances[i].result.reason == STOP_TRAP);
+        REQUIRE(written[i] == i*100 + 1);
+        REQUIRE((uint32_t) instances[i].registers.GPR[4] == i*100 + 1);
+    }
+}
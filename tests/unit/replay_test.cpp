@@ -0,0 +1,157 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PowerPC_HLS. If not, see <http://www.gnu.org/licenses/>.
+
+#include <catch.hpp>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include "replay.hpp"
+#include "mmio.hpp"
+#include "assembler.hpp"
+#include "block_cache.hpp"
+#include "pipeline.hpp"
+#include "corpus.hpp"
+
+#define DEVICE_ADDRESS 0x10000
+
+namespace {
+    // Adds device reads and the input in data memory word 0 up and writes the sum to the device
+    const char *PROGRAM =
+            "lis 10, 1\n"
+            "loop: lwz 3, 0(10)\n"
+            "add. 4, 4, 3\n"
+            "stw 4, 4(10)\n"
+            "lwz 5, 0(0)\n"
+            "add 4, 4, 5\n"
+            "stw 4, 8(0)\n"
+            "b loop";
+
+    void reset(registers_t &registers, ppc_uint<32> *data_memory) {
+        registers = {};
+        registers.condition_reg = 0;
+        registers.fixed_exception_reg = 0;
+        for(uint32_t i = 0; i < 64; i++) {
+            data_memory[i] = 0;
+        }
+    }
+}
+
+TEST_CASE("Record and replay", "[replay]") {
+    ppc_uint<32> i_mem[16];
+    std::vector<uint32_t> code;
+    std::string error;
+    REQUIRE(assembler::assemble(PROGRAM, code, error));
+    for(uint32_t i = 0; i < 16; i++) {
+        i_mem[i] = pipeline::swap_endianness(i < code.size() ? code[i] : 0);
+    }
+    prepare_instructions(i_mem, 16);
+
+    bool use_blocks = GENERATE(false, true);
+    block_cache blocks(16);
+    run_options_t options;
+    options.stop_on_trap = false;
+    options.blocks = use_blocks ? &blocks : nullptr;
+
+    // Record a run with a live device, which reads random values, and random inputs
+    std::mt19937 live(42);
+    uint32_t device_writes = 0;
+    mmio::unmap_all();
+    mmio::map(DEVICE_ADDRESS, 16,
+              [&live](uint32_t, uint32_t) { return (uint32_t) live(); },
+              [&device_writes](uint32_t, uint32_t, uint32_t) { device_writes++; });
+
+    ppc_uint<32> d_mem[64];
+    registers_t registers;
+    reset(registers, d_mem);
+    replay::log_t log;
+    replay::start_recording(log);
+    std::vector<registers_t> checkpoint_registers;
+    std::vector<std::vector<ppc_uint<32>>> checkpoint_memory;
+    for(uint32_t i = 0; i < 60; i++) {
+        if(i % 10 == 5) {
+            replay::checkpoint(registers, d_mem, 64);
+            checkpoint_registers.push_back(registers);
+            checkpoint_memory.emplace_back(d_mem, d_mem + 64);
+        }
+        options.max_instructions = 1 + live() % 200;
+        replay::run(registers, i_mem, d_mem, options);
+        if(live() % 3 == 0) {
+            d_mem[0] = replay::input(0, live());
+        }
+    }
+    uint64_t end = replay::position();
+    registers_t final_registers = registers;
+    std::vector<ppc_uint<32>> final_memory(d_mem, d_mem + 64);
+    replay::stop();
+    mmio::unmap_all();
+    REQUIRE(device_writes > 0);
+    REQUIRE(log.checkpoints.size() == 6);
+
+    std::string file_name = (std::filesystem::temp_directory_path() / "powerpc_hls_replay_test.log").string();
+    REQUIRE(log.save(file_name.c_str()));
+    replay::log_t loaded;
+    REQUIRE(loaded.load(file_name.c_str()));
+    std::filesystem::remove(file_name);
+    REQUIRE(loaded.regions.size() == log.regions.size());
+    REQUIRE(loaded.events.size() == log.events.size());
+    REQUIRE(loaded.checkpoints.size() == log.checkpoints.size());
+
+    // Replay without the device from the beginning and from every checkpoint
+    for(int32_t from = -1; from < (int32_t) loaded.checkpoints.size(); from++) {
+        reset(registers, d_mem);
+        replay::start_replay(loaded);
+        if(from >= 0) {
+            replay::restore(from, registers, d_mem);
+            REQUIRE(corpus::same_registers(registers, checkpoint_registers[from]));
+            REQUIRE(corpus::same_memory(d_mem, checkpoint_memory[from].data(), 64));
+        }
+        block_cache replay_blocks(16);
+        options.blocks = use_blocks ? &replay_blocks : nullptr;
+        uint32_t channel;
+        while(replay::position() < end) {
+            if(replay::input_pending(channel)) {
+                d_mem[0] = replay::input(channel, 0);
+            }
+            options.max_instructions = end - replay::position();
+            run_result_t result = replay::run(registers, i_mem, d_mem, options);
+            // A replay only stops early in front of an input
+            REQUIRE((result.retired > 0 || replay::input_pending(channel)));
+        }
+        while(replay::input_pending(channel)) {
+            d_mem[0] = replay::input(channel, 0);
+        }
+
+        INFO("Replay from checkpoint " + std::to_string(from));
+        REQUIRE_FALSE(replay::diverged());
+        REQUIRE(corpus::same_registers(registers, final_registers));
+        REQUIRE(corpus::same_memory(d_mem, final_memory.data(), 64));
+        replay::stop();
+    }
+
+    SECTION("Truncated logs fail to load") {
+        REQUIRE(log.save(file_name.c_str()));
+        std::filesystem::resize_file(file_name, std::filesystem::file_size(file_name) - 3);
+        REQUIRE_FALSE(loaded.load(file_name.c_str()));
+        REQUIRE(loaded.checkpoints.size() == log.checkpoints.size() - 1);
+        std::filesystem::remove(file_name);
+    }
+}
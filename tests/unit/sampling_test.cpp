@@ -0,0 +1,94 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+
+#include <catch.hpp>
+#include <string>
+#include <vector>
+#include "block_cache.hpp"
+#include "decode_cache.hpp"
+#include "sampling.hpp"
+#include "corpus.hpp"
+
+namespace {
+    // An arithmetic phase followed by a load and store phase over the first 256 words of the data memory
+    const char *PROGRAM =
+            "li 3, 0\nli 4, 1\nlis 8, 1\nmtctr 8\n"
+            "arithmetic: addi 3, 3, 1\nmullw 4, 4, 3\nxor 5, 5, 4\nbdnz arithmetic\n"
+            "li 7, 0\nlis 8, 1\nmtctr 8\n"
+            "memory: lwz 6, 0(7)\nadd 6, 6, 3\nstw 6, 0(7)\naddi 7, 7, 4\nandi. 7, 7, 1020\nbdnz memory\n"
+            "li 5, 0\ntweqi 5, 0";
+
+    // Estimates may differ from the measured counts by this share of all instructions
+    const double TOLERANCE = 0.01;
+}
+
+TEST_CASE("Sampled runs of a program with two phases", "[sampling]") {
+    corpus::program_t program = corpus::assemble("two phases", PROGRAM);
+    static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+    block_cache blocks(CORPUS_I_MEM_SIZE, 0);
+    decode_cache decoded;
+    registers_t registers;
+    run_options_t options;
+    options.max_instructions = 1000000;
+
+    // Reference: the whole run in the detailed mode
+    corpus::load(program, i_mem, d_mem, registers);
+    sampling::statistics_t full = {};
+    run_result_t reference = sampling::measure(registers, i_mem, d_mem, options, full);
+    registers_t final_registers = registers;
+    std::vector<ppc_uint<32>> final_memory(d_mem, d_mem + CORPUS_D_MEM_SIZE);
+    REQUIRE(reference.reason == STOP_TRAP);
+    REQUIRE(full.instructions == reference.retired);
+    REQUIRE(full.opcodes[micro_op::MUL] == 65536);
+    REQUIRE(full.opcodes[micro_op::STORE] == 65536);
+
+    sampling::sampling_options_t sampling_options;
+    sampling_options.interval = 4000;
+    sampling_options.window = 400;
+    sampling_options.run = options;
+    sampling_options.run.blocks = &blocks;
+    sampling_options.run.decoded = &decoded;
+    SECTION("Periodic") {
+        sampling_options.policy = sampling::PERIODIC;
+    }
+    SECTION("Clustered") {
+        sampling_options.policy = sampling::CLUSTERED;
+        sampling_options.clusters = 4;
+        sampling_options.data_memory_size = CORPUS_D_MEM_SIZE;
+    }
+
+    corpus::load(program, i_mem, d_mem, registers);
+    sampling::sampling_result_t sampled = sampling::run_sampled(registers, i_mem, d_mem, sampling_options);
+    INFO("Policy " + std::to_string(sampling_options.policy));
+    REQUIRE(sampled.result.retired == reference.retired);
+    REQUIRE(sampled.result.reason == STOP_TRAP);
+    REQUIRE_FALSE(sampled.samples.empty());
+    REQUIRE(sampled.estimate.instructions == full.instructions);
+    for(uint32_t i = 0; i < sampling::OPCODE_COUNT; i++) {
+        INFO("Opcode " + std::to_string(i) + " estimated " + std::to_string(sampled.estimate.opcodes[i]) +
+             ", measured " + std::to_string(full.opcodes[i]));
+        REQUIRE(std::abs((double) sampled.estimate.opcodes[i] - (double) full.opcodes[i]) <=
+                TOLERANCE * full.instructions);
+    }
+    // Clustered sampling runs the program again from its initial state, it ends in the state of the first run
+    REQUIRE(corpus::same_registers(registers, final_registers));
+    REQUIRE(corpus::same_memory(d_mem, final_memory.data(), CORPUS_D_MEM_SIZE));
+}
@@ -0,0 +1,139 @@
+// Copyright 2020 Jonas Fuhrmann. All rights reserved.
+//
+// This project is dual licensed under GNU General Public License version 3
+// and a commercial license available on request.
+//-------------------------------------------------------------------------
+// For non commercial use only:
+// This file is part of PowerPC_HLS.
+//
+// PowerPC_HLS is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PowerPC_HLS is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+
+#include <catch.hpp>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "pipeline.hpp"
+#include "trace.hpp"
+#include "corpus.hpp"
+
+namespace {
+    trace::state_t state_of(registers_t &registers) {
+        trace::state_t state;
+        state.PC = registers.program_counter;
+        for(uint32_t i = 0; i < 32; i++) {
+            state.GPR[i] = registers.GPR[i];
+        }
+        state.CR = registers.condition_reg.getCR();
+        state.XER = registers.fixed_exception_reg.getXER();
+        state.LR = registers.link_register;
+        state.CTR = registers.count_register;
+        return state;
+    }
+
+    bool same_state(const trace::state_t &a, const trace::state_t &b) {
+        return memcmp(&a, &b, sizeof(trace::state_t)) == 0;
+    }
+
+    // Traces max_instructions of the program with run(), reads the trace back and compares every record with the
+    // instructions executed one by one without a trace
+    void check_round_trip(const corpus::program_t &program, uint64_t max_instructions, uint32_t buffer_size) {
+        static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+        static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+        static ppc_uint<32> expected_memory[CORPUS_D_MEM_SIZE];
+        std::string file_name = (std::filesystem::temp_directory_path() / "powerpc_hls_trace_test.trc").string();
+
+        registers_t registers;
+        corpus::load(program, i_mem, d_mem, registers);
+        trace::state_t initial = state_of(registers);
+        REQUIRE(trace::start(file_name.c_str(), registers, buffer_size));
+        REQUIRE(trace::active());
+        run_options_t options;
+        options.max_instructions = max_instructions;
+        options.stop_on_trap = false;
+        REQUIRE(run(registers, i_mem, d_mem, options).retired == max_instructions);
+        trace::stop();
+        REQUIRE_FALSE(trace::active());
+
+        trace::reader reader;
+        REQUIRE(reader.open(file_name.c_str()));
+        REQUIRE(same_state(reader.initial_state(), initial));
+
+        // The memory of the trace is rebuilt from the stored words
+        registers_t expected;
+        corpus::load(program, i_mem, expected_memory, expected);
+        std::vector<uint32_t> traced_memory(CORPUS_D_MEM_SIZE);
+        for(uint32_t i = 0; i < CORPUS_D_MEM_SIZE; i++) {
+            traced_memory[i] = __builtin_bswap32((uint32_t) expected_memory[i]);
+        }
+
+        options.max_instructions = 1;
+        options.stop_on_trap = true;
+        trace::record_t record;
+        for(uint64_t i = 0; i < max_instructions; i++) {
+            INFO("Instruction " + std::to_string(i));
+            uint32_t program_counter = expected.program_counter;
+            uint32_t instruction = pipeline::fetch_index(i_mem, program_counter >> 2);
+            bool trap = run(expected, i_mem, expected_memory, options).reason == STOP_TRAP;
+            trace::state_t state = state_of(expected);
+            state.PC = program_counter;
+
+            REQUIRE(reader.next(record));
+            REQUIRE(record.program_counter == program_counter);
+            REQUIRE(record.instruction == instruction);
+            REQUIRE(record.trap == trap);
+            REQUIRE(same_state(record.state, state));
+            for(size_t word = 0; word < record.memory_words.size(); word++) {
+                traced_memory[(record.memory_address >> 2) + word] = record.memory_words[word];
+            }
+            bool same_memory = true;
+            for(uint32_t word = 0; word < CORPUS_D_MEM_SIZE; word++) {
+                same_memory &= traced_memory[word] == __builtin_bswap32((uint32_t) expected_memory[word]);
+            }
+            REQUIRE(same_memory);
+        }
+        REQUIRE_FALSE(reader.next(record));
+        std::filesystem::remove(file_name);
+    }
+
+    // Each iteration stores 29 registers, so the records are close to their maximum size
+    const char *STORE_LOOP = "li 3, 0\nli 4, 100\nmtctr 4\n"
+                             "loop: addi 3, 3, 1\nmulli 5, 3, 7\nstmw 3, 64(0)\nlwz 6, 64(0)\ncmpwi 3, 50\nbdnz loop\n"
+                             "tweqi 0, 0";
+}
+
+TEST_CASE("Trace round trip", "[trace]") {
+    corpus::program_t program = corpus::assemble("store loop", STORE_LOOP);
+    // The loop, the trap and the branches to themselves behind the program
+    check_round_trip(program, 1000, trace::TRACE_BUFFER_SIZE);
+
+    static ppc_uint<32> i_mem[CORPUS_I_MEM_SIZE];
+    static ppc_uint<32> d_mem[CORPUS_D_MEM_SIZE];
+    for(const corpus::program_t &corpus_program : corpus::programs()) {
+        registers_t registers;
+        corpus::load(corpus_program, i_mem, d_mem, registers);
+        run_result_t reference = corpus::single_step(corpus_program, i_mem, registers, d_mem);
+        INFO("Program " + corpus_program.name);
+        check_round_trip(corpus_program, reference.retired, trace::TRACE_BUFFER_SIZE);
+    }
+}
+
+// A buffer of a few records fills up after some instructions, the simulation waits for the writer thread,
+// which empties the buffer again and wraps around it many times
+TEST_CASE("Trace ring buffer full and empty", "[trace]") {
+    corpus::program_t program = corpus::assemble("store loop", STORE_LOOP);
+    check_round_trip(program, 1000, 1024);
+
+    // Nothing is recorded, the writer finds the buffer empty except for the header
+    check_round_trip(program, 0, 1024);
+}